@@ -5,6 +5,12 @@
 
 #define MOTOR_TIMER_FREQ 100000 // [Hz]
 #define THRESV 650 // This is the speed under which the power save feature is active.
+#define MOTOR_HALT_INTERVAL 1000 // The motors get updated at 100Hz when not used
+#define MOTOR_MIN_SPEED 150 // [step/s] The motors start and stop instantly under this speed
+#define MOTOR_LOWEST_SPEED ((MOTOR_TIMER_FREQ + 0xFFFF - 1) / 0xFFFF) // [step/s] Its interval still fits the 16 bits timer
+#define SPEED_FRACTION_BITS 8 // Fixed point of the profile speed
+#define PROFILE_RATIO_ONE 256 // Ratio applied to the profile of one motor, 256 means 1
+#define TIMER_TICK_US (1000000 / MOTOR_TIMER_FREQ) // [us] Duration of one timer tick
 
 static const uint8_t step_halt[4] = {0, 0, 0, 0};
 //table of the differents steps of to control the motors
@@ -31,11 +37,27 @@ struct stepper_motor_s {
     void (*enable_power_save)(void);
     void (*disable_power_save)(void);
     PWMDriver *timer;
+    /* velocity profile, updated by the timer callback */
+    int32_t speed;          // current speed [step/s << SPEED_FRACTION_BITS], signed
+    int32_t acceleration;   // current acceleration [step/s^2], positive
+    int32_t target_speed;   // [step/s], signed
+    int32_t target_pos;     // position to reach in position mode [step], forward is positive
+    int32_t max_speed;      // cruise speed in position mode [step/s]
+    int8_t count_sign;      // +1 if the counter increases when going forward
+    int32_t profile_ratio;  // scales acceleration, jerk and min speed [1/PROFILE_RATIO_ONE]
+    bool position_mode;
+    bool power_save;
+    eventflags_t done_flag; // flag broadcasted at the end of a position move
 };
 
 struct stepper_motor_s right_motor;
 struct stepper_motor_s left_motor;
 
+event_source_t motors_event;
+
+static int32_t profile_acceleration = 0; // [step/s^2], 0 disables the profile
+static int32_t profile_jerk = 0;         // [step/s^3], 0 means no jerk limit
+
 /***************************INTERNAL FUNCTIONS************************************/
 
  /**
@@ -74,6 +96,8 @@ static void left_motor_update(const uint8_t *out)
  * @param[in] gptp       pointer of the PWM driver (not used)
  *
  */
+static void motor_profile_update(struct stepper_motor_s *m);
+
 static void right_motor_timer_callback(PWMDriver *gptp)
 {
     (void) gptp;
@@ -91,6 +115,7 @@ static void right_motor_timer_callback(PWMDriver *gptp)
     } else {
         right_motor.update(step_halt);
     }
+    motor_profile_update(&right_motor);
 }
 
  /**
@@ -116,6 +141,7 @@ static void left_motor_timer_callback(PWMDriver *gptp)
     } else {
         left_motor.update(step_halt);
     }
+    motor_profile_update(&left_motor);
 }
 
  /**
@@ -198,11 +224,13 @@ void motor_set_speed(struct stepper_motor_s *m, int speed)
     }
 
     uint16_t interval;
+    m->speed = speed << SPEED_FRACTION_BITS; // keeps the profile coherent if it is enabled later
     if (speed == 0) {
         m->direction = HALT;
         //Resolves a problem when the motors take about 650ms to restart
-        interval = 1000;    //so the motors get updated at 100Hz when not used
+        interval = MOTOR_HALT_INTERVAL;    //so the motors get updated at 100Hz when not used
         m->disable_power_save();
+        m->power_save = false;
     } else {
         if (speed > 0) {
             m->direction = FORWARD;
@@ -210,6 +238,9 @@ void motor_set_speed(struct stepper_motor_s *m, int speed)
             m->direction = BACKWARD;
             speed = -speed;
         }
+        if (speed < MOTOR_LOWEST_SPEED) {
+            speed = MOTOR_LOWEST_SPEED;
+        }
         interval = MOTOR_TIMER_FREQ / speed;
 
         if(speed < THRESV) {
@@ -217,23 +248,268 @@ void motor_set_speed(struct stepper_motor_s *m, int speed)
         } else {
         	m->disable_power_save();
         }
+        m->power_save = (speed < THRESV);
     }
 
     /* change motor step interval */
     pwmChangePeriod(m->timer, interval);
 }
 
+/**
+ * @brief   Applies a speed to a motor from the timer callback (I-class)
+ *
+ * @param m         pointer to the motor. See stepper_motor_s
+ * @param speed     speed in step/s, already limited
+ */
+static void motor_apply_speed_i(struct stepper_motor_s *m, int32_t speed)
+{
+    uint16_t interval;
+    bool power_save = false;
+    if (speed == 0) {
+        m->direction = HALT;
+        interval = MOTOR_HALT_INTERVAL;
+    } else {
+        if (speed > 0) {
+            m->direction = FORWARD;
+        } else {
+            m->direction = BACKWARD;
+            speed = -speed;
+        }
+        if (speed < MOTOR_LOWEST_SPEED) {
+            speed = MOTOR_LOWEST_SPEED;
+        }
+        interval = MOTOR_TIMER_FREQ / speed;
+        power_save = (speed < THRESV);
+    }
+
+    if (power_save != m->power_save) {
+        if (power_save) {
+            pwmEnableChannelI(m->timer, 0, (pwmcnt_t) (MOTOR_TIMER_FREQ/THRESV));
+            pwmEnableChannelNotificationI(m->timer, 0);
+        } else {
+            pwmDisableChannelI(m->timer, 0);
+        }
+        m->power_save = power_save;
+    }
+    pwmChangePeriodI(m->timer, interval);
+}
+
+/**
+ * @brief   Moves the speed of a motor toward its target with a limited
+ *          acceleration and jerk (S-curve). Called at each step by the timer.
+ *          In position mode the target speed becomes the minimal speed
+ *          when the motor must brake to stop on the position.
+ *
+ * @param m         pointer to the motor. See stepper_motor_s
+ */
+static void motor_profile_update(struct stepper_motor_s *m)
+{
+    if (profile_acceleration == 0 && !m->position_mode) {
+        return; // speed set directly by motor_set_speed
+    }
+
+    chSysLockFromISR();
+    int32_t current = m->speed >> SPEED_FRACTION_BITS;
+    int32_t target = m->target_speed;
+
+    // a slower motor of a synchronized move uses a scaled copy of the profile
+    int32_t acceleration_limit = profile_acceleration * m->profile_ratio / PROFILE_RATIO_ONE;
+    int32_t jerk_limit = profile_jerk * m->profile_ratio / PROFILE_RATIO_ONE;
+    int32_t min_speed = MOTOR_MIN_SPEED * m->profile_ratio / PROFILE_RATIO_ONE;
+    if (min_speed < MOTOR_LOWEST_SPEED) {
+        min_speed = MOTOR_LOWEST_SPEED;
+    }
+
+    if (m->position_mode) {
+        int32_t remaining = m->target_pos - m->count * m->count_sign;
+        if (remaining == 0) {
+            m->position_mode = false;
+            m->target_speed = 0;
+            m->speed = 0;
+            m->acceleration = 0;
+            motor_apply_speed_i(m, 0);
+            eventflags_t flags = m->done_flag;
+            if (!left_motor.position_mode && !right_motor.position_mode) {
+                flags |= MOTORS_EVENT_MOVE_DONE;
+            }
+            chEvtBroadcastFlagsI(&motors_event, flags);
+            chSysUnlockFromISR();
+            return;
+        }
+        int32_t sign = (remaining > 0) ? 1 : -1;
+        int32_t braking = 0;
+        if (acceleration_limit > 0) {
+            braking = current * current / (2 * acceleration_limit);
+            if (jerk_limit > 0) {
+                braking += (current < 0 ? -current : current) * acceleration_limit / jerk_limit;
+            }
+        }
+        target = (remaining * sign <= braking) ? sign * min_speed : sign * m->max_speed;
+    }
+
+    // the direction only changes once the motor is stopped
+    int32_t phase_target = target;
+    if (target != 0 && current != 0 && (target > 0) != (current > 0)) {
+        phase_target = 0;
+    }
+
+    if (acceleration_limit == 0) {
+        m->speed = phase_target << SPEED_FRACTION_BITS;
+    } else {
+        int32_t difference = (phase_target << SPEED_FRACTION_BITS) - m->speed;
+        int32_t dt_us = (int32_t) m->timer->period * TIMER_TICK_US;
+        if (difference == 0) {
+            m->acceleration = 0;
+        } else {
+            int32_t gap = (difference > 0 ? difference : -difference) >> SPEED_FRACTION_BITS;
+            if (jerk_limit == 0) {
+                m->acceleration = acceleration_limit;
+            } else {
+                // the acceleration decreases before the target so the speed joins it smoothly
+                int32_t jerk_step = (int32_t) ((int64_t) jerk_limit * dt_us / 1000000);
+                if ((int64_t) gap * 2 * jerk_limit <= (int64_t) m->acceleration * m->acceleration) {
+                    m->acceleration -= jerk_step;
+                } else {
+                    m->acceleration += jerk_step;
+                }
+                if (m->acceleration > acceleration_limit) {
+                    m->acceleration = acceleration_limit;
+                } else if (m->acceleration < acceleration_limit / 16) {
+                    m->acceleration = acceleration_limit / 16;
+                }
+            }
+            int32_t change = (int32_t) (((int64_t) m->acceleration * dt_us << SPEED_FRACTION_BITS) / 1000000);
+            if (change >= (difference > 0 ? difference : -difference)) {
+                m->speed = phase_target << SPEED_FRACTION_BITS;
+            } else {
+                m->speed += (difference > 0) ? change : -change;
+            }
+        }
+    }
+
+    // steppers start and stop instantly at low speed
+    current = m->speed >> SPEED_FRACTION_BITS;
+    if ((current < 0 ? -current : current) < min_speed) {
+        if (phase_target == 0) {
+            current = 0;
+        } else {
+            current = (phase_target > 0) ? min_speed : -min_speed;
+        }
+        m->speed = current << SPEED_FRACTION_BITS;
+    }
+    motor_apply_speed_i(m, current);
+    chSysUnlockFromISR();
+}
+
+/**
+ * @brief   Starts a move of a number of steps with the profile, called with the system locked
+ *
+ * @param m         pointer to the motor. See stepper_motor_s
+ * @param steps     number of steps to do, positive forward
+ * @param speed     cruise speed in step/s
+ * @param ratio     scale of the profile limits, PROFILE_RATIO_ONE for the full profile
+ */
+static void motor_move_steps_i(struct stepper_motor_s *m, int32_t steps, int speed, int32_t ratio)
+{
+    if (speed < 0) {
+        speed = -speed;
+    }
+    if (speed > MOTOR_SPEED_LIMIT) {
+        speed = MOTOR_SPEED_LIMIT;
+    } else if (speed < MOTOR_LOWEST_SPEED) {
+        speed = MOTOR_LOWEST_SPEED;
+    }
+
+    // a move of 0 steps is finished by the next timer callback
+    m->target_pos = m->count * m->count_sign + steps;
+    m->max_speed = speed;
+    m->profile_ratio = (ratio < 1) ? 1 : ratio;
+    m->position_mode = true;
+}
+
+/**
+ * @brief   Leaves the position mode of a motor. The waiters of a running
+ *          move are told it is cancelled, else they would wait forever.
+ *
+ * @param m         pointer to the motor. See stepper_motor_s
+ */
+static void motor_cancel_move(struct stepper_motor_s *m)
+{
+    chSysLock();
+    if (m->position_mode) {
+        m->position_mode = false;
+        chEvtBroadcastFlagsI(&motors_event, m->done_flag | MOTORS_EVENT_MOVE_CANCELLED);
+        chSchRescheduleS();
+    }
+    chSysUnlock();
+}
+
 /*************************END INTERNAL FUNCTIONS**********************************/
 
 
 /****************************PUBLIC FUNCTIONS*************************************/
 
 void right_motor_set_speed(int speed) {
-	motor_set_speed(&right_motor, speed);
+	motor_cancel_move(&right_motor);
+	right_motor.profile_ratio = PROFILE_RATIO_ONE;
+	if (profile_acceleration == 0) {
+		motor_set_speed(&right_motor, speed);
+	} else {
+		right_motor.target_speed = speed;
+	}
 }
 
 void left_motor_set_speed(int speed) {
-	motor_set_speed(&left_motor, speed);
+	motor_cancel_move(&left_motor);
+	left_motor.profile_ratio = PROFILE_RATIO_ONE;
+	if (profile_acceleration == 0) {
+		motor_set_speed(&left_motor, speed);
+	} else {
+		left_motor.target_speed = speed;
+	}
+}
+
+void right_motor_move_steps(int32_t steps, int speed) {
+	chSysLock();
+	motor_move_steps_i(&right_motor, steps, speed < MOTOR_MIN_SPEED ? MOTOR_MIN_SPEED : speed, PROFILE_RATIO_ONE);
+	chSysUnlock();
+}
+
+void left_motor_move_steps(int32_t steps, int speed) {
+	chSysLock();
+	motor_move_steps_i(&left_motor, steps, speed < MOTOR_MIN_SPEED ? MOTOR_MIN_SPEED : speed, PROFILE_RATIO_ONE);
+	chSysUnlock();
+}
+
+void motors_move_steps(int32_t left, int32_t right, int max_speed) {
+	int32_t left_abs = (left < 0) ? -left : left;
+	int32_t right_abs = (right < 0) ? -right : right;
+	int32_t longest = (left_abs > right_abs) ? left_abs : right_abs;
+	if (longest == 0) {
+		longest = 1;
+	}
+	if (max_speed < MOTOR_MIN_SPEED) {
+		max_speed = MOTOR_MIN_SPEED;
+	}
+
+	// both profiles are scaled copies of each other, so both motors arrive together
+	int32_t left_ratio = (int32_t) ((int64_t) left_abs * PROFILE_RATIO_ONE / longest);
+	int32_t right_ratio = (int32_t) ((int64_t) right_abs * PROFILE_RATIO_ONE / longest);
+	chSysLock();
+	motor_move_steps_i(&left_motor, left, (int32_t) ((int64_t) max_speed * left_abs / longest), left_ratio);
+	motor_move_steps_i(&right_motor, right, (int32_t) ((int64_t) max_speed * right_abs / longest), right_ratio);
+	chSysUnlock();
+}
+
+bool motors_is_moving(void) {
+	return left_motor.position_mode || right_motor.position_mode;
+}
+
+void motors_set_profile(int32_t acceleration, int32_t jerk) {
+	chSysLock();
+	profile_acceleration = (acceleration > 0) ? acceleration : 0;
+	profile_jerk = (jerk > 0) ? jerk : 0;
+	chSysUnlock();
 }
 
 uint32_t right_motor_get_pos(void) {
@@ -254,6 +530,9 @@ void motors_init(void)
     right_motor.enable_power_save = right_motor_enable_power_save;
     right_motor.disable_power_save = right_motor_disable_power_save;
     right_motor.timer = &PWMD3;
+    right_motor.count_sign = -1; // the counter decreases when going forward
+    right_motor.profile_ratio = PROFILE_RATIO_ONE;
+    right_motor.done_flag = MOTORS_EVENT_RIGHT_DONE;
 
     left_motor.direction = HALT;
     left_motor.step_index = 0;
@@ -262,6 +541,11 @@ void motors_init(void)
     left_motor.enable_power_save = left_motor_enable_power_save;
     left_motor.disable_power_save = left_motor_disable_power_save;
     left_motor.timer = &PWMD4;
+    left_motor.count_sign = 1;
+    left_motor.profile_ratio = PROFILE_RATIO_ONE;
+    left_motor.done_flag = MOTORS_EVENT_LEFT_DONE;
+
+    chEvtObjectInit(&motors_event);
 
     /* motor init halted*/
     right_motor_update(step_halt);
@@ -6,15 +6,25 @@
 
 #define MOTOR_SPEED_LIMIT 2200 // [step/s]
 
+#define MOTORS_EVENT_LEFT_DONE  (1 << 0) // flags broadcasted at the end of a move
+#define MOTORS_EVENT_RIGHT_DONE (1 << 1)
+#define MOTORS_EVENT_MOVE_DONE  (1 << 2) // both motors reached their position
+#define MOTORS_EVENT_MOVE_CANCELLED (1 << 3) // a speed was set before the end of a move
+
+/** Broadcasted each time a motor finishes or cancels a move started with *_move_steps */
+extern event_source_t motors_event;
+
  /**
- * @brief   Sets the speed of the left motor
+ * @brief   Sets the speed of the left motor, a running move of the motor
+ *          is cancelled and MOTORS_EVENT_MOVE_CANCELLED is broadcasted
  * 
  * @param speed     speed desired in step/s
  */
 void left_motor_set_speed(int speed);
 
  /**
- * @brief   Sets the speed of the right motor
+ * @brief   Sets the speed of the right motor, a running move of the motor
+ *          is cancelled and MOTORS_EVENT_MOVE_CANCELLED is broadcasted
  * 
  * @param speed     speed desired in step/s
  */
@@ -34,6 +44,51 @@ uint32_t left_motor_get_pos(void);
  */
 uint32_t right_motor_get_pos(void);
 
+ /**
+ * @brief   Moves the left motor of a number of steps, the speed follows
+ *          the profile and the motor stops exactly on the position
+ * 
+ * @param steps     number of steps, positive forward
+ * @param speed     cruise speed in step/s
+ */
+void left_motor_move_steps(int32_t steps, int speed);
+
+ /**
+ * @brief   Moves the right motor of a number of steps, the speed follows
+ *          the profile and the motor stops exactly on the position
+ * 
+ * @param steps     number of steps, positive forward
+ * @param speed     cruise speed in step/s
+ */
+void right_motor_move_steps(int32_t steps, int speed);
+
+ /**
+ * @brief   Moves both motors of a number of steps. The motor with the shortest
+ *          move follows a scaled profile so both motors arrive at the same time,
+ *          then MOTORS_EVENT_MOVE_DONE is broadcasted.
+ * 
+ * @param left      number of steps of the left motor, positive forward
+ * @param right     number of steps of the right motor, positive forward
+ * @param max_speed cruise speed of the motor with the longest move in step/s
+ */
+void motors_move_steps(int32_t left, int32_t right, int max_speed);
+
+ /**
+ * @brief   Tells if a move started with *_move_steps is running
+ * 
+ * @return          true until both motors reached their position
+ */
+bool motors_is_moving(void);
+
+ /**
+ * @brief   Sets the limits of the velocity profile used by both motors.
+ *          Speed changes are applied progressively by the timer callbacks.
+ * 
+ * @param acceleration  max acceleration in step/s^2, 0 to apply speeds instantly
+ * @param jerk          max jerk in step/s^3, 0 for a trapezoidal profile
+ */
+void motors_set_profile(int32_t acceleration, int32_t jerk);
+
  /**
  * @brief   Initializes the control of the motors.
  */
@@ -50,7 +50,8 @@ static THD_FUNCTION(VL53L0XThd, arg) {
    			dist_mm = device.Data.LastRangeMeasure.RangeMilliMeter;
             chBSemSignal(&tofNewDatas);
     	}
-		chThdSleepMilliseconds(100);
+		//the long range timing budget is 33ms, polling faster gives the same measure twice
+		chThdSleepMilliseconds(33);
     
     }
 }
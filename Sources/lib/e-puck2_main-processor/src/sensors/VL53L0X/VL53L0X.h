@@ -15,6 +15,9 @@
 
 #define VL53L0X_ADDR 0x52
 
+/** Signaled each time a new distance is available */
+extern binary_semaphore_t tofNewDatas;
+
 //////////////////// PROTOTYPES PUBLIC FUNCTIONS /////////////////////
 
 /**
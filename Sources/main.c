@@ -27,10 +27,15 @@
 #include "mod_audio.h"
 #include "mod_exploration.h"
 #include "mod_communication.h"
+#include "mod_log.h"
+#include "mod_motors.h"
 
 // Temporary
 #include "mod_mapping.h"
 
+#define FACING_ROTATION_SPEED   0.4f    // rad/s
+#define COMMUNICATION_LINK      TRANSPORT_AUTO
+
 // Semaphores
 BSEMAPHORE_DECL(sem_wip, true);
 
@@ -43,14 +48,14 @@ void initSystem(void){
     chSysInit();
     
     mod_audio_initModule();
-    mod_com_initModule();
+    mod_com_initModule(COMMUNICATION_LINK);
     mod_explo_initModule();
 }
 
 
 void exploration(void){
     mod_basicIO_changeRobotState(WIP);
-    mod_com_writeMessage("Will explore the area", 3);
+    LOG_INFO(FMT_WILL_EXPLORE);
     
     mod_audio_launchMelodyOnThread(MUS_EXPLORATION, REPEAT);
 
@@ -63,7 +68,7 @@ void exploration(void){
 
 void discovering(void){
     mod_basicIO_changeRobotState(WIP);
-    mod_com_writeMessage("Will discover the area", 3);
+    LOG_INFO(FMT_WILL_DISCOVER);
     
     history=  (history_t){false , false};
     mod_audio_launchMelodyOnThread(MUS_DISCOVERING, REPEAT);
@@ -75,7 +80,13 @@ void discovering(void){
 
 void song(void){
     mod_basicIO_changeRobotState(WIP);
-    mod_com_writeMessage("Will launch a melody", 3);
+    LOG_INFO(FMT_WILL_SING);
+    
+    // Sing in front of the operator
+    float direction;
+    if(mod_audio_getOperatorDirection(&direction)){
+        mod_motors_moveAndWait(0, direction, FACING_ROTATION_SPEED*ROBOT_RADIUS);
+    }
     
     mod_audio_launchMelodyOnThread(MUS_SONG, SINGLE);
     mod_audio_waitUntilMelodyEnd();
@@ -84,7 +95,7 @@ void song(void){
 
 void sendMap(void){
     mod_basicIO_changeRobotState(WIP);
-    mod_com_writeMessage("Will send the map", 3);
+    LOG_INFO(FMT_WILL_SEND_MAP);
     
     mod_explo_sendTheMap();
 }
@@ -159,7 +170,7 @@ int main(void)
 {
     initSystem();
     
-    mod_com_writeMessage("Basic init OK", 4);
+    LOG_INFO(FMT_BASIC_INIT);
     
     chThdSleepMilliseconds(600);
     
@@ -168,10 +179,10 @@ int main(void)
     while (1) {
 
         mod_basicIO_changeRobotState(WAITING);
-        mod_com_writeMessage("Robot is waiting", 3);
+        LOG_INFO(FMT_ROBOT_WAITING);
         needAudio = true;
         chBSemWait(&mod_audio_sem_commandAvailable);
-        mod_com_writeMessage("Action was detected", 3);
+        LOG_INFO(FMT_ACTION_DETECTED);
         actionChoice();
         
         mod_audio_processedCommand = NOTHING;
@@ -93,6 +93,15 @@ void mod_audio_listenForSound(void);
  */
 void  mod_audio_waitUntilMelodyEnd(void);
 
+/**
+ * @brief Returns the direction of the last located sound, usually the operator who gave the command
+ *
+ * @param[in] angle     Where to store the direction relative to the front of the robot (in rad, positive to the left)
+ *
+ * @param[out]      False if no sound was located recently (BEAM_DIRECTION_MAX_AGE)
+ */
+bool mod_audio_getOperatorDirection(float * angle);
+
 
 
 #endif
@@ -0,0 +1,55 @@
+/*
+ * File : mod_beamforming.h
+ * Project : e_puck_project
+ * Description : Module that combines the four microphones (delay and sum) and estimates the direction of a sound (GCC-PHAT)
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_BEAMFORMING_
+#define _MOD_BEAMFORMING_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BEAM_NUMBER_OF_MICS         4       // Interleaved as right, left, back, front
+#define BEAM_DOA_FFT_SIZE           256     // Samples of each microphone for a direction estimate (16 ms at 16 kHz)
+#define BEAM_DOA_DIRECTIONS         72      // Tested directions around the robot (5°)
+#define BEAM_DIRECTION_MAX_AGE      2000    // Time after which a direction is forgotten (in ms)
+#define BEAM_FOLLOW_DOA             1       // Steer the beam to the last estimated direction
+
+/**
+ * @brief Initialize the FFT and the tables of delays, the beam is steered to the front
+ */
+void mod_beam_init(void);
+
+/**
+ * @brief Process a buffer of the microphones, the direction is estimated each time a frame is complete
+ *
+ * @param[in] data          The interleaved samples of the four microphones
+ * @param[in] numSamples    The number of values in data (4 per instant)
+ * @param[in] beam          Where to store the output of the beamformer, numSamples/4 values
+ *                          at the same scale as one microphone
+ *
+ * @param[out]      True if a new direction was estimated
+ */
+bool mod_beam_process(const int16_t * data, uint16_t numSamples, float * beam);
+
+/**
+ * @brief Steer the beamformer to a direction
+ *
+ * @param[in] angle     The direction relative to the front of the robot (in rad, positive to the left)
+ */
+void mod_beam_steer(float angle);
+
+/**
+ * @brief Returns the last direction estimated from a loud enough sound, if it is recent
+ *
+ * @param[in] angle     Where to store the direction relative to the front of the robot (in rad, positive to the left)
+ *
+ * @param[out]      False if no sound was located in the last BEAM_DIRECTION_MAX_AGE ms
+ */
+bool mod_beam_getDirection(float * angle);
+
+#endif
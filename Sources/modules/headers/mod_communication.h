@@ -13,22 +13,104 @@
 
 
 #include <stdlib.h>
+#include <stdint.h>
+
+#include "mod_mapping.h"
+#include "mod_compression.h"
+#include "mod_transport.h"
+
+#define COM_CHUNK_SIZE              1024    // Bytes of data in a datagram, bigger datas are cut in chunks
+#define COM_MESSAGE_SIZE            80      // Bytes of a queued message, longer logs are cut
+
+/**
+ * @brief Types of the messages
+ * @details Each message is a serial datagram (SLIP framing + CRC32) that contains a MessagePack
+ *          array, its first element is the type and the next ones are the fields :
+ *              MSG_LOG         [type, level, text]
+ *              MSG_COMMAND     [type, command]
+ *              MSG_POSE        [type, x, y, theta]
+ *              MSG_WALLS       [type, x, y, x, y, ...] (corners of the area, in order)
+ *              MSG_OBJECT      [type, x, y]
+ *              MSG_SCAN        [type, x, y, kind]
+ *              MSG_IMAGE       [type, transfer, x, y, codec, chunk number, total size, chunk]
+ *              MSG_DATA        [type, transfer, name, chunk number, total size, chunk]
+ *              MSG_LOG_RECORDS [type, [format, time, arguments...], ...] (see mod_log.h)
+ *          The computer acknowledges the chunks of pictures and datas (see mod_reliable.h) :
+ *              MSG_ACK         [type, transfer, number of chunks received in a row]
+ *              MSG_NACK        [type, transfer, lost chunk number]
+ */
+typedef enum{
+    MSG_LOG=0,
+    MSG_COMMAND,
+    MSG_POSE,
+    MSG_WALLS,
+    MSG_OBJECT,
+    MSG_SCAN,
+    MSG_IMAGE,
+    MSG_DATA,
+    MSG_LOG_RECORDS,
+    MSG_ACK,
+    MSG_NACK
+}comMessage_t;
 
 typedef enum{
     SEND_MAP,
 }cmd_t;
 
+/**
+ * @brief Priority lanes of the transmission, the first ones are sent first
+ * @details     COM_LANE_CONTROL    Commands, walls and objects, new messages are dropped when full
+ *              COM_LANE_TELEMETRY  Poses and scan points, the oldest message is dropped when full
+ *              COM_LANE_LOG        Logs, new messages are dropped when full, the log records
+ *                                  of mod_log are sent in batches after them
+ *              COM_LANE_BULK       Pictures and datas, one transfer at a time, the sender waits.
+ *                                  Chunks are sent again until the computer acknowledges them
+ */
+typedef enum{
+    COM_LANE_CONTROL=0,
+    COM_LANE_TELEMETRY,
+    COM_LANE_LOG,
+    COM_LANE_BULK,
+    COM_NUMBER_OF_LANES
+}comLane_t;
 
 /**
- * @brief Initialize the serial connexion to be able to send datas
+ * @brief Statistics of a lane since the init
  */
-void mod_com_initModule(void);
+typedef struct{
+    uint32_t posted;
+    uint32_t sent;
+    uint32_t dropped;
+    uint32_t waits;         // Times a sender had to wait (bulk lane)
+    uint32_t retransmitted; // Chunks sent again (bulk lane)
+    uint16_t maxPending;    // Highest number of messages waiting in the lane
+}comLaneStats_t;
 
 /**
- * @brief Write some datas on the serial port
- * @details It introduce a header with datas size & communication title
+ * @brief Kinds of points of a scan
+ */
+typedef enum{
+    SCAN_CLOSEST=0,
+    SCAN_ENVIRONMENT
+}scanKind_t;
+
+
+/**
+ * @brief Initialize the link and start the transmission and reception threads
+ * @note    All the functions below only queue the message and never wait for the link,
+ *          except the bulk ones when a transfer is already running. Messages sent before the
+ *          init are dropped
+ *
+ * @param[in] link      The link to the computer (see mod_transport.h)
+ */
+void mod_com_initModule(transportLink_t link);
+
+/**
+ * @brief Write some datas on the serial port, in chunks of COM_CHUNK_SIZE bytes
+ * @note The transfer is dropped if the computer stops acknowledging the chunks
+ * @note The datas are not copied, they must not change until mod_com_waitBulkEnd returns
  *
- * @param[in] type          The title of the content that will be send (image...)
+ * @param[in] type          The title of the content that will be send
  * @param[in] toWrite       A pointer to the datas that need to be send
  * @param[in] toWriteSize   The size of the data to send. If the datas have a end
  *                          character it can be 0.
@@ -50,4 +132,59 @@ void mod_com_writeMessage(char* message, int level);
  */
 void mod_com_writeCommand(cmd_t order);
 
+/**
+ * @brief Send the pose of the robot
+ *
+ * @param[in] position      The pose
+ */
+void mod_com_sendPose(robotPosition_t position);
+
+/**
+ * @brief Send the walls of the area
+ *
+ * @param[in] corners           The corners of the area, in order around it
+ * @param[in] numberOfCorners   The number of corners
+ */
+void mod_com_sendWalls(const point_t * corners, int numberOfCorners);
+
+/**
+ * @brief Send the position of a new object
+ *
+ * @param[in] object        The center of the object
+ */
+void mod_com_sendObject(point_t object);
+
+/**
+ * @brief Send a point measured during a scan
+ *
+ * @param[in] point         The measured point
+ * @param[in] kind          What the point was used for
+ */
+void mod_com_sendScanPoint(point_t point, scanKind_t kind);
+
+/**
+ * @brief Send a picture, in chunks of COM_CHUNK_SIZE bytes
+ * @note The picture is not copied, it must not change until mod_com_waitBulkEnd returns
+ *
+ * @param[in] x, y          The position of the photographed object
+ * @param[in] codec         How the picture is compressed (see mod_compression.h)
+ * @param[in] image         The compressed picture
+ * @param[in] size          The size of the compressed picture (in bytes)
+ */
+void mod_com_sendImage(int x, int y, imageCodec_t codec, const uint8_t * image, size_t size);
+
+/**
+ * @brief Wait until the last picture or datas are completely sent
+ */
+void mod_com_waitBulkEnd(void);
+
+/**
+ * @brief Returns the statistics of a lane
+ *
+ * @param[in] lane      The lane
+ *
+ * @param[out]      A copy of the statistics
+ */
+comLaneStats_t mod_com_getStats(comLane_t lane);
+
 #endif
@@ -0,0 +1,54 @@
+/*
+ * File : mod_compression.h
+ * Project : e_puck_project
+ * Description : Module that compresses the RGB565 pictures of the camera before they are sent
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_COMPRESSION_
+#define _MOD_COMPRESSION_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define IMAGE_WIDTH                 80
+#define IMAGE_HEIGHT                120
+#define IMAGE_SIZE                  (2*IMAGE_WIDTH*IMAGE_HEIGHT)    // RGB565, most significant byte first
+
+#define LOSSY_QUALITY               75      // 1 (smallest) to 100 (best), as the JPEG quality
+
+/**
+ * @brief Codecs of the pictures, decoded by pythonReception.py
+ * @details     CODEC_RAW       The pixels of the camera
+ *              CODEC_LOSSLESS  Each pixel is a run of the previous one, one of the 64 last colors,
+ *                              a small difference of its channels with the previous pixel or a
+ *                              raw pixel (as QOI, adapted to RGB565)
+ *              CODEC_LOSSY     YCbCr 4:2:0, 8x8 DCT quantized with the JPEG tables scaled by the
+ *                              quality and coded with Exp-Golomb codes
+ */
+typedef enum{
+    CODEC_RAW=0,
+    CODEC_LOSSLESS,
+    CODEC_LOSSY
+}imageCodec_t;
+
+/**
+ * @brief Compute the DCT and quantization tables
+ */
+void mod_compress_init(void);
+
+/**
+ * @brief Compress a picture of the camera
+ *
+ * @param[in] codec         The codec to use
+ * @param[in] image         The IMAGE_SIZE bytes of the picture
+ * @param[in] output        Where to write the compressed picture
+ * @param[in] outputSize    The size of the output (in bytes)
+ *
+ * @param[out]      The size of the compressed picture (in bytes), 0 if it does not fit in the output
+ */
+size_t mod_compress_image(imageCodec_t codec, const uint8_t * image, uint8_t * output, size_t outputSize);
+
+#endif
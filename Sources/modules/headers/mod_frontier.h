@@ -0,0 +1,72 @@
+/*
+ * File : mod_frontier.h
+ * Project : e_puck_project
+ * Description : Module that finds the boundaries between free and unknown cells of the grid to choose where to explore
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_FRONTIER_
+#define _MOD_FRONTIER_
+
+#include <stdbool.h>
+
+#include "mod_mapping.h"
+
+#define FRONTIER_MIN_SIZE           5       // Smaller clusters are considered as noise (in cells)
+#define FRONTIER_MAX_GOALS          12      // Goals visited during one mission
+#define FRONTIER_COVERAGE_TARGET    0.95f   // The mission stops above this coverage
+#define FRONTIER_MIN_GAIN           0.01f   // The mission stops when a scan adds less coverage than this
+
+/**
+ * @brief Set the explored area, only the cells inside are considered, and forget previous goals
+ *
+ * @param[in] min       The bottom left corner of the area
+ * @param[in] max       The top right corner of the area
+ */
+void mod_frontier_setArea(point_t min, point_t max);
+
+/**
+ * @brief Update the frontiers with the blocks of the grid that changed since the last call
+ * @note To call after each batch of measurements, it must run in the thread that updates the grid
+ */
+void mod_frontier_update(void);
+
+/**
+ * @brief Returns the part of the area that is known (free or occupied)
+ *
+ * @param[out]      The coverage, from 0 to 1
+ */
+float mod_frontier_getCoverage(void);
+
+/**
+ * @brief Choose the frontier with the best information gain for its travel cost
+ *
+ * @param[in] position  The position of the robot
+ * @param[in] goal      Where to store the point to reach, a free cell of the frontier
+ *
+ * @param[out]      False if there is no frontier left to visit
+ */
+bool mod_frontier_selectGoal(point_t position, point_t * goal);
+
+/**
+ * @brief Forget the frontiers around a goal that the robot could not reach, no path or blocked on the way
+ *
+ * @param[in] goal      The goal given by mod_frontier_selectGoal
+ */
+void mod_frontier_markUnreachable(point_t goal);
+
+/**
+ * @brief Record the coverage at the end of a scan, to detect when it saturates
+ */
+void mod_frontier_endOfScan(void);
+
+/**
+ * @brief Returns true when the mission can stop (coverage reached or saturated, no frontier, too many goals)
+ *
+ * @param[out]      The state of the mission
+ */
+bool mod_frontier_isExplorationDone(void);
+
+#endif
@@ -0,0 +1,143 @@
+/*
+ * File : mod_grid.h
+ * Project : e_puck_project
+ * Description : Module that stores the area as a log-odds occupancy grid
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_GRID_
+#define _MOD_GRID_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "mod_mapping.h"
+
+#define GRID_CELL_SIZE              10      // Side of a cell (in mm)
+#define GRID_ORIGIN_X               -100    // Coordinates of the bottom left corner of the grid (in mm)
+#define GRID_ORIGIN_Y               -100
+#define GRID_WIDTH                  1000    // Covered area (in mm)
+#define GRID_HEIGHT                 1000
+
+#define GRID_COLUMNS                (GRID_WIDTH/GRID_CELL_SIZE)
+#define GRID_ROWS                   (GRID_HEIGHT/GRID_CELL_SIZE)
+
+#define GRID_MAX_RANGE              1200    // Above this TOF value the ray is considered as not hitting anything (in mm)
+#define GRID_BLOCK_CELLS            8       // Side of a block, changes are tracked by blocks (in cells)
+
+#define GRID_BLOCK_COLUMNS          ((GRID_COLUMNS + GRID_BLOCK_CELLS - 1)/GRID_BLOCK_CELLS)
+#define GRID_BLOCK_ROWS             ((GRID_ROWS + GRID_BLOCK_CELLS - 1)/GRID_BLOCK_CELLS)
+#define GRID_BLOCKS                 (GRID_BLOCK_COLUMNS*GRID_BLOCK_ROWS)
+
+/**
+ * @brief Possible states of a cell
+ */
+typedef enum {
+    CELL_UNKNOWN = 0,
+    CELL_FREE,
+    CELL_OCCUPIED
+} cellState_t;
+
+/**
+ * @brief Cells of a part of the grid, limits included
+ */
+typedef struct {
+    int minColumn;
+    int minRow;
+    int maxColumn;
+    int maxRow;
+} gridRegion_t;
+
+/**
+ * @brief Clear the grid, every cell becomes unknown
+ */
+void mod_grid_init(void);
+
+/**
+ * @brief Clear the grid, to call when the coordinates system changes
+ */
+void mod_grid_reset(void);
+
+/**
+ * @brief Integrate a TOF ray in the grid (Bresenham traversal)
+ * @note Cells crossed by the ray become more likely free, the last one more likely occupied if hit is true
+ *
+ * @param[in] origin      The point where the ray starts
+ * @param[in] end         The point where the ray stops
+ * @param[in] hit         True if something was detected at the end of the ray
+ */
+void mod_grid_updateRay(point_t origin, point_t end, bool hit);
+
+/**
+ * @brief Convert a point in the main coordinates system to a cell
+ *
+ * @param[in] point       The point to convert
+ * @param[in] column      Where to store the column of the cell
+ * @param[in] row         Where to store the row of the cell
+ *
+ * @param[out]      True if the point is inside the grid
+ */
+bool mod_grid_pointToCell(point_t point, int * column, int * row);
+
+/**
+ * @brief Returns the center of a cell in the main coordinates system
+ *
+ * @param[in] column      The column of the cell
+ * @param[in] row         The row of the cell
+ *
+ * @param[out]      The center of the cell
+ */
+point_t mod_grid_cellToPoint(int column, int row);
+
+/**
+ * @brief Returns the state of a cell (unknown outside of the grid)
+ *
+ * @param[in] column      The column of the cell
+ * @param[in] row         The row of the cell
+ *
+ * @param[out]      The state of the cell
+ */
+cellState_t mod_grid_getCellState(int column, int row);
+
+/**
+ * @brief Returns the state of the cell that contains the point
+ *
+ * @param[in] point       The point to check
+ *
+ * @param[out]      The state of the cell
+ */
+cellState_t mod_grid_getState(point_t point);
+
+/**
+ * @brief Returns the raw log-odds value of a cell (0 outside of the grid)
+ *
+ * @param[in] column      The column of the cell
+ * @param[in] row         The row of the cell
+ *
+ * @param[out]      The log-odds value, positive means occupied
+ */
+int8_t mod_grid_getLogOdds(int column, int row);
+
+/**
+ * @brief Returns the stamp of the last change, to give to mod_grid_getChangedBlock later
+ * @note Each user keeps its own stamp, so any number of them can follow the changes
+ *
+ * @param[out]      The stamp
+ */
+uint32_t mod_grid_getStamp(void);
+
+/**
+ * @brief Check if a cell of a block changed of state after a stamp, so a user only checks these cells
+ * @note The grid is only updated by the exploration thread, this function must be called by it too
+ *
+ * @param[in] block       The block, from 0 to GRID_BLOCKS-1
+ * @param[in] since       The stamp of the last check of the user
+ * @param[in] region      Where to store the cells of the block
+ *
+ * @param[out]      True if the block changed, a reset changes all of them
+ */
+bool mod_grid_getChangedBlock(int block, uint32_t since, gridRegion_t * region);
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * File : mod_localization.h
+ * Project : e_puck_project
+ * Description : Module that fuses the gyroscope and the wheels odometry in one pose estimate with its covariance
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_LOCALIZATION_
+#define _MOD_LOCALIZATION_
+
+#include <ch.h>
+
+#include "structs.h"
+#include "mod_mapping.h"
+
+/**
+ * @brief Pose estimate and its uncertainty
+ * @note The covariance is ordered (x, y, theta), in mm² and rad²
+ */
+typedef struct {
+    robotPosition_t position;
+    float covariance[3][3];
+    systime_t timestamp;        // System time of the last fused IMU sample
+} robotPoseEstimate_t;
+
+/**
+ * @brief Launch the fusion thread, it publishes the estimate on the "/localization" topic of the bus
+ * @note IMU (mod_sensors_initSensors) and odometry (mod_odometry_start) must be started before
+ */
+void mod_localization_start(void);
+
+/**
+ * @brief Change the current position and reset its uncertainty, to call when the coordinates system changes
+ *
+ * @param[in] position      The new position of the robot
+ */
+void mod_localization_setPosition(robotPosition_t position);
+
+/**
+ * @brief Returns the last fused position, this is the reference position of the robot
+ *
+ * @param[out]      The position (theta in 0 -> 2PI)
+ */
+robotPosition_t mod_localization_getPosition(void);
+
+/**
+ * @brief Returns the last fused position with its covariance
+ *
+ * @param[out]      The estimate
+ */
+robotPoseEstimate_t mod_localization_getEstimate(void);
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * File : mod_log.h
+ * Project : e_puck_project
+ * Description : Module that stores log records (format identifier, time and raw arguments), they are formatted by the receiver
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_LOG_
+#define _MOD_LOG_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define LOG_LEVEL_DEBUG             0
+#define LOG_LEVEL_INFO              3
+#define LOG_LEVEL_WARNING           5
+
+#define LOG_COMPILE_LEVEL           1       // Records under this level are removed at compilation
+#define LOG_MAX_ARGS                4
+#define LOG_RING_SIZE               32      // Records waiting to be sent
+
+/**
+ * @brief Identifiers of the formats, listed in mod_log_formats.h
+ */
+typedef enum{
+#define LOG_FORMAT(name, format)    name,
+#include "mod_log_formats.h"
+#undef LOG_FORMAT
+    LOG_NUMBER_OF_FORMATS
+}logFormat_t;
+
+/**
+ * @brief A log record, arguments are the raw bits of int32 or float values
+ */
+typedef struct{
+    uint32_t time;              // (in ms)
+    uint32_t args[LOG_MAX_ARGS];
+    uint16_t format;
+    uint8_t numberOfArgs;
+    uint8_t floatArgs;          // Bit i is set if the argument i is a float
+}logRecord_t;
+
+
+/**
+ * @brief Log a record at a level, for example LOG_INFO(FMT_RELOCALIZED, iterations)
+ * @note    Nothing is formatted on the robot, the arguments (at most LOG_MAX_ARGS integers or floats)
+ *          are copied in the ring buffer. Levels under LOG_COMPILE_LEVEL compile to nothing
+ */
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...)      LOG_WRITE(format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...)      do{}while(0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(format, ...)       LOG_WRITE(format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...)       do{}while(0)
+#endif
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(format, ...)    LOG_WRITE(format, ##__VA_ARGS__)
+#else
+#define LOG_WARNING(format, ...)    do{}while(0)
+#endif
+
+// Conversion of each argument to its raw bits, the type is chosen at compilation
+#define LOG_RAW(x)                  _Generic((x), float: mod_log_floatToRaw, double: mod_log_floatToRaw, \
+                                             default: mod_log_intToRaw)(x)
+#define LOG_IS_FLOAT(x)             _Generic((x), float: 1, double: 1, default: 0)
+
+#define LOG_SELECT(_0, _1, _2, _3, _4, N, ...)  N
+#define LOG_COUNT(...)              LOG_SELECT(_0, ##__VA_ARGS__, 4, 3, 2, 1, 0)
+#define LOG_CONCAT2(a, b)           a##b
+#define LOG_CONCAT(a, b)            LOG_CONCAT2(a, b)
+#define LOG_APPLY(prefix, ...)      LOG_CONCAT(prefix, LOG_COUNT(__VA_ARGS__))(__VA_ARGS__)
+
+#define LOG_RAW_0()
+#define LOG_RAW_1(a)                , LOG_RAW(a)
+#define LOG_RAW_2(a, b)             LOG_RAW_1(a) LOG_RAW_1(b)
+#define LOG_RAW_3(a, b, c)          LOG_RAW_2(a, b) LOG_RAW_1(c)
+#define LOG_RAW_4(a, b, c, d)       LOG_RAW_3(a, b, c) LOG_RAW_1(d)
+
+#define LOG_MASK_0()                0
+#define LOG_MASK_1(a)               LOG_IS_FLOAT(a)
+#define LOG_MASK_2(a, b)            (LOG_MASK_1(a) | LOG_IS_FLOAT(b) << 1)
+#define LOG_MASK_3(a, b, c)         (LOG_MASK_2(a, b) | LOG_IS_FLOAT(c) << 2)
+#define LOG_MASK_4(a, b, c, d)      (LOG_MASK_3(a, b, c) | LOG_IS_FLOAT(d) << 3)
+
+#define LOG_WRITE(format, ...)      do{ \
+        const uint32_t logArgs[LOG_MAX_ARGS + 1] = {0 LOG_APPLY(LOG_RAW_, ##__VA_ARGS__)}; \
+        mod_log_write(format, &logArgs[1], LOG_COUNT(__VA_ARGS__), LOG_APPLY(LOG_MASK_, ##__VA_ARGS__)); \
+    }while(0)
+
+static inline uint32_t mod_log_floatToRaw(float value){
+    uint32_t raw;
+    memcpy(&raw, &value, sizeof(raw));
+    return raw;
+}
+
+static inline uint32_t mod_log_intToRaw(int32_t value){
+    return (uint32_t) value;
+}
+
+/**
+ * @brief Store a record in the ring buffer, use the LOG_ macros instead
+ * @note Never waits, the record is dropped if the ring buffer is full
+ *
+ * @param[in] format        The identifier of the format
+ * @param[in] args          The raw arguments
+ * @param[in] numberOfArgs  The number of arguments
+ * @param[in] floatArgs     Bit i is set if the argument i is a float
+ */
+void mod_log_write(logFormat_t format, const uint32_t * args, int numberOfArgs, uint8_t floatArgs);
+
+/**
+ * @brief Take the oldest record of the ring buffer
+ *
+ * @param[in] record    Where to copy the record
+ *
+ * @param[out]      False if there is no record
+ */
+bool mod_log_takeRecord(logRecord_t * record);
+
+/**
+ * @brief Returns the number of records dropped because the ring buffer was full
+ *
+ * @param[out]      The number of records
+ */
+uint32_t mod_log_getDropped(void);
+
+#endif
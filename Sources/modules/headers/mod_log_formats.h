@@ -0,0 +1,38 @@
+/*
+ * File : mod_log_formats.h
+ * Project : e_puck_project
+ * Description : Formats of the log records, the identifier of a format is its position in this list
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+// No include guard, this list is expanded with different definitions of LOG_FORMAT.
+// pythonReception.py reads this file to format the records, new formats go at the end.
+// Arguments are printed with %d (integers) and %f (floats).
+
+LOG_FORMAT(FMT_BASIC_INIT,              "Basic init OK")
+LOG_FORMAT(FMT_ROBOT_WAITING,           "Robot is waiting")
+LOG_FORMAT(FMT_ACTION_DETECTED,         "Action was detected")
+LOG_FORMAT(FMT_WILL_EXPLORE,            "Will explore the area")
+LOG_FORMAT(FMT_WILL_DISCOVER,           "Will discover the area")
+LOG_FORMAT(FMT_WILL_SING,               "Will launch a melody")
+LOG_FORMAT(FMT_WILL_SEND_MAP,           "Will send the map")
+LOG_FORMAT(FMT_ROBOT_MOVING,            "Robot is moving")
+LOG_FORMAT(FMT_ROBOT_NOT_MOVING,        "Robot is not moving")
+LOG_FORMAT(FMT_USELESS_FUNCTION,        "WARNING : You're using a useless function")
+LOG_FORMAT(FMT_ENTERING_EXPLORATION,    "Entering exploration thread")
+LOG_FORMAT(FMT_DROPPED,                 "Dropped:%d:%d:%d:%d: ")
+LOG_FORMAT(FMT_RELOCALIZED,             "Relocalized in %d iterations")
+LOG_FORMAT(FMT_MOVEMENT,                "deltaX: %d, deltaY; %d angle: %f")
+LOG_FORMAT(FMT_TO_DO,                   "To do: %d, %f")
+LOG_FORMAT(FMT_TO_DO_PICTURE,           "To do2: %d, %f")
+LOG_FORMAT(FMT_ALREADY_SEEN,            "Already seen")
+LOG_FORMAT(FMT_NOT_A_WALL,              "Not a wall")
+LOG_FORMAT(FMT_EMERGENCY_STOP,          "Obstacle : emergency stop")
+LOG_FORMAT(FMT_COVERAGE,                "Coverage:%d:%d: ")
+LOG_FORMAT(FMT_COLOR_SUMS,              "redsum %d, bluesum%d")
+LOG_FORMAT(FMT_SEM_OK,                  "MSG_OK")
+LOG_FORMAT(FMT_SEM_RESET,               "MSG_RESET")
+LOG_FORMAT(FMT_SEM_TIMEOUT,             "MSG_TIMEOUT")
+LOG_FORMAT(FMT_GOTO_ABORTED,            "Go to aborted:%d:%d: ")
+LOG_FORMAT(FMT_NO_PATH,                 "No path to:%d:%d: ")
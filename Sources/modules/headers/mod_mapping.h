@@ -22,6 +22,8 @@
 
 #define NUMBER_OF_STEPS_FRONT       10
 #define ANGLE_ELEMENT_FRONT         2*M_PI/(16*NUMBER_OF_STEPS_FRONT)
+
+#define MAPPING_MAX_WALLS           4       // Fitted lines kept as walls, the area is any convex polygon up to this
 #define SIZE_FRONT_SCAN             2*M_PI/16
 
 #define NUMBER_OF_SCANS_MIN         NUMBER_OF_STEPS_SCAN360
@@ -50,7 +52,7 @@ typedef struct  {
 }robotDistance_t;
 
 typedef struct{
-    bool nearWall[4];
+    bool nearWall[MAPPING_MAX_WALLS];
     int numberOfnewObjects;
     int numberOfknownObjects;
     point_t newObjectsLocation[3];
@@ -70,20 +72,50 @@ void mod_mapping_init(void);
 void mod_mapping_resetCoordinates(void);
 
 /**
- * @brief Compute the position of the robot based on last position and the displacement (speed + time)
+ * @brief Integrate a TOF measurement in the occupancy grid
+ *
+ * @param[in] measurement       The measurement to integrate
+ */
+void mod_mapping_addMeasurement(measurement_t * measurement);
+
+/**
+ * @brief Forget the points of the last sweep, to call before a new 360 deg scan
+ */
+void mod_mapping_startSweep(void);
+
+/**
+ * @brief Correct the position of the robot by matching the points of the sweep with the walls
  *
- * @param[in] wheelSpeed       The wheel style speed of the robot
- * @param[in] time             The time the robot was at the indicated speed
+ * @param[out]      True if the position was corrected
+ */
+bool mod_mapping_relocalize(void);
+
+/**
+ * @brief Update the position of the robot with the last one fused from gyroscope and motors steps (localization thread)
 */
-void mod_mapping_updatePositionWheelSpeedType(const wheelSpeed_t *wheelSpeed, int time);
+void mod_mapping_updatePosition(void);
 
 
 /**
- * @brief Compute the wall location based on measurements and store information in the mapping area
+ * @brief Forget the walls points, to call before the discovery sweep
+ */
+void mod_mapping_startWallDiscovery(void);
+
+/**
+ * @brief Add a measurement of the discovery sweep to the walls lines, to call as it arrives
+ *
+ * @param[in] measurement       The measurement
+ */
+void mod_mapping_addWallMeasurement(measurement_t * measurement);
+
+/**
+ * @brief Compute the wall location from the lines of the discovery sweep and store information in the mapping area
+ * @details The fitted lines are the walls, with any orientation. The origin moves to the corner of the box around them,
+ *          with the first wall along x = 0
  *
- * @param[in] measurement       The measurement of all walls points
+ * @param[out]      True if the walls close the area around the robot
  */
-_Bool mod_mapping_computeWallLocation(measurement_t* measurement);
+_Bool mod_mapping_computeWallLocation(void);
 
 /**
  * @brief Compute the wall location based on measurements and store information in the mapping area
@@ -112,6 +144,7 @@ float mod_mapping_getRelativeAngle(const float angle);
 
 /**
  * @brief Check the current environement in front of the robot
+ * @details Only the occupied cells of the grid count, those on a fitted wall line are walls, the others objects
  *
  * @param[in] measurement               All measurements
  * @param[in] numberOfMeasurements      The number of measurements
@@ -163,12 +196,13 @@ int mod_mapping_computeDistanceForPictureRobotReferencial(measurement_t * measur
  * @brief Find the best position where to move to have the center of the object
  *
  * @param[in] measurement     The list of measruements
+ * @param[in] numberOfMeasurements  The size of the list
  * @param[in] considerWalls   True if discovering have been done, so it will use points
  * @param[in] newPoint        The closest point
  *
  * @param[out]      The distance to do to take the picture
  */
-robotDistance_t mod_mapping_findObjectBestPosition(measurement_t* measurement, point_t* newPoint, bool considerWalls);
+robotDistance_t mod_mapping_findObjectBestPosition(measurement_t* measurement, int numberOfMeasurements, point_t* newPoint, bool considerWalls);
 
 
 #endif
@@ -0,0 +1,128 @@
+/*
+ * File : mod_motion.h
+ * Project : e_puck_project
+ * Description : Module that executes a queue of motion segments (line, arc, rotation, point) without stopping between them
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_MOTION_
+#define _MOD_MOTION_
+
+#include <stdbool.h>
+
+#include "structs.h"
+#include "mod_pursuit.h"
+
+#define MOTION_QUEUE_SIZE           PURSUIT_MAX_POINTS  // Segments that can wait in the queue, a whole planned path
+#define MOTION_FREQUENCY            PURSUIT_FREQUENCY   // Rate of the planner (in Hz)
+#define MOTION_DEFAULT_SPEED        40      // Speed of the fastest wheel (in mm/s)
+#define MOTION_DEFAULT_ROTATION     0.4f    // Rotation speed in place (in rad/s)
+
+typedef enum {
+    MOTION_LINE = 0,
+    MOTION_ARC,
+    MOTION_ROTATE,
+    MOTION_POINT                // Followed in closed loop on the pose with the pure pursuit controller
+} motionType_t;
+
+/**
+ * @brief Function called by the planner thread when a segment is finished, it must be short
+ */
+typedef void (*motionCallback_t)(void * arg);
+
+/**
+ * @brief One element of a path, lengths are positive forward and angles positive to the left
+ */
+typedef struct {
+    motionType_t type;
+    float length;               // Distance done by the center of the robot (in mm), only for a line or an arc
+    float angle;                // Rotation of the robot (in rad), only for an arc or a rotation
+    float speed;                // Cruise speed of the fastest wheel (in mm/s), unused for a point
+    point_t point;              // Absolute position to reach, only for a point
+    motionCallback_t callback;  // Can be NULL
+    void * arg;
+} motionSegment_t;
+
+/**
+ * @brief Launch the planner thread
+ * @note Odometry (mod_odometry_start) and localization (mod_localization_start) must be started before,
+ *       progress is measured on the wheels and the points are followed on the pose
+ */
+void mod_motion_start(void);
+
+/**
+ * @brief Add a segment at the end of the queue, blocks only if the queue is full
+ *
+ * @param[in] segment   The segment, copied
+ */
+void mod_motion_enqueue(const motionSegment_t * segment);
+
+/**
+ * @brief Add a straight line at the default speed
+ *
+ * @param[in] length    The distance (in mm, negative to go backward)
+ * @param[in] callback  Function to call at the end of the line (can be NULL)
+ * @param[in] arg       Argument given to the callback
+ */
+void mod_motion_addLine(float length, motionCallback_t callback, void * arg);
+
+/**
+ * @brief Add an arc of circle at the default speed
+ *
+ * @param[in] length    The distance done by the center of the robot (in mm)
+ * @param[in] angle     The rotation at the end of the arc (in rad)
+ * @param[in] callback  Function to call at the end of the arc (can be NULL)
+ * @param[in] arg       Argument given to the callback
+ */
+void mod_motion_addArc(float length, float angle, motionCallback_t callback, void * arg);
+
+/**
+ * @brief Add a rotation in place at the default speed
+ *
+ * @param[in] angle     The rotation (in rad)
+ * @param[in] callback  Function to call at the end of the rotation (can be NULL)
+ * @param[in] arg       Argument given to the callback
+ */
+void mod_motion_addRotation(float angle, motionCallback_t callback, void * arg);
+
+/**
+ * @brief Add a point to reach, consecutive points are followed as one path
+ * @note A point is finished when the controller aims at the next one, the last one of the queue when it is reached
+ *
+ * @param[in] point     The absolute position of the point
+ * @param[in] callback  Function to call when the point is finished (can be NULL)
+ * @param[in] arg       Argument given to the callback
+ */
+void mod_motion_addPoint(point_t point, motionCallback_t callback, void * arg);
+
+/**
+ * @brief Replace all the segments by the points of a path, the robot does not stop in between
+ * @note The callbacks of the removed segments are not called
+ *
+ * @param[in] path              The points to follow, in order (copied)
+ * @param[in] numberOfPoints    The number of points, the extra ones are ignored
+ * @param[in] callback          Function to call when the last point is reached (can be NULL)
+ * @param[in] arg               Argument given to the callback
+ */
+void mod_motion_followPath(const point_t * path, int numberOfPoints, motionCallback_t callback, void * arg);
+
+/**
+ * @brief Remove all the segments and stop the motors, the callbacks of the removed segments are not called
+ */
+void mod_motion_stop(void);
+
+/**
+ * @brief Returns true if there is no segment running or waiting
+ *
+ * @param[out]      The state of the planner
+ */
+bool mod_motion_isIdle(void);
+
+/**
+ * @brief Wait until all enqueued segments are finished and the robot is stopped
+ */
+void mod_motion_waitIdle(void);
+
+#endif
@@ -14,6 +14,8 @@
 
 #define ROBOT_RADIUS    27
 #define MS_TO_S         1000
+#include <stdint.h>
+#include <stdbool.h>
 #include "structs.h"
 /**
  * @brief Initialize motors
@@ -62,6 +64,13 @@ void mod_motor_angleCalibration(const wheelSpeed_t displacement, const int movem
 void mod_motor_distanceCalibration(int distanceWithWall, const wheelSpeed_t displacement, const int movementTime);
 
 
+/**
+ * @brief Returns the conversion factor between a distance and motors steps (calibrated value)
+ *
+ * @param[out] Number of steps for one mm
+ */
+float mod_motors_getStepsPerMm(void);
+
 /**
  * @brief Change Motors command for a certain state
  *
@@ -76,6 +85,36 @@ void mod_motors_changeStateWheelSpeedType(wheelSpeed_t wheelSpeed);
  */
 void mod_motors_changeStateRobotSpeedType(robotSpeed_t robotSpeed);
 
+/**
+ * @brief Returns the number of motor steps for a distance done by a wheel
+ *
+ * @param[in] distance      The distance (in mm)
+ *
+ * @param[out] The closest number of steps
+ */
+int32_t mod_motors_convertDistanceToSteps(float distance);
+
+/**
+ * @brief Move the robot of an exact number of steps and wait until both wheels reach it
+ * @note Both wheels arrive at the same time, the end is signaled by the motors driver
+ *       and not by a timer so no time is lost after the move.
+ *       A speed command given meanwhile cancels the move, a move longer than expected is stopped
+ *
+ * @param[in] distance  The distance done by the center of the robot (in mm, negative to go backward)
+ * @param[in] angle     The rotation done at the same time (in rad, positive to the left)
+ * @param[in] speed     Cruise speed of the fastest wheel (in mm/s)
+ *
+ * @param[out]      True if the position is reached, false if the move was cancelled or stopped
+ */
+bool mod_motors_moveAndWait(float distance, float angle, float speed);
+/**
+ * @brief Correct the speed commands to avoid obstacles, the last command is applied again at once
+ * @note Only forward motions are corrected, exact moves (mod_motors_moveAndWait) are not
+ *
+ * @param[in] speedFactor   Factor applied to the forward speed (0 to stop, 1 without obstacle)
+ * @param[in] rotation      Rotation added for each mm/s of forward speed (in rad/mm, positive to the left)
+ */
+void mod_motors_setSafetyCorrection(float speedFactor, float rotation);
 
 /**
  * @brief Stop the robot
@@ -0,0 +1,101 @@
+/*
+ * File : mod_objects.h
+ * Project : e_puck_project
+ * Description : Module that stores detected objects in a spatial hash index
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_OBJECTS_
+#define _MOD_OBJECTS_
+
+#include <stdbool.h>
+
+#include "mod_mapping.h"
+
+// The sizes can be given by the build, the host benchmark (tests/) uses thousands of objects
+#ifndef OBJECTS_MAX_NUMBER
+#define OBJECTS_MAX_NUMBER          128     // Capacity of the object pool
+#endif
+#ifndef OBJECTS_BUCKETS_NUMBER
+#define OBJECTS_BUCKETS_NUMBER      64      // Number of buckets of the hash table (power of 2)
+#endif
+#define OBJECTS_BUCKET_SIZE         64      // Side of the square covered by a bucket (in mm)
+
+#define OBJECT_NONE                 -1
+
+typedef struct {
+    point_t location;       // Mean location of all detections
+    int detections;         // Number of merged detections
+} object_t;
+
+/**
+ * @brief Empty the object pool and the index
+ */
+void mod_objects_init(void);
+
+/**
+ * @brief Empty the object pool and the index
+ */
+void mod_objects_reset(void);
+
+/**
+ * @brief Add a new object
+ *
+ * @param[in] location      The location of the object
+ *
+ * @param[out]      The id of the object, OBJECT_NONE if the pool is full
+ */
+int mod_objects_insert(point_t location);
+
+/**
+ * @brief Find the closest object in a circle
+ *
+ * @param[in] center        The center of the circle
+ * @param[in] radius        The radius of the circle (in mm)
+ *
+ * @param[out]      The id of the closest object, OBJECT_NONE if there is none
+ */
+int mod_objects_findNearest(point_t center, int radius);
+
+/**
+ * @brief List all objects in a circle
+ *
+ * @param[in] center        The center of the circle
+ * @param[in] radius        The radius of the circle (in mm)
+ * @param[in] ids           A table where to store ids of found objects
+ * @param[in] maxIds        The size of the table
+ *
+ * @param[out]      The number of stored ids
+ */
+int mod_objects_queryRadius(point_t center, int radius, int * ids, int maxIds);
+
+/**
+ * @brief Merge the detection with the closest object in the circle, or add a new object
+ *
+ * @param[in] location      The location of the detection
+ * @param[in] radius        The radius in which detections are considered as the same object (in mm)
+ * @param[in] isNew         Where to store true if a new object was added
+ *
+ * @param[out]      The id of the object, OBJECT_NONE if the pool is full
+ */
+int mod_objects_merge(point_t location, int radius, bool * isNew);
+
+/**
+ * @brief Returns the number of stored objects
+ *
+ * @param[out]      The number of objects
+ */
+int mod_objects_getNumber(void);
+
+/**
+ * @brief Returns an object
+ *
+ * @param[in] id            The id of the object (0 -> mod_objects_getNumber()-1)
+ *
+ * @param[out]      The object
+ */
+object_t mod_objects_get(int id);
+
+#endif
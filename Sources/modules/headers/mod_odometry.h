@@ -0,0 +1,115 @@
+/*
+ * File : mod_odometry.h
+ * Project : e_puck_project
+ * Description : Module that integrates wheel displacements in fixed point (Q16.16 position, Q31 heading)
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_ODOMETRY_
+#define _MOD_ODOMETRY_
+
+#include <stdint.h>
+#include <ch.h>
+#include <arm_math.h>
+
+#include "structs.h"
+#include "mod_mapping.h"
+
+#define ODOMETRY_FREQUENCY          200     // Rate of the encoders reading (in Hz)
+#define ODOMETRY_FRACTION_BITS      16
+#define ODOMETRY_MM_TO_FIXED(mm)    ((int32_t)((mm)*(1 << ODOMETRY_FRACTION_BITS) + (((mm) < 0) ? -0.5f : 0.5f)))  // Rounded
+
+/**
+ * @brief Pose of the robot in fixed point
+ * @note The heading uses the CMSIS convention, -1 -> 1 in Q31 means -PI -> PI, so it wraps for free
+ */
+typedef struct {
+    int32_t x;          // In mm, Q16.16
+    int32_t y;          // In mm, Q16.16
+    q31_t theta;        // Same reference than robotPosition_t (0 is the y axis)
+} odometryPose_t;
+
+/**
+ * @brief Message published on the "/odometry" topic of the bus
+ */
+typedef struct {
+    odometryPose_t pose;
+    robotPosition_t position;   // Same pose, rounded
+    systime_t timestamp;        // System time of the encoders reading
+} odometry_msg_t;
+
+/**
+ * @brief Launch the thread that integrates motors steps and publishes the pose on the bus
+ * @note Motors and bus must be initialized before
+ */
+void mod_odometry_start(void);
+
+/**
+ * @brief Change the current pose, to call when the coordinates system changes
+ *
+ * @param[in] position      The new position of the robot
+ */
+void mod_odometry_setPosition(robotPosition_t position);
+
+/**
+ * @brief Returns the last pose computed from motors steps
+ *
+ * @param[out]      The pose
+ */
+odometryPose_t mod_odometry_getPose(void);
+
+/**
+ * @brief Returns the last position computed from motors steps
+ *
+ * @param[out]      The position, rounded to the nearest mm
+ */
+robotPosition_t mod_odometry_getPosition(void);
+
+/**
+ * @brief Returns the total distance done by each wheel since the start
+ * @note Values wrap around, only differences between two calls are meaningful
+ *
+ * @param[in] left      Where to store the left wheel distance (in mm, Q16.16)
+ * @param[in] right     Where to store the right wheel distance (in mm, Q16.16)
+ */
+void mod_odometry_getWheelDistances(int32_t * left, int32_t * right);
+
+/**
+ * @brief Convert a robot position (int mm, float rad) to a fixed point pose
+ *
+ * @param[in] position      The position to convert
+ *
+ * @param[out]      The fixed point pose
+ */
+odometryPose_t mod_odometry_fromRobotPosition(robotPosition_t position);
+
+/**
+ * @brief Convert a fixed point pose to a robot position, rounded to the nearest mm
+ *
+ * @param[in] pose          The pose to convert
+ *
+ * @param[out]      The robot position (theta in 0 -> 2PI)
+ */
+robotPosition_t mod_odometry_toRobotPosition(const odometryPose_t * pose);
+
+/**
+ * @brief Add wheels displacements to the pose with a midpoint (Runge-Kutta 2) integration
+ *
+ * @param[in] pose              The pose to update
+ * @param[in] leftDistance      Distance done by the left wheel (in mm, Q16.16)
+ * @param[in] rightDistance     Distance done by the right wheel (in mm, Q16.16)
+ */
+void mod_odometry_integrate(odometryPose_t * pose, int32_t leftDistance, int32_t rightDistance);
+
+/**
+ * @brief Add the displacement of wheels moving at a constant speed during a time
+ *
+ * @param[in] pose          The pose to update
+ * @param[in] wheelSpeed    The speed of the wheels (in mm/s)
+ * @param[in] time          The time the robot was at this speed (in ms)
+ */
+void mod_odometry_integrateWheelSpeed(odometryPose_t * pose, const wheelSpeed_t * wheelSpeed, int time);
+
+#endif
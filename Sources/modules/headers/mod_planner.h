@@ -0,0 +1,75 @@
+/*
+ * File : mod_planner.h
+ * Project : e_puck_project
+ * Description : Module that plans paths on the occupancy grid, A* for a first path and D* Lite to search again
+ *               only around the changes
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_PLANNER_
+#define _MOD_PLANNER_
+
+#include <stdbool.h>
+
+#include "mod_mapping.h"
+
+#define PLANNER_MAX_COLUMNS         64      // Size of the planning window, in cells of the grid
+#define PLANNER_MAX_ROWS            84
+#define PLANNER_HEAP_SIZE           2048    // Capacity of the open list
+#define PLANNER_ROBOT_CELLS         4       // Cells around an obstacle where the center of the robot can not go
+
+/**
+ * @brief Set the area where the paths are planned, cells outside are never used
+ * @note The area is clipped to PLANNER_MAX_COLUMNS x PLANNER_MAX_ROWS cells
+ *
+ * @param[in] min       The bottom left corner of the area
+ * @param[in] max       The top right corner of the area
+ */
+void mod_planner_setArea(point_t min, point_t max);
+
+/**
+ * @brief Find the shortest path between two points with A* (octile heuristic)
+ * @note The state of mod_planner_startReplanning is lost
+ *
+ * @param[in] start         The start of the path
+ * @param[in] goal          The end of the path
+ * @param[in] path          Where to store the points of the path, without the start
+ * @param[in] maxPoints     The size of path
+ *
+ * @param[out]      The number of points, 0 if there is no path or a point is outside of the area
+ */
+int mod_planner_findPath(point_t start, point_t goal, point_t * path, int maxPoints);
+
+/**
+ * @brief Initialize D* Lite for a goal, the path is then given by mod_planner_replan
+ * @note Nothing is searched here, the first call of mod_planner_replan searches the whole area
+ *
+ * @param[in] start     The position of the robot
+ * @param[in] goal      The point to reach
+ *
+ * @param[out]      False if a point is outside of the area
+ */
+bool mod_planner_startReplanning(point_t start, point_t goal);
+
+/**
+ * @brief Compare the obstacles of the grid with the ones used by the planner and give the changes to D* Lite
+ * @note Only the cells around the blocks of the grid changed since the last call are checked
+ *
+ * @param[out]      True if some cells changed, the path must be asked again
+ */
+bool mod_planner_updateObstacles(void);
+
+/**
+ * @brief Returns the shortest path from a new position of the robot, only the changed part is searched again
+ *
+ * @param[in] start         The position of the robot
+ * @param[in] path          Where to store the points of the path, without the start
+ * @param[in] maxPoints     The size of path
+ *
+ * @param[out]      The number of points, 0 if there is no path
+ */
+int mod_planner_replan(point_t start, point_t * path, int maxPoints);
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * File : mod_pursuit.h
+ * Project : e_puck_project
+ * Description : Closed loop pure pursuit controller on a path of points, run by the planner thread of mod_motion
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_PURSUIT_
+#define _MOD_PURSUIT_
+
+#include <stdbool.h>
+
+#include "structs.h"
+#include "mod_mapping.h"
+
+#define PURSUIT_FREQUENCY           100     // Rate of the controller (in Hz)
+#define PURSUIT_MAX_POINTS          32      // Points of a path given at once
+#define PURSUIT_LOOKAHEAD           60      // Distance of the followed point on the path (in mm)
+#define PURSUIT_ARRIVAL_DISTANCE    5       // The path is finished under this distance to its end (in mm)
+
+/**
+ * @brief Compute the wheels speeds that bring a pose on a path, one tick of the controller
+ * @note No state is used so it can be run on a kinematic model
+ *
+ * @param[in] position          The pose of the robot
+ * @param[in] path              The points of the path
+ * @param[in] numberOfPoints    The number of points
+ * @param[in] segment           The first segment of the path that is not done yet, updated
+ * @param[in] wheelSpeed        Where to store the speeds (in mm/s)
+ *
+ * @param[out]      True when the end of the path is reached
+ */
+bool mod_pursuit_computeWheelSpeed(robotPosition_t position, const point_t * path, int numberOfPoints,
+                                   int * segment, wheelSpeed_t * wheelSpeed);
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * File : mod_reliable.h
+ * Project : e_puck_project
+ * Description : Sliding window of a reliable transfer in chunks, acknowledged by the receiver
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_RELIABLE_
+#define _MOD_RELIABLE_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define RELIABLE_FIRST_WINDOW       2       // Chunks sent before the first acknowledgement
+#define RELIABLE_MAX_WINDOW         8       // At most 32
+#define RELIABLE_ACK_TIMEOUT        500     // Without progress, the first chunk is sent again (in ms)
+#define RELIABLE_MAX_TIMEOUTS       8       // The transfer fails after this number of timeouts in a row
+
+/**
+ * @brief State of the sender of a transfer
+ * @details The receiver acknowledges the chunks it received in a row (cumulative) and asks again for
+ *          a chunk when a later one arrives first. The window grows by one chunk each time a full
+ *          window is acknowledged, it is halved on a lost chunk and set to one on a timeout
+ */
+typedef struct{
+    uint16_t transfer;          // Identifier of the transfer, in the chunks and the acknowledgements
+    uint16_t numberOfChunks;
+    uint16_t base;              // First chunk not acknowledged
+    uint16_t next;              // First chunk never sent
+    uint16_t recovery;          // The window is not halved again for chunks lost before this one
+    uint16_t window;
+    uint16_t credit;            // Chunks acknowledged since the window last grew
+    uint8_t timeouts;
+    bool failed;
+    uint32_t resend;            // Bit i is set if the chunk base + i must be sent again
+    uint32_t lastProgress;      // (in ms)
+    uint32_t retransmitted;     // Chunks sent again during the transfer
+}reliableSender_t;
+
+/**
+ * @brief Start a new transfer
+ *
+ * @param[in] sender        The state of the sender
+ * @param[in] transfer      The identifier of the transfer
+ * @param[in] size          The size of the datas (in bytes)
+ * @param[in] chunkSize     The size of a chunk (in bytes)
+ * @param[in] now           The current time (in ms)
+ */
+void mod_reliable_start(reliableSender_t * sender, uint16_t transfer, size_t size, size_t chunkSize, uint32_t now);
+
+/**
+ * @brief Returns the next chunk to send, the lost ones first
+ *
+ * @param[in] sender        The state of the sender
+ * @param[in] now           The current time (in ms)
+ *
+ * @param[out]      The number of the chunk, -1 if the window is full or the transfer is finished
+ */
+int mod_reliable_nextChunk(reliableSender_t * sender, uint32_t now);
+
+/**
+ * @brief Handle an acknowledgement, older or other transfers ones are ignored
+ *
+ * @param[in] sender        The state of the sender
+ * @param[in] transfer      The identifier of the acknowledged transfer
+ * @param[in] received      The number of chunks received in a row from the first one
+ * @param[in] now           The current time (in ms)
+ */
+void mod_reliable_acknowledge(reliableSender_t * sender, uint16_t transfer, uint16_t received, uint32_t now);
+
+/**
+ * @brief Handle a request to send a chunk again
+ *
+ * @param[in] sender        The state of the sender
+ * @param[in] transfer      The identifier of the transfer
+ * @param[in] chunk         The lost chunk
+ */
+void mod_reliable_lost(reliableSender_t * sender, uint16_t transfer, uint16_t chunk);
+
+/**
+ * @brief Returns true if all the chunks are acknowledged or if the transfer failed
+ */
+bool mod_reliable_isFinished(const reliableSender_t * sender);
+
+/**
+ * @brief Returns the time until the next timeout (in ms)
+ */
+uint32_t mod_reliable_timeUntilTimeout(const reliableSender_t * sender, uint32_t now);
+
+#endif
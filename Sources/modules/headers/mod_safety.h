@@ -0,0 +1,34 @@
+/*
+ * File : mod_safety.h
+ * Project : e_puck_project
+ * Description : Module that slows down, steers or stops the robot in front of unmapped obstacles
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_SAFETY_
+#define _MOD_SAFETY_
+
+#include <stdbool.h>
+
+#define SAFETY_TOF_STOP_DISTANCE        50      // The robot does not go forward under this distance (in mm)
+#define SAFETY_TOF_INFLUENCE_DISTANCE   100     // The robot slows down under this distance (in mm)
+#define SAFETY_IR_INFLUENCE             150     // IR value where an obstacle starts to repulse the robot
+#define SAFETY_IR_STOP                  1000    // IR value of an obstacle that stops the robot
+
+/**
+ * @brief Launch the safety thread, it runs at each new proximity measurement
+ * @note Sensors (mod_sensors_initSensors) and motors (mod_motors_init) must be started before
+ */
+void mod_safety_start(void);
+
+/**
+ * @brief Returns true if an obstacle stops the robot at this moment
+ * @note The controllers do not see the stop, goTo gives up when it lasts
+ *
+ * @param[out]      The state of the emergency stop
+ */
+bool mod_safety_isEmergency(void);
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ * File : mod_scanmatch.h
+ * Project : e_puck_project
+ * Description : Module that corrects the robot pose by matching TOF sweeps against the walls (point to line ICP)
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_SCANMATCH_
+#define _MOD_SCANMATCH_
+
+#include <stdbool.h>
+
+#include "mod_mapping.h"
+#include "mod_walls.h"
+
+#define SCANMATCH_MAX_POINTS        128     // Capacity of the sweep buffer, the oldest points are replaced
+#define SCANMATCH_MAX_ITERATIONS    10      // Fixed budget of one matching
+#define SCANMATCH_MIN_INLIERS       12      // Under this number the correction is not trusted
+
+/**
+ * @brief Result of one matching
+ */
+typedef struct {
+    float x;            // Correction to add to the pose (in mm)
+    float y;
+    float theta;        // Rotation around the robot (in rad)
+    float error;        // Mean distance between inliers and their wall after the correction (in mm)
+    int inliers;        // Number of points associated to a wall
+    int iterations;     // Number of iterations done
+    bool converged;
+} scanMatch_t;
+
+/**
+ * @brief Remove all the points of the sweep
+ */
+void mod_scanmatch_reset(void);
+
+/**
+ * @brief Store the point hit by a measurement in the sweep
+ *
+ * @param[in] point     The point (in the coordinates system of the walls)
+ */
+void mod_scanmatch_addPoint(point_t point);
+
+/**
+ * @brief Returns the number of points in the sweep
+ *
+ * @param[out]      The number of points
+ */
+int mod_scanmatch_getNumberOfPoints(void);
+
+/**
+ * @brief Find the rigid motion around the robot that best puts the sweep on the lines
+ *
+ * @param[in] lines         The known walls
+ * @param[in] numberOfLines The number of walls
+ * @param[in] position      The position of the robot during the sweep (center of the rotation)
+ *
+ * @param[out]      The correction, to apply only if converged and with enough inliers
+ */
+scanMatch_t mod_scanmatch_match(const line_t * lines, int numberOfLines, robotPosition_t position);
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * File : mod_stft.h
+ * Project : e_puck_project
+ * Description : Module that computes the spectrum of overlapping frames of a real signal (short time Fourier transform)
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_STFT_
+#define _MOD_STFT_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define STFT_SIZE                   1024    // Samples of a frame, a power of 2
+#define STFT_HOP_SIZE               256     // New samples between two frames (16 ms at 16 kHz)
+#define STFT_USE_Q15                0       // 1 for the fixed point FFT, less precise but faster and half the memory
+
+/**
+ * @brief Compute the window and initialize the FFT, the ring buffer is cleared
+ */
+void mod_stft_init(void);
+
+/**
+ * @brief Add a sample in the ring buffer, the spectrum of the last frame is computed at each hop
+ *
+ * @param[in] sample    The new sample
+ *
+ * @param[out]      True when a new spectrum is available
+ */
+bool mod_stft_addSample(int16_t sample);
+
+/**
+ * @brief Returns the power of the bins of the last spectrum
+ *
+ * @param[out]      STFT_SIZE/2 powers, bin k is at k*sampling frequency/STFT_SIZE
+ */
+const float * mod_stft_getPowers(void);
+
+#endif
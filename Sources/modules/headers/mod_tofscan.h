@@ -0,0 +1,55 @@
+/*
+ * File : mod_tofscan.h
+ * Project : e_puck_project
+ * Description : Module that records timestamped TOF samples with the pose of the robot while it rotates
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_TOFSCAN_
+#define _MOD_TOFSCAN_
+
+#include <stdbool.h>
+#include <ch.h>
+
+#include "mod_mapping.h"
+
+#define TOFSCAN_BUFFER_SIZE         256     // Samples of one sweep, the oldest ones are replaced
+#define TOFSCAN_RANGING_DELAY       17      // Between the middle of the ranging and the new data signal (in ms)
+
+/**
+ * @brief One TOF sample, the position is the one of the robot at the time of the ranging
+ */
+typedef struct {
+    measurement_t measurement;
+    systime_t timestamp;
+} tofSample_t;
+
+/**
+ * @brief Launch the sampler thread, it is woken up by each new TOF data
+ * @note TOF (mod_sensors_initSensors) and localization (mod_localization_start) must be started before
+ */
+void mod_tofscan_start(void);
+
+/**
+ * @brief Empty the buffer and start to record samples
+ */
+void mod_tofscan_startRecording(void);
+
+/**
+ * @brief Stop to record samples, the buffer is kept until the next recording
+ */
+void mod_tofscan_stopRecording(void);
+
+/**
+ * @brief Copy the recorded measurements, from the oldest to the newest
+ *
+ * @param[in] measurements      A table where to store the measurements
+ * @param[in] maxMeasurements   The size of the table
+ *
+ * @param[out]      The number of copied measurements
+ */
+int mod_tofscan_getMeasurements(measurement_t * measurements, int maxMeasurements);
+
+#endif
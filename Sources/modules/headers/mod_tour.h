@@ -0,0 +1,60 @@
+/*
+ * File : mod_tour.h
+ * Project : e_puck_project
+ * Description : Module that orders the picture positions of the detected objects in one short tour
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_TOUR_
+#define _MOD_TOUR_
+
+#include <stdbool.h>
+
+#include "mod_mapping.h"
+
+#define TOUR_MAX_STOPS              8       // Objects that can be visited in one tour
+#define TOUR_MAX_IMPROVEMENTS       32      // Budget of 2-opt moves for one tour
+#define TOUR_SAME_OBJECT_DISTANCE   30      // Objects closer than this are the same (in mm)
+
+/**
+ * @brief Position where the robot takes the picture of an object
+ */
+typedef struct {
+    point_t object;
+    point_t position;
+} pictureStop_t;
+
+/**
+ * @brief Remove all objects of the tour
+ */
+void mod_tour_reset(void);
+
+/**
+ * @brief Add an object to the tour, the picture position is the one reached from the current position of the robot
+ *
+ * @param[in] object    The position of the object
+ *
+ * @param[out]      False if the tour is full or if the object is already in it
+ */
+bool mod_tour_addObject(point_t object);
+
+/**
+ * @brief Returns the number of objects in the tour
+ *
+ * @param[out]      The number of objects
+ */
+int mod_tour_getNumberOfStops(void);
+
+/**
+ * @brief Compute a short order to visit all picture positions (nearest neighbour, then 2-opt)
+ *
+ * @param[in] start     The position of the robot at the beginning of the tour
+ * @param[in] tour      Where to store the stops in the visit order, TOUR_MAX_STOPS elements
+ *
+ * @param[out]      The number of stops
+ */
+int mod_tour_computeOrder(point_t start, pictureStop_t * tour);
+
+#endif
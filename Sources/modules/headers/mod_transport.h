@@ -0,0 +1,106 @@
+/*
+ * File : mod_transport.h
+ * Project : e_puck_project
+ * Description : Module that carries the bytes of mod_communication over the UART or the USB
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_TRANSPORT_
+#define _MOD_TRANSPORT_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#define TRANSPORT_WRITE_TIMEOUT     100     // Bytes that cannot be written in time are dropped (in ms)
+#define TRANSPORT_USB_WAIT          1500    // Time given to the computer to configure the USB (in ms)
+
+/**
+ * @brief Links to the computer
+ * @details     TRANSPORT_UART  UART3 at 115200 bauds, to the bluetooth module or the second com
+ *                              port of the programmer
+ *              TRANSPORT_USB   USB CDC (SDU1), no limit of the baud rate
+ *              TRANSPORT_AUTO  The USB if a computer configures it after the start, else the UART
+ */
+typedef enum{
+    TRANSPORT_UART=0,
+    TRANSPORT_USB,
+    TRANSPORT_AUTO
+}transportLink_t;
+
+/**
+ * @brief A backend of the transport, another one (a pseudo terminal on a computer for example)
+ *        can be given to mod_transport_initBackend
+ */
+typedef struct{
+    const char * name;
+    void (*start)(void);
+    bool (*isAttached)(void);                                           // NULL if always attached
+    size_t (*write)(const uint8_t * bytes, size_t size, uint32_t timeout);  // Timeout in ms
+    size_t (*read)(uint8_t * bytes, size_t size, uint32_t timeout);     // Returns after timeout if nothing is read
+    void (*flush)(void);                                                // Waits until all the bytes are sent
+}transportBackend_t;
+
+/**
+ * @brief Statistics of the transport since the init
+ */
+typedef struct{
+    uint32_t written;
+    uint32_t read;
+    uint32_t dropped;       // Bytes not written before TRANSPORT_WRITE_TIMEOUT
+}transportStats_t;
+
+/**
+ * @brief Start a link
+ * @note With TRANSPORT_AUTO, waits up to TRANSPORT_USB_WAIT for a computer on the USB
+ *
+ * @param[in] link      The link to use
+ */
+void mod_transport_init(transportLink_t link);
+
+/**
+ * @brief Start with another backend
+ *
+ * @param[in] backend   The backend, it must stay valid
+ */
+void mod_transport_initBackend(const transportBackend_t * backend);
+
+/**
+ * @brief Write bytes, waits while the link is busy
+ *
+ * @param[in] bytes     The bytes to write
+ * @param[in] size      The number of bytes
+ *
+ * @param[out]      The number of bytes written
+ */
+size_t mod_transport_write(const void * bytes, size_t size);
+
+/**
+ * @brief Read the received bytes
+ *
+ * @param[in] bytes     Where to write the bytes
+ * @param[in] size      The maximal number of bytes
+ * @param[in] timeout   The time to wait for them (in ms)
+ *
+ * @param[out]      The number of bytes read
+ */
+size_t mod_transport_read(uint8_t * bytes, size_t size, uint32_t timeout);
+
+/**
+ * @brief Wait until all the written bytes are sent
+ */
+void mod_transport_flush(void);
+
+/**
+ * @brief Returns the name of the link in use, NULL before the init
+ */
+const char * mod_transport_getName(void);
+
+/**
+ * @brief Returns the statistics of the transport
+ */
+transportStats_t mod_transport_getStats(void);
+
+#endif
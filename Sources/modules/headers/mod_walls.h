@@ -0,0 +1,108 @@
+/*
+ * File : mod_walls.h
+ * Project : e_puck_project
+ * Description : Module that estimates walls as straight lines from measured points, in one pass (total least squares)
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _MOD_WALLS_
+#define _MOD_WALLS_
+
+#include <stdbool.h>
+
+#include "mod_mapping.h"
+
+#define WALLS_MAX_LINES             4
+#define WALLS_MAX_CANDIDATES        8       // Lines followed during a sweep, objects make some of them
+#define WALLS_PENDING_POINTS        6       // Last points explained by no line, they start new ones
+
+/**
+ * @brief Straight line in normal form : x*cos(angle) + y*sin(angle) = distance
+ * @note Works for every orientation, vertical walls included
+ */
+typedef struct {
+    float angle;        // Angle of the normal (in rad)
+    float distance;     // Distance between the origin and the line (in mm, positive)
+    int inliers;        // Number of points that support the line
+} line_t;
+
+/**
+ * @brief Running sums of a set of points, enough to fit a line by total least squares
+ */
+typedef struct {
+    int number;
+    point_t reference;  // Sums are relative to this point to keep float precision
+    float sumX;
+    float sumY;
+    float sumXX;
+    float sumYY;
+    float sumXY;
+} lineFit_t;
+
+/**
+ * @brief Forget the lines of the last sweep
+ */
+void mod_walls_reset(void);
+
+/**
+ * @brief Add a new wall point to the running sums of its line, to call as measurements arrive
+ * @details The point joins the closest followed line, points explained by no line start a new one
+ *          when enough of them are aligned. Only the sums are kept, not the points
+ *
+ * @param[in] point     The point
+ */
+void mod_walls_addPoint(point_t point);
+
+/**
+ * @brief Returns the number of points added since the reset
+ *
+ * @param[out]      The number of points
+ */
+int mod_walls_getNumberOfPoints(void);
+
+/**
+ * @brief Returns the lines supported by the most points, the weak ones (objects...) are rejected
+ * @note Lines that were followed twice (both ends of a sweep) are merged first
+ *
+ * @param[in] lines     A table where to store lines, sorted by number of inliers
+ * @param[in] maxLines  The size of the table
+ *
+ * @param[out]      The number of found lines
+ */
+int mod_walls_findLines(line_t * lines, int maxLines);
+
+/**
+ * @brief Empty running sums
+ *
+ * @param[in] fit       The sums to reset
+ */
+void mod_walls_fitReset(lineFit_t * fit);
+
+/**
+ * @brief Add a point to running sums
+ *
+ * @param[in] fit       The sums
+ * @param[in] point     The point to add
+ */
+void mod_walls_fitAdd(lineFit_t * fit, point_t point);
+
+/**
+ * @brief Compute the total least squares line of running sums
+ *
+ * @param[in] fit       The sums (at least two points)
+ *
+ * @param[out]      The line
+ */
+line_t mod_walls_fitLine(const lineFit_t * fit);
+
+/**
+ * @brief Add the points of running sums to other ones
+ *
+ * @param[in] fit       The sums to complete
+ * @param[in] other     The sums to add
+ */
+void mod_walls_fitMerge(lineFit_t * fit, const lineFit_t * other);
+
+#endif
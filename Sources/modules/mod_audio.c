@@ -16,38 +16,52 @@
 #include <ch.h>
 #include "audio/play_melody.h"
 #include "audio/microphone.h"
-#include "fft.h"
 #include <arm_math.h>
 
 // Our headers
 #include "mod_errors.h"
 #include "mod_communication.h"
 #include "mod_check.h"
+#include "mod_stft.h"
+#include "mod_beamforming.h"
 
 
-// Frequences for sound detection after FFT
+// Frequences of the commands, as bins of a 1024 points FFT at 16 kHz
 #define FFT_SIZE                1024
 
-#define MIN_VALUE_THRESHOLD     150000
-
-#define MIN_FREQ                30
 #define FREQ_CMD_DISCOVERING    33    //400Hz
 #define FREQ_CMD_EXPLORATION    39    //500Hz
 #define FREQ_CMD_MAPSEND        46    //600HZ
 #define FREQ_CMD_SING           52    //700HZ
 #define FREQ_CMD_CALIBRATION    59    //800HZ
-#define MAX_FREQ                62
-
-#define FREQ_CMD_DISCOVERING_L  (FREQ_CMD_DISCOVERING-1)
-#define FREQ_CMD_DISCOVERING_H  (FREQ_CMD_DISCOVERING+1)
-#define FREQ_CMD_EXPLORATION_L  (FREQ_CMD_EXPLORATION-1)
-#define FREQ_CMD_EXPLORATION_H  (FREQ_CMD_EXPLORATION+1)
-#define FREQ_CMD_MAPSEND_L      (FREQ_CMD_MAPSEND-1)
-#define FREQ_CMD_MAPSEND_H      (FREQ_CMD_MAPSEND+1)
-#define FREQ_CMD_SING_L         (FREQ_CMD_SING-1)
-#define FREQ_CMD_SING_H         (FREQ_CMD_SING+1)
-#define FREQ_CMD_CALIBRATION_L  (FREQ_CMD_CALIBRATION-1)
-#define FREQ_CMD_CALIBRATION_H  (FREQ_CMD_CALIBRATION+1)
+
+// Detection on the delay and sum of the four microphones instead of the front one
+#define USE_BEAMFORMING         1
+#define BEAM_BUFFER_SIZE        160     // Samples of each microphone in a buffer (10 ms)
+
+// Detection on overlapping STFT frames (at each hop) instead of the Goertzel filter bank, can be given by the build
+#ifndef USE_STFT
+#define USE_STFT                1
+#endif
+
+// Goertzel filter banks, updated at each sample
+#define NUMBER_OF_COMMANDS      5
+#define USE_NEIGHBOUR_BINS      1       // Also listen to the bins at +-1 of each command
+#define BINS_PER_COMMAND        (USE_NEIGHBOUR_BINS ? 3 : 1)
+#define NUMBER_OF_FILTERS       (NUMBER_OF_COMMANDS*BINS_PER_COMMAND)
+#define BLOCK_SIZE              FFT_SIZE    // Samples of a Hann windowed frame (64 ms), the bins are its own
+#define NUMBER_OF_BANKS         2       // Banks on frames overlapping by half, a decision every hop
+#define HOP_SIZE                (BLOCK_SIZE/NUMBER_OF_BANKS)    // 32 ms
+
+#define MIN_POWER               (75000.0f*75000.0f)  // Same level as the former FFT magnitude threshold
+#define DETECTION_RATIO         8.0f    // Power of a command above the noise floor
+#define NOISE_FLOOR_UPDATE      0.1f    // Weight of a new block in the noise floor
+// Consecutive hops with the same command before it is accepted, the overlapping frames of two hops are not independent
+#if USE_STFT
+#define CONFIRMATION_BLOCKS     5       // Hops of 16 ms, with 4 the sweeps at 2000 Hz/s trigger
+#else
+#define CONFIRMATION_BLOCKS     3       // Hops of 32 ms, with 2 some weak tones are missed
+#endif
 
 /********************
  *  Public variables
@@ -62,102 +76,188 @@ command_t mod_audio_processedCommand;
  *  Private variables
  */
 
-static float * micFront_cmplx_input;
-static float * micFront_output;
-//static int measureNumber;
+static const command_t commands[NUMBER_OF_COMMANDS] = {CMD_DISCOVERING, CMD_EXPLORATION, CMD_MAPSEND,
+                                                       CMD_SING, CMD_CALIBRATION};
+static const int commandBins[NUMBER_OF_COMMANDS] = {FREQ_CMD_DISCOVERING, FREQ_CMD_EXPLORATION, FREQ_CMD_MAPSEND,
+                                                    FREQ_CMD_SING, FREQ_CMD_CALIBRATION};
+
+static float goertzelCoefficient[NUMBER_OF_FILTERS];
+static float goertzelState1[NUMBER_OF_BANKS][NUMBER_OF_FILTERS];
+static float goertzelState2[NUMBER_OF_BANKS][NUMBER_OF_FILTERS];
+#if !USE_STFT
+static float goertzelWindow[BLOCK_SIZE];
+#endif
+static float noiseFloor = MIN_POWER/DETECTION_RATIO;
+static float beam[BEAM_BUFFER_SIZE];
 
 /********************
  *  Private functions
  */
 
 /**
- * @brief Function used to detect the highest value
+ * @brief Compute the coefficients of the Goertzel filters and the window, restart all the banks
+ */
+void initGoertzelBank(void);
+
+/**
+ * @brief Returns the power of each command at the end of the frame of a bank and restart its filters
  *
- * @note Inspired from processAudioData function of TP5
+ * @param[in] bank      The bank at the end of its frame
+ * @param[in] powers    Where to store the power of each command (the highest of its bins)
  */
-void action_detection(float* data){
-    float max_norm = MIN_VALUE_THRESHOLD;
-    int16_t max_norm_index = -1;
-    
-    
-    //search for the highest peak
-    for(uint16_t i = MIN_FREQ ; i <= MAX_FREQ ; i++){
-        if(data[i] > max_norm){
-            max_norm = data[i];
-            max_norm_index = i;
-            
+void readGoertzelBank(int bank, float * powers);
+
+/**
+ * @brief Returns the power of each command in the last STFT spectrum
+ *
+ * @param[in] powers    Where to store the power of each command (the highest of its bins)
+ */
+void readStftPowers(float * powers);
+
+/**
+ * @brief Choose the command of a block from the powers, and update the noise floor
+ *
+ * @param[in] powers    The power of each command
+ *
+ * @param[out] The detected command, NOTHING if no command is above the noise floor
+ */
+command_t action_detection(const float * powers);
+
+/***************/
+
+
+void initGoertzelBank(void){
+    for(int i = 0; i < NUMBER_OF_FILTERS; i++){
+        int bin = commandBins[i/BINS_PER_COMMAND] + (USE_NEIGHBOUR_BINS ? (i%BINS_PER_COMMAND - 1) : 0);
+        goertzelCoefficient[i] = 2*arm_cos_f32(2*PI*bin/FFT_SIZE);
+        for(int bank = 0; bank < NUMBER_OF_BANKS; bank++){
+            goertzelState1[bank][i] = 0;
+            goertzelState2[bank][i] = 0;
         }
     }
-    
-    if(max_norm_index >= FREQ_CMD_DISCOVERING_L && max_norm_index <= FREQ_CMD_DISCOVERING_H){
-        mod_audio_processedCommand = CMD_DISCOVERING;
+#if !USE_STFT
+    // Same gain on a command as the former rectangular block of 512 samples
+    for(int i = 0; i < BLOCK_SIZE; i++){
+        goertzelWindow[i] = 0.5f - 0.5f*arm_cos_f32(2*PI*i/BLOCK_SIZE);
     }
-    
-    else if(max_norm_index >= FREQ_CMD_EXPLORATION_L && max_norm_index <= FREQ_CMD_EXPLORATION_H){
-        mod_audio_processedCommand = CMD_EXPLORATION;
+#endif
+}
+
+
+void readGoertzelBank(int bank, float * powers){
+    for(int command = 0; command < NUMBER_OF_COMMANDS; command++){
+        powers[command] = 0;
     }
-    else if(max_norm_index >= FREQ_CMD_MAPSEND_L && max_norm_index <= FREQ_CMD_MAPSEND_H){
-        mod_audio_processedCommand = CMD_MAPSEND;
+    float * state1 = goertzelState1[bank];
+    float * state2 = goertzelState2[bank];
+    for(int i = 0; i < NUMBER_OF_FILTERS; i++){
+        float power = state1[i]*state1[i] + state2[i]*state2[i] - goertzelCoefficient[i]*state1[i]*state2[i];
+        if(power > powers[i/BINS_PER_COMMAND]) powers[i/BINS_PER_COMMAND] = power;
+        state1[i] = 0;
+        state2[i] = 0;
     }
-    else if(max_norm_index >= FREQ_CMD_SING_L && max_norm_index <= FREQ_CMD_SING_H){
-        mod_audio_processedCommand = CMD_SING;
+}
+
+
+void readStftPowers(float * powers){
+    const float * spectrum = mod_stft_getPowers();
+    for(int command = 0; command < NUMBER_OF_COMMANDS; command++){
+        int bin = commandBins[command];
+        powers[command] = spectrum[bin];
+        if(USE_NEIGHBOUR_BINS){
+            powers[command] = fmaxf(powers[command], fmaxf(spectrum[bin - 1], spectrum[bin + 1]));
+        }
     }
-    else if(max_norm_index >= FREQ_CMD_CALIBRATION_L && max_norm_index <= FREQ_CMD_CALIBRATION_H){
-        mod_audio_processedCommand = CMD_CALIBRATION;
+}
+
+
+command_t action_detection(const float * powers){
+    int best = 0;
+    float sum = 0;
+    for(int command = 0; command < NUMBER_OF_COMMANDS; command++){
+        sum += powers[command];
+        if(powers[command] > powers[best]) best = command;
     }
-    else{
-        mod_audio_processedCommand = NOTHING;
+
+    // The other commands give the noise level of this block
+    float noise = (sum - powers[best])/(NUMBER_OF_COMMANDS - 1);
+    if(powers[best] < MIN_POWER || powers[best] < DETECTION_RATIO*fmaxf(noiseFloor, noise)){
+        noiseFloor += NOISE_FLOOR_UPDATE*(sum/NUMBER_OF_COMMANDS - noiseFloor);
+        return NOTHING;
     }
+    noiseFloor += NOISE_FLOOR_UPDATE*(noise - noiseFloor);
+    return commands[best];
 }
 
 
 /**
  * @brief Callback that process audio datas to extract desired command
  *
- * @note Inspired from processAudioData function of TP5
+ * @note    Each sample of the beamformer (or of the front microphone) goes windowed in the Goertzel banks
+ *          (or in the STFT ring buffer), a decision is taken at each hop on the frame that ends there
  */
 void processDatas(int16_t *data, uint16_t num_samples){
     if(needAudio == false){
         return;
     }
     
+#if !USE_STFT
     static uint16_t nb_samples = 0;
-    static uint8_t process = 0;
-    assert(micFront_cmplx_input);
-    // Get samples in a complex array
+#endif
+    static command_t lastCommand = NOTHING;
+    static uint8_t confirmations = 0;
+    
+#if USE_BEAMFORMING
+    if(num_samples > 4*BEAM_BUFFER_SIZE) num_samples = 4*BEAM_BUFFER_SIZE;
+    mod_beam_process(data, num_samples, beam);
+#endif
+    
     for(uint16_t i = 0 ; i < num_samples ; i+=4){
-        micFront_cmplx_input[nb_samples] = (float)data[i+3];
+        float powers[NUMBER_OF_COMMANDS];
+#if USE_BEAMFORMING
+        float sample = beam[i/4];
+#else
+        float sample = (float)data[i+3];
+#endif
+#if USE_STFT
+        if(!mod_stft_addSample((int16_t)sample)) continue;
+        readStftPowers(powers);
+#else
+        for(int bank = 0; bank < NUMBER_OF_BANKS; bank++){
+            float windowed = sample*goertzelWindow[(nb_samples + bank*HOP_SIZE) % BLOCK_SIZE];
+            float * state1 = goertzelState1[bank];
+            float * state2 = goertzelState2[bank];
+            for(int filter = 0; filter < NUMBER_OF_FILTERS; filter++){
+                float state = windowed + goertzelCoefficient[filter]*state1[filter] - state2[filter];
+                state2[filter] = state1[filter];
+                state1[filter] = state;
+            }
+        }
+        nb_samples = (nb_samples + 1) % BLOCK_SIZE;
         
-        nb_samples++;
-        micFront_cmplx_input[nb_samples] = 0;
-        nb_samples++;
+        if(nb_samples % HOP_SIZE != 0) continue;
+        // The frame of a bank starts at nb_samples + bank*HOP_SIZE = 0 modulo BLOCK_SIZE
+        readGoertzelBank((NUMBER_OF_BANKS - nb_samples/HOP_SIZE) % NUMBER_OF_BANKS, powers);
+#endif
         
-        //stop storing when buffer is full
-        if(nb_samples >= (2 * FFT_SIZE)){
-            break;
-        }
-    }
-    assert(micFront_output);
-    // Process when buffer is full
-    if(nb_samples >= (2 * FFT_SIZE)){
-        // FFT Processing
-        doFFT_optimized(FFT_SIZE, micFront_cmplx_input);
+        command_t command = action_detection(powers);
+        confirmations = (command == lastCommand) ? confirmations + 1 : 1;
+        lastCommand = command;
         
-        // Magnitude processing
-        arm_cmplx_mag_f32(micFront_cmplx_input, micFront_output, FFT_SIZE);
-        if(process > 8){
-            action_detection(micFront_output);
-            process = 0;
-            if(mod_audio_processedCommand != NOTHING){
-                needAudio = false;
-                nb_samples = 0;
-                chBSemSignal(&mod_audio_sem_commandAvailable);
-                return;
-            }
-            
+        if(command != NOTHING && confirmations >= CONFIRMATION_BLOCKS){
+            mod_audio_processedCommand = command;
+            needAudio = false;
+            lastCommand = NOTHING;
+            confirmations = 0;
+#if USE_STFT
+            mod_stft_init();
+#else
+            nb_samples = 0;
+            initGoertzelBank();
+#endif
+            chBSemSignal(&mod_audio_sem_commandAvailable);
+            return;
         }
-        nb_samples = 0;
-        process++;
     }
 }
 
@@ -168,8 +268,11 @@ void processDatas(int16_t *data, uint16_t num_samples){
  */
 
 void mod_audio_initModule(void){
-    micFront_cmplx_input = malloc(sizeof(float)*2 * FFT_SIZE);
-    micFront_output = malloc(sizeof(float) * FFT_SIZE);
+    mod_beam_init();
+#if USE_STFT
+    mod_stft_init();
+#endif
+    initGoertzelBank();
     needAudio = false;
     play_melody_start();
 }
@@ -216,3 +319,8 @@ void mod_audio_listenForSound(void){
 void  mod_audio_waitUntilMelodyEnd(void){
     wait_until_melody_end();
 }
+
+
+bool mod_audio_getOperatorDirection(float * angle){
+    return mod_beam_getDirection(angle);
+}
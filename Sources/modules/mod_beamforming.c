@@ -0,0 +1,268 @@
+/*
+ * File : mod_beamforming.c
+ * Project : e_puck_project
+ * Description : Module that combines the four microphones (delay and sum) and estimates the direction of a sound (GCC-PHAT)
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_beamforming.h"
+
+// Standard headers
+#include <math.h>
+
+// Epuck/ChibiOS headers
+#include <ch.h>
+#include <arm_math.h>
+
+#define SAMPLING_FREQUENCY          16000
+#define SOUND_SPEED                 343000.0f   // (in mm/s)
+
+#define NUMBER_OF_PAIRS             6
+#define GCC_INTERPOLATION           4       // The correlation is computed on quarters of samples
+#define GCC_SIZE                    (BEAM_DOA_FFT_SIZE*GCC_INTERPOLATION)
+#define GCC_MAX_LAG                 16      // Largest delay between two microphones (in quarters of samples, 85 mm)
+
+#define DOA_MIN_FREQUENCY           300     // Band used for the direction (in Hz)
+#define DOA_MAX_FREQUENCY           4000
+#define DOA_MIN_BIN                 (DOA_MIN_FREQUENCY*BEAM_DOA_FFT_SIZE/SAMPLING_FREQUENCY)
+#define DOA_MAX_BIN                 (DOA_MAX_FREQUENCY*BEAM_DOA_FFT_SIZE/SAMPLING_FREQUENCY)
+// Band power of a tone of amplitude 115 through the 256 point Hann window, 8 dB under the command threshold
+// of mod_audio (75000 on its 1024 point frames, a tone of amplitude 293): a detected command is always located
+#define DOA_MIN_POWER               (9000.0f*9000.0f)
+#define DOA_BIN_SELECTION           0.1f    // Bins 10 dB under the strongest one are not whitened
+#define DOA_MIN_COHERENCE           0.5f    // Of the best direction, 1 when all pairs agree perfectly
+
+#define BEAM_HISTORY                8       // Samples kept for the delays, a power of 2
+
+
+// Approximative positions of the microphones (in mm, forward and to the left of the center)
+static const float micForward[BEAM_NUMBER_OF_MICS] = {0, 0, -25, 25};
+static const float micLeft[BEAM_NUMBER_OF_MICS] = {-30, 30, 0, 0};
+static const uint8_t pairs[NUMBER_OF_PAIRS][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+
+// Beamformer
+static float history[BEAM_NUMBER_OF_MICS][BEAM_HISTORY];
+static int historyIndex = 0;
+static float delays[BEAM_NUMBER_OF_MICS];     // (in samples)
+
+// Direction of arrival, all buffers are preallocated
+static int16_t frames[BEAM_NUMBER_OF_MICS][BEAM_DOA_FFT_SIZE];
+static int frameFill = 0;
+static float window[BEAM_DOA_FFT_SIZE];
+static float fftInput[BEAM_DOA_FFT_SIZE];
+static float spectra[BEAM_NUMBER_OF_MICS][BEAM_DOA_FFT_SIZE];
+static float crossSpectrum[GCC_SIZE];
+static float correlation[GCC_SIZE];
+static float magnitudes[DOA_MAX_BIN + 1];
+static float pairCorrelation[NUMBER_OF_PAIRS][2*GCC_MAX_LAG + 1];
+static int8_t lagTable[BEAM_DOA_DIRECTIONS][NUMBER_OF_PAIRS];
+static arm_rfft_fast_instance_f32 frameFft;
+static arm_rfft_fast_instance_f32 correlationFft;
+
+static float lastDirection = 0;
+static bool hasDirection = false;
+static systime_t directionTime = 0;
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Returns the delay of a microphone for a sound coming from a direction
+ *
+ * @param[in] mic       The microphone
+ * @param[in] angle     The direction of the sound (in rad, positive to the left)
+ *
+ * @param[out] The time of arrival relative to the center of the robot (in samples)
+ */
+float computeArrivalTime(int mic, float angle);
+
+/**
+ * @brief Compute the GCC-PHAT of each pair around the null delay from the spectra of the frames
+ *
+ * @param[out] False if the frame is too quiet to be located
+ */
+bool computeCorrelations(void);
+
+/**
+ * @brief Estimate the direction of the last frame from the correlations (steered response power)
+ *
+ * @param[out] False if the pairs do not agree on a direction
+ */
+bool estimateDirection(void);
+
+/***************/
+
+
+float computeArrivalTime(int mic, float angle){
+    float projection = micForward[mic]*arm_cos_f32(angle) + micLeft[mic]*arm_sin_f32(angle);
+    return -projection*SAMPLING_FREQUENCY/SOUND_SPEED;
+}
+
+
+bool computeCorrelations(void){
+    float power = 0;
+    for(int mic = 0; mic < BEAM_NUMBER_OF_MICS; mic++){
+        for(int i = 0; i < BEAM_DOA_FFT_SIZE; i++){
+            fftInput[i] = frames[mic][i]*window[i];
+        }
+        arm_rfft_fast_f32(&frameFft, fftInput, spectra[mic], 0);
+
+        float micPower;
+        arm_power_f32(&spectra[mic][2*DOA_MIN_BIN], 2*(DOA_MAX_BIN - DOA_MIN_BIN + 1), &micPower);
+        power += micPower/BEAM_NUMBER_OF_MICS;
+    }
+    if(power < DOA_MIN_POWER) return false;
+
+    for(int pair = 0; pair < NUMBER_OF_PAIRS; pair++){
+        float * first = spectra[pairs[pair][0]];
+        float * second = spectra[pairs[pair][1]];
+
+        // Cross spectrum of the band, the other bins stay at zero (interpolation of the correlation)
+        arm_fill_f32(0, crossSpectrum, GCC_SIZE);
+        arm_cmplx_conj_f32(&second[2*DOA_MIN_BIN], &correlation[2*DOA_MIN_BIN], DOA_MAX_BIN - DOA_MIN_BIN + 1);
+        arm_cmplx_mult_cmplx_f32(&first[2*DOA_MIN_BIN], &correlation[2*DOA_MIN_BIN],
+                                 &crossSpectrum[2*DOA_MIN_BIN], DOA_MAX_BIN - DOA_MIN_BIN + 1);
+
+        // Phase transform : the strong bins get the same weight, the others are ignored
+        float strongest;
+        uint32_t index;
+        arm_cmplx_mag_f32(&crossSpectrum[2*DOA_MIN_BIN], &magnitudes[DOA_MIN_BIN], DOA_MAX_BIN - DOA_MIN_BIN + 1);
+        arm_max_f32(&magnitudes[DOA_MIN_BIN], DOA_MAX_BIN - DOA_MIN_BIN + 1, &strongest, &index);
+
+        int usedBins = 0;
+        for(int bin = DOA_MIN_BIN; bin <= DOA_MAX_BIN; bin++){
+            float weight = 0;
+            if(magnitudes[bin] > DOA_BIN_SELECTION*strongest){
+                weight = 1/magnitudes[bin];
+                usedBins++;
+            }
+            crossSpectrum[2*bin] *= weight;
+            crossSpectrum[2*bin + 1] *= weight;
+        }
+        if(usedBins == 0) return false;
+
+        arm_rfft_fast_f32(&correlationFft, crossSpectrum, correlation, 1);
+
+        // Scaled so that the peak is 1 for identical signals, delays are at the end of the buffer if negative
+        float scale = GCC_SIZE/(2.0f*usedBins);
+        for(int lag = -GCC_MAX_LAG; lag <= GCC_MAX_LAG; lag++){
+            pairCorrelation[pair][lag + GCC_MAX_LAG] = correlation[(lag + GCC_SIZE) % GCC_SIZE]*scale;
+        }
+    }
+    return true;
+}
+
+
+bool estimateDirection(void){
+    int best = 0;
+    float bestPower = -NUMBER_OF_PAIRS;
+    for(int direction = 0; direction < BEAM_DOA_DIRECTIONS; direction++){
+        float power = 0;
+        for(int pair = 0; pair < NUMBER_OF_PAIRS; pair++){
+            power += pairCorrelation[pair][lagTable[direction][pair] + GCC_MAX_LAG];
+        }
+        if(power > bestPower){
+            bestPower = power;
+            best = direction;
+        }
+    }
+    if(bestPower < DOA_MIN_COHERENCE*NUMBER_OF_PAIRS) return false;
+
+    float angle = 2*PI*best/BEAM_DOA_DIRECTIONS;
+    if(angle > PI) angle -= 2*PI;
+    lastDirection = angle;
+    directionTime = chVTGetSystemTime();
+    hasDirection = true;
+    if(BEAM_FOLLOW_DOA) mod_beam_steer(angle);
+    return true;
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_beam_init(void){
+    arm_rfft_fast_init_f32(&frameFft, BEAM_DOA_FFT_SIZE);
+    arm_rfft_fast_init_f32(&correlationFft, GCC_SIZE);
+
+    for(int i = 0; i < BEAM_DOA_FFT_SIZE; i++){
+        window[i] = 0.5f - 0.5f*arm_cos_f32(2*PI*i/BEAM_DOA_FFT_SIZE);
+    }
+
+    // The correlation of a pair peaks at the difference of the arrival times
+    for(int direction = 0; direction < BEAM_DOA_DIRECTIONS; direction++){
+        float angle = 2*PI*direction/BEAM_DOA_DIRECTIONS;
+        for(int pair = 0; pair < NUMBER_OF_PAIRS; pair++){
+            float lag = GCC_INTERPOLATION*(computeArrivalTime(pairs[pair][0], angle) -
+                                           computeArrivalTime(pairs[pair][1], angle));
+            lagTable[direction][pair] = (int8_t) fmaxf(-GCC_MAX_LAG, fminf(GCC_MAX_LAG, roundf(lag)));
+        }
+    }
+
+    for(int mic = 0; mic < BEAM_NUMBER_OF_MICS; mic++){
+        for(int i = 0; i < BEAM_HISTORY; i++) history[mic][i] = 0;
+    }
+    historyIndex = 0;
+    frameFill = 0;
+    hasDirection = false;
+    mod_beam_steer(0);
+}
+
+
+bool mod_beam_process(const int16_t * data, uint16_t numSamples, float * beam){
+    bool newDirection = false;
+
+    for(uint16_t i = 0; i < numSamples; i += BEAM_NUMBER_OF_MICS){
+        // Delay and sum : each microphone is delayed to the latest one, with a linear interpolation
+        historyIndex = (historyIndex + 1) % BEAM_HISTORY;
+        float sum = 0;
+        for(int mic = 0; mic < BEAM_NUMBER_OF_MICS; mic++){
+            history[mic][historyIndex] = data[i + mic];
+
+            int integer = (int) delays[mic];
+            float fraction = delays[mic] - integer;
+            float newer = history[mic][(historyIndex - integer + BEAM_HISTORY) % BEAM_HISTORY];
+            float older = history[mic][(historyIndex - integer - 1 + BEAM_HISTORY) % BEAM_HISTORY];
+            sum += newer + fraction*(older - newer);
+        }
+        beam[i/BEAM_NUMBER_OF_MICS] = sum/BEAM_NUMBER_OF_MICS;
+
+        for(int mic = 0; mic < BEAM_NUMBER_OF_MICS; mic++){
+            frames[mic][frameFill] = data[i + mic];
+        }
+        if(++frameFill < BEAM_DOA_FFT_SIZE) continue;
+        frameFill = 0;
+
+        if(computeCorrelations() && estimateDirection()){
+            newDirection = true;
+        }
+    }
+    return newDirection;
+}
+
+
+void mod_beam_steer(float angle){
+    float arrivals[BEAM_NUMBER_OF_MICS];
+    float latest = -INFINITY;
+    for(int mic = 0; mic < BEAM_NUMBER_OF_MICS; mic++){
+        arrivals[mic] = computeArrivalTime(mic, angle);
+        latest = fmaxf(latest, arrivals[mic]);
+    }
+
+    chSysLock();
+    for(int mic = 0; mic < BEAM_NUMBER_OF_MICS; mic++){
+        delays[mic] = latest - arrivals[mic];
+    }
+    chSysUnlock();
+}
+
+
+bool mod_beam_getDirection(float * angle){
+    *angle = lastDirection;
+    // An old estimate is not the one of the last command
+    return hasDirection && chVTGetSystemTime() - directionTime < MS2ST(BEAM_DIRECTION_MAX_AGE);
+}
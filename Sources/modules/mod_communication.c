@@ -11,45 +11,440 @@
 #include "headers/mod_communication.h"
 
 // Standard headers
-#include <stdio.h>
 #include <string.h>
 
 // Epuck/ChibiOS headers
 #include <ch.h>
 #include <hal.h>
-#include <chprintf.h>
-
+#include "cmp_mem_access/cmp_mem_access.h"
+#include "serial-datagram/serial_datagram.h"
 
 // Our headers
-#include "mod_check.h"
-#include "mod_secure_conv.h"
+#include "mod_log.h"
+#include "mod_reliable.h"
+#include "mod_transport.h"
+
 
 
+#define DATAGRAM_SIZE               (COM_CHUNK_SIZE + 64)   // Chunk and fields of a bulk message
+#define RX_DATAGRAM_SIZE            32      // Acknowledgements are the only received messages
+#define RX_READ_SIZE                16
+#define RX_READ_TIMEOUT             10      // (in ms)
+#define BULK_NAME_SIZE              16
+#define LOG_FLUSH_PERIOD            100     // The log records are sent in batches (in ms)
+#define LOG_BATCH_SIZE              16      // Records in a datagram
 
-#define SEPARATOR_SIZE              2
-#define UNSIGNED_INT_IN_CHAR_SIZE   6
-#define NULL_CHAR_SIZE              1
-#define SERIAL_BIT_RATE             115200
+#define CONTROL_SLOTS               8
+#define TELEMETRY_SLOTS             16
+#define LOG_SLOTS                   16
+#define NUMBER_OF_SLOTS             (CONTROL_SLOTS + TELEMETRY_SLOTS + LOG_SLOTS)
+#define NUMBER_OF_QUEUES            3       // The lanes before COM_LANE_BULK
 
 #define DISPLAY_LEVEL               1
 
+/**
+ * @brief What a lane does with a new message when it is full
+ */
+typedef enum{
+    DROP_NEWEST=0,
+    DROP_OLDEST
+}dropPolicy_t;
+
+/**
+ * @brief An encoded message, waiting to be framed and sent
+ */
+typedef struct{
+    uint16_t size;
+    uint8_t payload[COM_MESSAGE_SIZE];
+}message_t;
+
+/**
+ * @brief The free messages and the ones waiting to be sent
+ */
+typedef struct{
+    mailbox_t free;
+    mailbox_t pending;
+    dropPolicy_t policy;
+}lane_t;
+
+/**
+ * @brief A picture or datas sent in chunks, they are not copied
+ */
+typedef struct{
+    comMessage_t type;
+    char name[BULK_NAME_SIZE];
+    int x;
+    int y;
+    imageCodec_t codec;
+    const uint8_t * datas;
+    size_t size;
+    reliableSender_t sender;    // Which chunk to send, shared with the reception thread
+}bulkTransfer_t;
+
+static const int laneSlots[NUMBER_OF_QUEUES] = {CONTROL_SLOTS, TELEMETRY_SLOTS, LOG_SLOTS};
+static const dropPolicy_t lanePolicies[NUMBER_OF_QUEUES] = {DROP_NEWEST, DROP_OLDEST, DROP_NEWEST};
+
+// Messages are preallocated, each lane has its part of the pool
+static message_t messagesPool[NUMBER_OF_SLOTS];
+static msg_t mailboxBuffers[2*NUMBER_OF_SLOTS];
+static lane_t lanes[NUMBER_OF_QUEUES];
+static comLaneStats_t stats[COM_NUMBER_OF_LANES];
+static bool isStarted = false;
+
+// Only one bulk transfer at a time, encoded by the transmission thread
+static bulkTransfer_t bulk;
+static bool bulkActive = false;
+static uint16_t lastTransfer = 0;
+static char datagram[DATAGRAM_SIZE];
+static uint8_t rxDatagram[RX_DATAGRAM_SIZE];
+static logRecord_t batch[LOG_BATCH_SIZE];
+BSEMAPHORE_DECL(bulkFree_sem, false);
+BSEMAPHORE_DECL(txWork_sem, true);
+
+
 /********************
  *  Private functions
  */
 
 /**
- * @brief Load parameters and start serial drivers
+ * @brief Write bytes of a datagram on the link, used by serial_datagram_send
+ */
+void sendToLink(void * arg, const void * bytes, size_t size);
+
+/**
+ * @brief Take a free message of a lane and start to encode it, never waits
+ *
+ * @param[in] lane              The lane of the message
+ * @param[in] type              The type of the message
+ * @param[in] numberOfFields    The number of fields after the type
+ * @param[in] cmp               The MessagePack context to initialize
+ * @param[in] memory            The buffer access of the context
+ *
+ * @param[out] The message, NULL if it is dropped
+ */
+message_t * startMessage(comLane_t lane, comMessage_t type, uint32_t numberOfFields,
+                         cmp_ctx_t * cmp, cmp_mem_access_t * memory);
+
+/**
+ * @brief Give an encoded message to the transmission thread
+ *
+ * @param[in] lane      The lane of the message
+ * @param[in] message   The message
+ * @param[in] memory    The buffer access used to encode it
+ * @param[in] error     True if a field could not be written, the message is given back to the lane
+ */
+void postMessage(comLane_t lane, message_t * message, cmp_mem_access_t * memory, bool error);
+
+/**
+ * @brief Returns the first waiting message, by priority of the lanes
+ *
+ * @param[in] lane      Where to store the lane of the message
+ *
+ * @param[out] The message, NULL if all lanes are empty
+ */
+message_t * takeMessage(comLane_t * lane);
+
+/**
+ * @brief Start a bulk transfer, waits until the previous one is finished
+ *
+ * @param[in] type      MSG_IMAGE or MSG_DATA
+ * @param[in] name      The name of the datas (MSG_DATA)
+ * @param[in] x, y      The position of the object (MSG_IMAGE)
+ * @param[in] codec     The codec of the picture (MSG_IMAGE)
+ * @param[in] datas     The datas to send
+ * @param[in] size      The size of the datas (in bytes)
+ */
+void startBulk(comMessage_t type, const char * name, int x, int y, imageCodec_t codec,
+               const uint8_t * datas, size_t size);
+
+/**
+ * @brief Send a chunk of the bulk transfer
+ *
+ * @param[in] chunk     The number of the chunk
+ */
+void sendBulkChunk(int chunk);
+
+/**
+ * @brief Release the bulk lane when all the chunks are acknowledged or when the transfer failed
+ */
+void endBulk(void);
+
+/**
+ * @brief Handle a datagram received from the computer, used by serial_datagram_receive
+ */
+void receiveDatagram(const void * bytes, size_t size, void * arg);
+
+/**
+ * @brief Send the waiting records of mod_log in one datagram
+ *
+ * @param[out] The number of records sent, LOG_BATCH_SIZE if some records may still be waiting
  */
-static void serial_start(void)
-{
-    static SerialConfig ser_cfg = {
-        SERIAL_BIT_RATE,
-        0,
-        0,
-        0,
-    };
-    
-    sdStart(&SD3, &ser_cfg); // UART3. Connected to the second com port of the programmer
+int sendLogRecords(void);
+
+/***************/
+
+
+void sendToLink(void * arg, const void * bytes, size_t size){
+    (void) arg;
+    (void)mod_transport_write(bytes, size);
+}
+
+
+message_t * startMessage(comLane_t lane, comMessage_t type, uint32_t numberOfFields,
+                         cmp_ctx_t * cmp, cmp_mem_access_t * memory){
+    if(!isStarted) return NULL;
+
+    msg_t slot;
+    chSysLock();
+    if(chMBFetchI(&lanes[lane].free, &slot) != MSG_OK){
+        stats[lane].dropped++;
+        if(lanes[lane].policy != DROP_OLDEST || chMBFetchI(&lanes[lane].pending, &slot) != MSG_OK){
+            chSysUnlock();
+            return NULL;
+        }
+    }
+    chSysUnlock();
+
+    message_t * message = (message_t *) slot;
+    cmp_mem_access_init(cmp, memory, message->payload, sizeof(message->payload));
+    cmp_write_array(cmp, numberOfFields + 1);
+    cmp_write_uint(cmp, type);
+    return message;
+}
+
+
+void postMessage(comLane_t lane, message_t * message, cmp_mem_access_t * memory, bool error){
+    message->size = cmp_mem_access_get_pos(memory);
+
+    chSysLock();
+    if(error){
+        stats[lane].dropped++;
+        (void)chMBPostI(&lanes[lane].free, (msg_t) message);
+    }
+    else{
+        // Both mailboxes have room for all the messages of the lane
+        (void)chMBPostI(&lanes[lane].pending, (msg_t) message);
+        stats[lane].posted++;
+        cnt_t pending = chMBGetUsedCountI(&lanes[lane].pending);
+        if(pending > stats[lane].maxPending) stats[lane].maxPending = pending;
+        chBSemSignalI(&txWork_sem);
+        chSchRescheduleS();
+    }
+    chSysUnlock();
+}
+
+
+message_t * takeMessage(comLane_t * lane){
+    msg_t slot;
+    chSysLock();
+    for(int i = 0; i < NUMBER_OF_QUEUES; i++){
+        if(chMBFetchI(&lanes[i].pending, &slot) == MSG_OK){
+            chSysUnlock();
+            *lane = i;
+            return (message_t *) slot;
+        }
+    }
+    chSysUnlock();
+    return NULL;
+}
+
+
+void startBulk(comMessage_t type, const char * name, int x, int y, imageCodec_t codec,
+               const uint8_t * datas, size_t size){
+    if(!isStarted || size == 0) return;
+
+    chSysLock();
+    if(bulkActive) stats[COM_LANE_BULK].waits++;
+    chSysUnlock();
+    chBSemWait(&bulkFree_sem);
+
+    bulk.type = type;
+    strncpy(bulk.name, (name != NULL) ? name : "", BULK_NAME_SIZE - 1);
+    bulk.name[BULK_NAME_SIZE - 1] = '\0';
+    bulk.x = x;
+    bulk.y = y;
+    bulk.codec = codec;
+    bulk.datas = datas;
+    bulk.size = size;
+
+    chSysLock();
+    mod_reliable_start(&bulk.sender, ++lastTransfer, size, COM_CHUNK_SIZE, ST2MS(chVTGetSystemTimeX()));
+    bulkActive = true;
+    stats[COM_LANE_BULK].posted++;
+    stats[COM_LANE_BULK].maxPending = 1;
+    chBSemSignalI(&txWork_sem);
+    chSchRescheduleS();
+    chSysUnlock();
+}
+
+
+void sendBulkChunk(int chunk){
+    size_t offset = chunk*COM_CHUNK_SIZE;
+    size_t chunkSize = (bulk.size - offset > COM_CHUNK_SIZE) ? COM_CHUNK_SIZE : bulk.size - offset;
+
+    cmp_mem_access_t memory;
+    cmp_ctx_t cmp;
+    cmp_mem_access_init(&cmp, &memory, datagram, sizeof(datagram));
+    bool error = !cmp_write_array(&cmp, (bulk.type == MSG_IMAGE) ? 8 : 6);
+    error = error || !cmp_write_uint(&cmp, bulk.type);
+    error = error || !cmp_write_uint(&cmp, bulk.sender.transfer);
+    if(bulk.type == MSG_IMAGE){
+        error = error || !cmp_write_sint(&cmp, bulk.x);
+        error = error || !cmp_write_sint(&cmp, bulk.y);
+        error = error || !cmp_write_uint(&cmp, bulk.codec);
+    }
+    else{
+        error = error || !cmp_write_str(&cmp, bulk.name, strlen(bulk.name));
+    }
+    error = error || !cmp_write_uint(&cmp, chunk);
+    error = error || !cmp_write_uint(&cmp, bulk.size);
+    error = error || !cmp_write_bin(&cmp, bulk.datas + offset, chunkSize);
+    if(!error){
+        serial_datagram_send(datagram, cmp_mem_access_get_pos(&memory), sendToLink, NULL);
+    }
+}
+
+
+void endBulk(void){
+    chSysLock();
+    bulkActive = false;
+    if(bulk.sender.failed) stats[COM_LANE_BULK].dropped++;
+    else stats[COM_LANE_BULK].sent++;
+    stats[COM_LANE_BULK].retransmitted += bulk.sender.retransmitted;
+    chBSemSignalI(&bulkFree_sem);
+    chSchRescheduleS();
+    chSysUnlock();
+}
+
+
+void receiveDatagram(const void * bytes, size_t size, void * arg){
+    (void) arg;
+
+    cmp_mem_access_t memory;
+    cmp_ctx_t cmp;
+    cmp_mem_access_ro_init(&cmp, &memory, bytes, size);
+    uint32_t numberOfFields, type, transfer, chunk;
+    if(!cmp_read_array(&cmp, &numberOfFields) || numberOfFields != 3) return;
+    if(!cmp_read_uint(&cmp, &type) || !cmp_read_uint(&cmp, &transfer) || !cmp_read_uint(&cmp, &chunk)) return;
+
+    uint32_t now = ST2MS(chVTGetSystemTimeX());
+    chSysLock();
+    if(bulkActive){
+        if(type == MSG_ACK) mod_reliable_acknowledge(&bulk.sender, transfer, chunk, now);
+        else if(type == MSG_NACK) mod_reliable_lost(&bulk.sender, transfer, chunk);
+        chBSemSignalI(&txWork_sem);
+        chSchRescheduleS();
+    }
+    chSysUnlock();
+}
+
+
+int sendLogRecords(void){
+    int count = 0;
+    while(count < LOG_BATCH_SIZE && mod_log_takeRecord(&batch[count])) count++;
+    if(count == 0) return 0;
+
+    cmp_mem_access_t memory;
+    cmp_ctx_t cmp;
+    cmp_mem_access_init(&cmp, &memory, datagram, sizeof(datagram));
+    bool error = !cmp_write_array(&cmp, count + 1);
+    error = error || !cmp_write_uint(&cmp, MSG_LOG_RECORDS);
+    for(int i = 0; i < count; i++){
+        logRecord_t * record = &batch[i];
+        error = error || !cmp_write_array(&cmp, record->numberOfArgs + 2);
+        error = error || !cmp_write_uint(&cmp, record->format);
+        error = error || !cmp_write_uint(&cmp, record->time);
+        for(int arg = 0; arg < record->numberOfArgs; arg++){
+            if(record->floatArgs & (1 << arg)){
+                float value;
+                memcpy(&value, &record->args[arg], sizeof(value));
+                error = error || !cmp_write_float(&cmp, value);
+            }
+            else{
+                error = error || !cmp_write_sint(&cmp, (int32_t) record->args[arg]);
+            }
+        }
+    }
+    if(!error){
+        serial_datagram_send(datagram, cmp_mem_access_get_pos(&memory), sendToLink, NULL);
+    }
+    return count;
+}
+
+
+/**
+ * @brief Thread that frames and writes all the messages on the link
+ *
+ * @note    Lanes are checked by priority before each message, so a chunk of a picture
+ *          never waits more than one message. Chunks are sent as long as the window of the
+ *          transfer allows it, the serial driver blocks the thread at the speed of the link.
+ *          The log records are sent after the queued logs, at most every LOG_FLUSH_PERIOD
+ */
+static THD_WORKING_AREA(txThread_wa, 512);
+static THD_FUNCTION(txThread, arg){
+    (void) arg;
+
+    systime_t lastFlush = chVTGetSystemTime();
+    while(1){
+        comLane_t lane;
+        message_t * message = takeMessage(&lane);
+        if(message != NULL){
+            serial_datagram_send(message->payload, message->size, sendToLink, NULL);
+
+            chSysLock();
+            (void)chMBPostI(&lanes[lane].free, (msg_t) message);
+            stats[lane].sent++;
+            chSysUnlock();
+            continue;
+        }
+
+        systime_t sinceFlush = chVTTimeElapsedSinceX(lastFlush);
+        if(sinceFlush >= MS2ST(LOG_FLUSH_PERIOD)){
+            // A full batch is followed at once by the next one
+            if(sendLogRecords() < LOG_BATCH_SIZE) lastFlush = chVTGetSystemTime();
+            continue;
+        }
+        systime_t timeout = MS2ST(LOG_FLUSH_PERIOD) - sinceFlush;
+
+        if(bulkActive){
+            uint32_t now = ST2MS(chVTGetSystemTimeX());
+            chSysLock();
+            int chunk = mod_reliable_nextChunk(&bulk.sender, now);
+            bool finished = mod_reliable_isFinished(&bulk.sender);
+            systime_t untilTimeout = MS2ST(mod_reliable_timeUntilTimeout(&bulk.sender, now));
+            chSysUnlock();
+
+            if(chunk >= 0){
+                sendBulkChunk(chunk);
+                continue;
+            }
+            if(finished){
+                endBulk();
+                continue;
+            }
+            // Window full, waits for an acknowledgement or the timeout
+            if(untilTimeout < timeout) timeout = (untilTimeout > 0) ? untilTimeout : 1;
+        }
+        chBSemWaitTimeout(&txWork_sem, timeout);
+    }
+}
+
+
+/**
+ * @brief Thread that reads the acknowledgements of the computer
+ */
+static THD_WORKING_AREA(rxThread_wa, 256);
+static THD_FUNCTION(rxThread, arg){
+    (void) arg;
+
+    serial_datagram_rcv_handler_t handler;
+    serial_datagram_rcv_handler_init(&handler, rxDatagram, sizeof(rxDatagram), receiveDatagram, NULL);
+    uint8_t bytes[RX_READ_SIZE];
+    while(1){
+        size_t size = mod_transport_read(bytes, sizeof(bytes), RX_READ_TIMEOUT);
+        // Corrupted datagrams are ignored, the chunks are sent again after the timeout
+        if(size > 0) (void)serial_datagram_receive(&handler, bytes, size);
+    }
 }
 
 
@@ -57,155 +452,128 @@ static void serial_start(void)
  *  Public functions (Informations in header)
  */
 
-void mod_com_initModule(){
-    
-    serial_start();
-    
+void mod_com_initModule(transportLink_t link){
+
+    mod_transport_init(link);
+
+    int first = 0;
+    for(int lane = 0; lane < NUMBER_OF_QUEUES; lane++){
+        chMBObjectInit(&lanes[lane].free, &mailboxBuffers[2*first], laneSlots[lane]);
+        chMBObjectInit(&lanes[lane].pending, &mailboxBuffers[2*first + laneSlots[lane]], laneSlots[lane]);
+        lanes[lane].policy = lanePolicies[lane];
+        for(int i = first; i < first + laneSlots[lane]; i++){
+            (void)chMBPost(&lanes[lane].free, (msg_t) &messagesPool[i], TIME_INFINITE);
+        }
+        first += laneSlots[lane];
+    }
+    isStarted = true;
+
+    chThdCreateStatic(txThread_wa, sizeof(txThread_wa), NORMALPRIO-1, txThread, NULL);
+    chThdCreateStatic(rxThread_wa, sizeof(rxThread_wa), NORMALPRIO, rxThread, NULL);
 }
 
 void mod_com_writeDatas(char* type, char* toWrite, size_t toWriteSize){
-    
-    void* toSend = NULL;
-    
-    // Prepare the size of datas to introduce it in the header
     if(toWriteSize == 0) toWriteSize = strlen(toWrite);
-    char sizeText[sizeof(char)*(UNSIGNED_INT_IN_CHAR_SIZE + NULL_CHAR_SIZE)];
-    sprintf(sizeText, "%5d", size_t2int(toWriteSize));
-    
-    size_t sizeOfType = strlen(type);
-
-    const char separator[SEPARATOR_SIZE] = "||";
-    
-    size_t headerSize = strlen(sizeText) + SEPARATOR_SIZE +
-                                sizeOfType +
-                                SEPARATOR_SIZE;
-    
-    toSend = malloc(headerSize*sizeof(char));
-    assert (toSend != NULL);
-
-    // Prepare the header
-    void * toSendPointer = toSend;
-    memcpy(toSendPointer, sizeText, strlen(sizeText));
-    toSendPointer += strlen(sizeText);
-    memcpy(toSendPointer, separator, (size_t) SEPARATOR_SIZE);
-    toSendPointer += SEPARATOR_SIZE;
-    memcpy(toSendPointer, type, sizeOfType);
-    toSendPointer += sizeOfType;
-    memcpy(toSendPointer, separator, (size_t) SEPARATOR_SIZE);
-    
-    size_t i;
-    chSequentialStreamWrite((BaseSequentialStream *)&SD3, (uint8_t*)"START", 5);
-    // Write the header first
-    for(i=0; i<headerSize;i++)
-        chprintf((BaseSequentialStream *)&SD3, "%c",((uint8_t*) toSend)[i]);
-    
-    // Write content of the message
-    int written = 0;
-    while(toWriteSize > 0){
-        if(toWriteSize > 4000){
-            chSequentialStreamWrite((BaseSequentialStream *)&SD3, (uint8_t*)toWrite+written, 4000);
-            chThdSleepMilliseconds(400);
-            written+=4000;
-            toWriteSize -= 4000;
-        }
-        else{
-            chSequentialStreamWrite((BaseSequentialStream *)&SD3, (uint8_t*)toWrite+written, toWriteSize);
-            toWriteSize = 0;
-        }
-        
-    }
-    free(toSend);
-    toSend = NULL;
+    startBulk(MSG_DATA, type, 0, 0, CODEC_RAW, (const uint8_t *) toWrite, toWriteSize);
 }
 
 
 void mod_com_writeMessage(char* message, int level){
-    
+
     if(level < DISPLAY_LEVEL){
         return;
     }
-    strcat(message,"\n");
-    
-    void* toSend = NULL;
-    
-    // Prepare the size of datas to introduce it in the header
-    size_t toWriteSize = strlen(message);
-    char sizeText[sizeof(char)*(UNSIGNED_INT_IN_CHAR_SIZE + NULL_CHAR_SIZE)];
-    sprintf(sizeText, "%5d", size_t2int(toWriteSize));
-    
-    size_t sizeOfType = strlen("Message");
-    const char separator[SEPARATOR_SIZE] = "||";
-    
-    size_t totalSize =  strlen(sizeText) + SEPARATOR_SIZE +
-                        sizeOfType + SEPARATOR_SIZE + strlen(message) ;
-    
-    toSend = malloc(totalSize*sizeof(char));
-    assert (toSend != NULL);
-    
-    // Prepare the header
-    void * toSendPointer = toSend;
-    memcpy(toSendPointer, sizeText, strlen(sizeText));
-    toSendPointer += strlen(sizeText);
-    memcpy(toSendPointer, separator, (size_t) SEPARATOR_SIZE);
-    toSendPointer += SEPARATOR_SIZE;
-    memcpy(toSendPointer, "Message", sizeOfType);
-    toSendPointer += sizeOfType;
-    memcpy(toSendPointer, separator, (size_t) SEPARATOR_SIZE);
-    toSendPointer += SEPARATOR_SIZE;
-    memcpy(toSendPointer, message, (size_t) strlen(message));
-    
-    size_t i;
-    
-    chSequentialStreamWrite((BaseSequentialStream *)&SD3, (uint8_t*)"START", 5);
-    // Write the header first
-    for(i=0; i<totalSize;i++)
-        chprintf((BaseSequentialStream *)&SD3, "%c",((uint8_t*) toSend)[i]);
-    
-    free(toSend);
-    toSend = NULL;
+
+    cmp_mem_access_t memory;
+    cmp_ctx_t cmp;
+    message_t * toSend = startMessage(COM_LANE_LOG, MSG_LOG, 2, &cmp, &memory);
+    if(toSend == NULL) return;
+
+    // Longer logs are cut to fit in the message
+    size_t size = strnlen(message, COM_MESSAGE_SIZE - 8);
+    bool error = !cmp_write_uint(&cmp, level);
+    error = error || !cmp_write_str(&cmp, message, size);
+    postMessage(COM_LANE_LOG, toSend, &memory, error);
 }
 
 void mod_com_writeCommand(cmd_t order){
-    void* toSend = NULL;
-    char orderString[30];
-    switch (order) {
-        case SEND_MAP:
-            strcpy(orderString, "Send map\n");
-            break;
+    cmp_mem_access_t memory;
+    cmp_ctx_t cmp;
+    message_t * toSend = startMessage(COM_LANE_CONTROL, MSG_COMMAND, 1, &cmp, &memory);
+    if(toSend == NULL) return;
+
+    postMessage(COM_LANE_CONTROL, toSend, &memory, !cmp_write_uint(&cmp, order));
+}
+
+
+void mod_com_sendPose(robotPosition_t position){
+    cmp_mem_access_t memory;
+    cmp_ctx_t cmp;
+    message_t * toSend = startMessage(COM_LANE_TELEMETRY, MSG_POSE, 3, &cmp, &memory);
+    if(toSend == NULL) return;
+
+    bool error = !cmp_write_sint(&cmp, position.x);
+    error = error || !cmp_write_sint(&cmp, position.y);
+    error = error || !cmp_write_float(&cmp, position.theta);
+    postMessage(COM_LANE_TELEMETRY, toSend, &memory, error);
+}
+
+
+void mod_com_sendWalls(const point_t * corners, int numberOfCorners){
+    cmp_mem_access_t memory;
+    cmp_ctx_t cmp;
+    message_t * toSend = startMessage(COM_LANE_CONTROL, MSG_WALLS, 2*numberOfCorners, &cmp, &memory);
+    if(toSend == NULL) return;
+
+    bool error = false;
+    for(int i = 0; i < numberOfCorners; i++){
+        error = error || !cmp_write_sint(&cmp, corners[i].x);
+        error = error || !cmp_write_sint(&cmp, corners[i].y);
     }
-    // Prepare the size of datas to introduce it in the header
-    size_t toWriteSize = strlen(orderString);
-    char sizeText[sizeof(char)*(UNSIGNED_INT_IN_CHAR_SIZE + NULL_CHAR_SIZE)];
-    sprintf(sizeText, "%5d", size_t2int(toWriteSize));
-    
-    size_t sizeOfType = strlen("Command");
-    const char separator[SEPARATOR_SIZE] = "||";
-    
-    size_t totalSize =  strlen(sizeText) + SEPARATOR_SIZE +
-    sizeOfType + SEPARATOR_SIZE + strlen(orderString) ;
-    
-    toSend = malloc(totalSize*sizeof(char));
-    assert (toSend != NULL);
-    
-    // Prepare the header
-    void * toSendPointer = toSend;
-    memcpy(toSendPointer, sizeText, strlen(sizeText));
-    toSendPointer += strlen(sizeText);
-    memcpy(toSendPointer, separator, (size_t) SEPARATOR_SIZE);
-    toSendPointer += SEPARATOR_SIZE;
-    memcpy(toSendPointer, "Command", sizeOfType);
-    toSendPointer += sizeOfType;
-    memcpy(toSendPointer, separator, (size_t) SEPARATOR_SIZE);
-    toSendPointer += SEPARATOR_SIZE;
-    memcpy(toSendPointer, orderString, (size_t) strlen(orderString));
-    
-    size_t i;
-    
-    chSequentialStreamWrite((BaseSequentialStream *)&SD3, (uint8_t*)"START", 5);
-    // Write the header first
-    for(i=0; i<totalSize;i++)
-        chprintf((BaseSequentialStream *)&SD3, "%c",((uint8_t*) toSend)[i]);
-    
-    free(toSend);
-    toSend = NULL;
+    postMessage(COM_LANE_CONTROL, toSend, &memory, error);
+}
+
+
+void mod_com_sendObject(point_t object){
+    cmp_mem_access_t memory;
+    cmp_ctx_t cmp;
+    message_t * toSend = startMessage(COM_LANE_CONTROL, MSG_OBJECT, 2, &cmp, &memory);
+    if(toSend == NULL) return;
+
+    bool error = !cmp_write_sint(&cmp, object.x);
+    error = error || !cmp_write_sint(&cmp, object.y);
+    postMessage(COM_LANE_CONTROL, toSend, &memory, error);
+}
+
+
+void mod_com_sendScanPoint(point_t point, scanKind_t kind){
+    cmp_mem_access_t memory;
+    cmp_ctx_t cmp;
+    message_t * toSend = startMessage(COM_LANE_TELEMETRY, MSG_SCAN, 3, &cmp, &memory);
+    if(toSend == NULL) return;
+
+    bool error = !cmp_write_sint(&cmp, point.x);
+    error = error || !cmp_write_sint(&cmp, point.y);
+    error = error || !cmp_write_uint(&cmp, kind);
+    postMessage(COM_LANE_TELEMETRY, toSend, &memory, error);
+}
+
+
+void mod_com_sendImage(int x, int y, imageCodec_t codec, const uint8_t * image, size_t size){
+    startBulk(MSG_IMAGE, NULL, x, y, codec, image, size);
+}
+
+
+void mod_com_waitBulkEnd(void){
+    if(!isStarted) return;
+    chBSemWait(&bulkFree_sem);
+    chBSemSignal(&bulkFree_sem);
+}
+
+
+comLaneStats_t mod_com_getStats(comLane_t lane){
+    chSysLock();
+    comLaneStats_t laneStats = stats[lane];
+    chSysUnlock();
+    return laneStats;
 }
@@ -0,0 +1,375 @@
+/*
+ * File : mod_compression.c
+ * Project : e_puck_project
+ * Description : Module that compresses the RGB565 pictures of the camera before they are sent
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_compression.h"
+
+// Standard headers
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+
+#define BLOCK_SIZE                  8
+#define BLOCK_PIXELS                (BLOCK_SIZE*BLOCK_SIZE)
+#define CHROMA_WIDTH                (IMAGE_WIDTH/2)
+#define CHROMA_HEIGHT               (IMAGE_HEIGHT/2)
+#define BLOCKS_ALONG(size)          (((size) + BLOCK_SIZE - 1)/BLOCK_SIZE)
+
+// Tags of the lossless codec
+#define TAG_INDEX                   0x00    // 00iiiiii
+#define TAG_DIFF                    0x40    // 01rrggbb, differences in [-2, 1]
+#define TAG_LUMA                    0x80    // 10gggggg rrrrbbbb, green in [-32, 31], red and blue in [-8, 7] from it
+#define TAG_RUN                     0xC0    // 11llllll, 1 to MAX_RUN repetitions
+#define TAG_PIXEL                   0xFE    // Followed by the pixel
+#define MAX_RUN                     62
+#define COLOR_CACHE_SIZE            64
+
+/**
+ * @brief Planes of the lossy codec
+ */
+typedef enum{
+    PLANE_Y=0,
+    PLANE_CB,
+    PLANE_CR
+}plane_t;
+
+/**
+ * @brief Writes codes bit by bit, most significant bit first
+ */
+typedef struct{
+    uint8_t * buffer;
+    size_t size;
+    size_t position;
+    uint32_t bits;
+    int numberOfBits;
+    bool overflow;
+}bitWriter_t;
+
+// Base quantization tables of JPEG (natural order)
+static const uint8_t lumaBase[BLOCK_PIXELS] = {
+    16, 11, 10, 16, 24, 40, 51, 61,     12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56,     14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68,109,103, 77,     24, 35, 55, 64, 81,104,113, 92,
+    49, 64, 78, 87,103,121,120,101,     72, 92, 95, 98,112,100,103, 99
+};
+static const uint8_t chromaBase[BLOCK_PIXELS] = {
+    17, 18, 24, 47, 99, 99, 99, 99,     18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,     47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,     99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,     99, 99, 99, 99, 99, 99, 99, 99
+};
+// Natural position of the coefficients, from the lowest frequencies to the highest
+static const uint8_t zigzag[BLOCK_PIXELS] = {
+     0,  1,  8, 16,  9,  2,  3, 10,     17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,     27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,     29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,     53, 60, 61, 54, 47, 55, 62, 63
+};
+
+static float dctTable[BLOCK_SIZE][BLOCK_SIZE];
+static float lumaQuant[BLOCK_PIXELS];
+static float chromaQuant[BLOCK_PIXELS];
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Returns a pixel of the picture
+ */
+uint16_t getPixel(const uint8_t * image, int x, int y);
+
+/**
+ * @brief Returns a difference of a channel of size bits, wrapped in [-2^(bits-1), 2^(bits-1)[
+ */
+int wrapDifference(int difference, int bits);
+
+/**
+ * @brief Compress with the lossless codec
+ */
+size_t compressLossless(const uint8_t * image, uint8_t * output, size_t outputSize);
+
+/**
+ * @brief Compress with the lossy codec
+ */
+size_t compressLossy(const uint8_t * image, uint8_t * output, size_t outputSize);
+
+/**
+ * @brief Load a block of a plane, the pixels after the borders repeat the last ones
+ *
+ * @param[in] image         The picture
+ * @param[in] plane         The plane to load, the chroma planes are subsampled by 2
+ * @param[in] blockX, blockY The position of the block in the plane (in blocks)
+ * @param[in] block         Where to write the values, centered on 0
+ */
+void loadBlock(const uint8_t * image, plane_t plane, int blockX, int blockY, float * block);
+
+/**
+ * @brief Transform, quantize and write a block
+ *
+ * @param[in] writer        The bit writer
+ * @param[in] block         The values of the block
+ * @param[in] quant         The quantization table of the plane
+ * @param[in] previousDC    The DC coefficient of the previous block of the plane, updated
+ */
+void writeBlock(bitWriter_t * writer, const float * block, const float * quant, int * previousDC);
+
+/**
+ * @brief Write the numberOfBits (up to 24) lower bits of value
+ */
+void writeBits(bitWriter_t * writer, uint32_t value, int numberOfBits);
+
+/**
+ * @brief Write an unsigned Exp-Golomb code
+ */
+void writeUnsigned(bitWriter_t * writer, uint32_t value);
+
+/**
+ * @brief Write a signed Exp-Golomb code
+ */
+void writeSigned(bitWriter_t * writer, int value);
+
+/***************/
+
+
+uint16_t getPixel(const uint8_t * image, int x, int y){
+    const uint8_t * pixel = &image[2*(y*IMAGE_WIDTH + x)];
+    return (uint16_t) (pixel[0] << 8 | pixel[1]);
+}
+
+
+int wrapDifference(int difference, int bits){
+    int range = 1 << bits;
+    difference &= range - 1;
+    return (difference >= range/2) ? difference - range : difference;
+}
+
+
+size_t compressLossless(const uint8_t * image, uint8_t * output, size_t outputSize){
+    uint16_t cache[COLOR_CACHE_SIZE] = {0};
+    uint16_t previous = 0;
+    int run = 0;
+    size_t size = 0;
+
+    for(int i = 0; i < IMAGE_WIDTH*IMAGE_HEIGHT; i++){
+        // A code takes at most 3 bytes, a run 1
+        if(size + 4 > outputSize) return 0;
+
+        uint16_t pixel = getPixel(image, i % IMAGE_WIDTH, i / IMAGE_WIDTH);
+        if(pixel == previous){
+            run++;
+            if(run == MAX_RUN){
+                output[size++] = TAG_RUN | (run - 1);
+                run = 0;
+            }
+            continue;
+        }
+        if(run > 0){
+            output[size++] = TAG_RUN | (run - 1);
+            run = 0;
+        }
+
+        int red = pixel >> 11, green = (pixel >> 5) & 0x3F, blue = pixel & 0x1F;
+        int hash = (3*red + 5*green + 7*blue) % COLOR_CACHE_SIZE;
+        if(cache[hash] == pixel){
+            output[size++] = TAG_INDEX | hash;
+        }
+        else{
+            cache[hash] = pixel;
+            int dRed = wrapDifference(red - (previous >> 11), 5);
+            int dGreen = wrapDifference(green - ((previous >> 5) & 0x3F), 6);
+            int dBlue = wrapDifference(blue - (previous & 0x1F), 5);
+
+            if(dRed >= -2 && dRed <= 1 && dGreen >= -2 && dGreen <= 1 && dBlue >= -2 && dBlue <= 1){
+                output[size++] = TAG_DIFF | (dRed + 2) << 4 | (dGreen + 2) << 2 | (dBlue + 2);
+            }
+            else if(dRed - dGreen >= -8 && dRed - dGreen <= 7 && dBlue - dGreen >= -8 && dBlue - dGreen <= 7){
+                output[size++] = TAG_LUMA | (dGreen + 32);
+                output[size++] = (dRed - dGreen + 8) << 4 | (dBlue - dGreen + 8);
+            }
+            else{
+                output[size++] = TAG_PIXEL;
+                output[size++] = pixel >> 8;
+                output[size++] = pixel & 0xFF;
+            }
+        }
+        previous = pixel;
+    }
+    if(run > 0) output[size++] = TAG_RUN | (run - 1);
+    return size;
+}
+
+
+size_t compressLossy(const uint8_t * image, uint8_t * output, size_t outputSize){
+    if(outputSize < 1) return 0;
+    output[0] = LOSSY_QUALITY;
+    bitWriter_t writer = {output, outputSize, 1, 0, 0, false};
+    float block[BLOCK_PIXELS];
+
+    // The planes one after the other, the blocks in rows
+    for(plane_t plane = PLANE_Y; plane <= PLANE_CR; plane++){
+        int width = (plane == PLANE_Y) ? IMAGE_WIDTH : CHROMA_WIDTH;
+        int height = (plane == PLANE_Y) ? IMAGE_HEIGHT : CHROMA_HEIGHT;
+        const float * quant = (plane == PLANE_Y) ? lumaQuant : chromaQuant;
+        int previousDC = 0;
+
+        for(int blockY = 0; blockY < BLOCKS_ALONG(height); blockY++){
+            for(int blockX = 0; blockX < BLOCKS_ALONG(width); blockX++){
+                loadBlock(image, plane, blockX, blockY, block);
+                writeBlock(&writer, block, quant, &previousDC);
+                if(writer.overflow) return 0;
+            }
+        }
+    }
+
+    if(writer.numberOfBits > 0) writeBits(&writer, 0, 8 - writer.numberOfBits);
+    return writer.overflow ? 0 : writer.position;
+}
+
+
+void loadBlock(const uint8_t * image, plane_t plane, int blockX, int blockY, float * block){
+    int scale = (plane == PLANE_Y) ? 1 : 2;
+    int lastX = IMAGE_WIDTH/scale - 1;
+    int lastY = IMAGE_HEIGHT/scale - 1;
+
+    for(int row = 0; row < BLOCK_SIZE; row++){
+        int y = blockY*BLOCK_SIZE + row;
+        if(y > lastY) y = lastY;
+        for(int column = 0; column < BLOCK_SIZE; column++){
+            int x = blockX*BLOCK_SIZE + column;
+            if(x > lastX) x = lastX;
+
+            // Mean of the pixels covered by the sample, the channels on 8 bits
+            float red = 0, green = 0, blue = 0;
+            for(int i = 0; i < scale; i++){
+                for(int j = 0; j < scale; j++){
+                    uint16_t pixel = getPixel(image, scale*x + j, scale*y + i);
+                    red += (pixel >> 11)*(255.0f/31);
+                    green += ((pixel >> 5) & 0x3F)*(255.0f/63);
+                    blue += (pixel & 0x1F)*(255.0f/31);
+                }
+            }
+            red /= scale*scale;
+            green /= scale*scale;
+            blue /= scale*scale;
+
+            float value;
+            if(plane == PLANE_Y) value = 0.299f*red + 0.587f*green + 0.114f*blue - 128;
+            else if(plane == PLANE_CB) value = -0.168736f*red - 0.331264f*green + 0.5f*blue;
+            else value = 0.5f*red - 0.418688f*green - 0.081312f*blue;
+            block[row*BLOCK_SIZE + column] = value;
+        }
+    }
+}
+
+
+void writeBlock(bitWriter_t * writer, const float * block, const float * quant, int * previousDC){
+    float rows[BLOCK_PIXELS];
+    int coefficients[BLOCK_PIXELS];
+
+    // Separable DCT : along the columns, then along the rows
+    for(int u = 0; u < BLOCK_SIZE; u++){
+        for(int column = 0; column < BLOCK_SIZE; column++){
+            float sum = 0;
+            for(int row = 0; row < BLOCK_SIZE; row++) sum += dctTable[u][row]*block[row*BLOCK_SIZE + column];
+            rows[u*BLOCK_SIZE + column] = sum;
+        }
+    }
+    for(int u = 0; u < BLOCK_SIZE; u++){
+        for(int v = 0; v < BLOCK_SIZE; v++){
+            float sum = 0;
+            for(int column = 0; column < BLOCK_SIZE; column++) sum += rows[u*BLOCK_SIZE + column]*dctTable[v][column];
+            int index = u*BLOCK_SIZE + v;
+            coefficients[index] = (int) lroundf(sum/quant[index]);
+        }
+    }
+
+    // DC from the previous block, then (zeros before, value) for each AC until (0, 0)
+    int dc = coefficients[0];
+    writeSigned(writer, dc - *previousDC);
+    *previousDC = dc;
+
+    int zeros = 0;
+    for(int i = 1; i < BLOCK_PIXELS; i++){
+        int value = coefficients[zigzag[i]];
+        if(value == 0){
+            zeros++;
+            continue;
+        }
+        writeUnsigned(writer, zeros);
+        writeSigned(writer, value);
+        zeros = 0;
+    }
+    writeUnsigned(writer, 0);
+    writeSigned(writer, 0);
+}
+
+
+void writeBits(bitWriter_t * writer, uint32_t value, int numberOfBits){
+    writer->bits = (writer->bits << numberOfBits) | (value & ((1u << numberOfBits) - 1));
+    writer->numberOfBits += numberOfBits;
+    while(writer->numberOfBits >= 8){
+        writer->numberOfBits -= 8;
+        if(writer->position >= writer->size){
+            writer->overflow = true;
+            return;
+        }
+        writer->buffer[writer->position++] = (uint8_t) (writer->bits >> writer->numberOfBits);
+    }
+}
+
+
+void writeUnsigned(bitWriter_t * writer, uint32_t value){
+    uint32_t code = value + 1;
+    int length = 32 - __builtin_clz(code);
+    writeBits(writer, 0, length - 1);
+    writeBits(writer, code, length);
+}
+
+
+void writeSigned(bitWriter_t * writer, int value){
+    writeUnsigned(writer, (value > 0) ? 2*value - 1 : -2*value);
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_compress_init(void){
+    for(int u = 0; u < BLOCK_SIZE; u++){
+        float norm = (u == 0) ? sqrtf(1.0f/BLOCK_SIZE) : sqrtf(2.0f/BLOCK_SIZE);
+        for(int x = 0; x < BLOCK_SIZE; x++){
+            dctTable[u][x] = norm*cosf((2*x + 1)*u*(float) M_PI/(2*BLOCK_SIZE));
+        }
+    }
+
+    // Scaling of the tables of the IJG library
+    int scale = (LOSSY_QUALITY < 50) ? 5000/LOSSY_QUALITY : 200 - 2*LOSSY_QUALITY;
+    for(int i = 0; i < BLOCK_PIXELS; i++){
+        int luma = (lumaBase[i]*scale + 50)/100;
+        int chroma = (chromaBase[i]*scale + 50)/100;
+        lumaQuant[i] = (luma < 1) ? 1 : (luma > 255) ? 255 : luma;
+        chromaQuant[i] = (chroma < 1) ? 1 : (chroma > 255) ? 255 : chroma;
+    }
+}
+
+
+size_t mod_compress_image(imageCodec_t codec, const uint8_t * image, uint8_t * output, size_t outputSize){
+    switch(codec){
+        case CODEC_LOSSLESS:
+            return compressLossless(image, output, outputSize);
+        case CODEC_LOSSY:
+            return compressLossy(image, output, outputSize);
+        case CODEC_RAW:
+        default:
+            if(outputSize < IMAGE_SIZE) return 0;
+            memcpy(output, image, IMAGE_SIZE);
+            return IMAGE_SIZE;
+    }
+}
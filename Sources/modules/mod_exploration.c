@@ -12,8 +12,18 @@
 
 // Our headers
 #include "mod_mapping.h"
+#include "mod_odometry.h"
+#include "mod_localization.h"
+#include "mod_tofscan.h"
+#include "mod_motion.h"
+#include "mod_pursuit.h"
+#include "mod_safety.h"
+#include "mod_tour.h"
+#include "mod_frontier.h"
+#include "mod_planner.h"
 #include "mod_errors.h"
 #include "mod_communication.h"
+#include "mod_log.h"
 #include "mod_motors.h"
 #include "mod_sensors.h"
 #include "mod_basicIO.h"
@@ -24,9 +34,14 @@
 #include <ch.h>
 #include "hal.h"
 
-#define ACCELERATION_FACTOR         2
 #define DEFAULT_TRANSLATION_SPEED   40 //mm/s
 #define DEFAULT_ROTATION_SPEED      0.4 //rad/s
+#define SCAN_ROTATION_SPEED         1.0 //rad/s, TOF samples are 33 ms apart
+#define SCAN_POLLING_PERIOD         50  //ms
+#define REPLANNING_PERIOD           200 //ms, new TOF samples are added to the grid and the path checked
+#define GOTO_BLOCKED_TIMEOUT        1000 //ms, an emergency stop of mod_safety that lasts this time ends goTo
+#define GOTO_PROGRESS_TIMEOUT       8000 //ms, longer than a half turn in place of the pursuit
+#define GOTO_MIN_PROGRESS           10  //mm, the robot must get this closer to the point in each timeout
 
 #define ARENA_WALL_DISTANCE                             66  // Between epuck and wall in the arena (in mm)
 #define CALIBRATION_REF_TIME                            4000
@@ -41,10 +56,14 @@ static thread_t * motorsControlThread;
 
 history_t history = {false , false};
 
+// Samples of the current sweep, too big for the stacks of the threads
+static measurement_t sweep[TOFSCAN_BUFFER_SIZE];
+
 // Semaphores
 BSEMAPHORE_DECL (wipEndSignal_sem, true);
 BSEMAPHORE_DECL (wipEndMovingSignal_sem, true);
 BSEMAPHORE_DECL (isMessage, true);
+BSEMAPHORE_DECL (goToArrival_sem, true);
 
 wheelSpeed_t lastOrder;
 
@@ -72,55 +91,6 @@ void changeMotorsState(wheelSpeed_t order);
 void stopMotors(void);
 
 
-/**
- * @brief Move the robot at a defined speed for a certain time
- *
- * @note The new position of the robot will be computed
- *
- * @param[in] wheelSpeed       The wheels speed of the robot
- * @param[in] time             The time the robot was at the indicated speed
- */
-void moveAndComputePositionWheelSpeedType(const wheelSpeed_t* wheelSpeed, int deltaTime);
-
-/**
- * @brief Move the robot at a defined speed for a certain time
- *
- * @note The new position of the robot will be computed
- *
- * @param[in] robotSpeed       The robot style speed of the robot
- * @param[in] time             The time the robot was at the indicated speed
- */
-void moveAndComputePositionRobotSpeedType(const robotSpeed_t* robotSpeed, int deltaTime);
-
-/**
- * @brief Change motors states
- *
- * @note Does NOT compute the new robot position
- *
- * @param[in] wheelSpeed       The wheels speed of the robot
- * @param[in] time             The time the robot was at the indicated speed
- */
-void moveWheelSpeedType(const wheelSpeed_t* wheelSpeed, int deltaTime);
-
-/**
- * @brief Change motors state
- *
- * @note Does NOT compute the new robot position
- *
- * @param[in] robotSpeed       The robot style speed of the robot
- * @param[in] time             The time the robot was at the indicated speed
- */
-void moveRobotSpeedType(const robotSpeed_t* robotSpeed, int deltaTime);
-
-
-/**
- * @brief Do the movement that consist of a rotation and a translation
- *
- * @param[in] robotDistance       The movement to do (robot relatives)
- */
-void moveAndComputePositionDistanceType(const robotDistance_t* robotDistance);
-
-
 /**
  * @brief Move the robot in a certain direction without stop
  *
@@ -149,11 +119,21 @@ void changeAngleAbsolute(float absoluteAngle);
 /**
  * @brief Move the robot to a point
  *
- * @note No interruption if obstacle on the way !
+ * @note The path avoids the obstacles of the grid and is planned again when new ones are seen,
+ *       unmapped obstacles on the way slow down or stop the robot (mod_safety)
  *
  * @param[in] newAbsolutePosition       The absolute position of the point where to go
+ *
+ * @param[out] False if the robot stopped before the point: no path, blocked by an obstacle or without progress
  */
-void goTo(const point_t * newAbsolutePosition);
+bool goTo(const point_t * newAbsolutePosition);
+
+/**
+ * @brief Callback of the last point of a goTo path, wakes goTo up without waiting for the replanning period
+ *
+ * @param[in] arg       Unused
+ */
+void signalArrival(void * arg);
 
 
 // Communication between threads
@@ -184,18 +164,43 @@ void waitForMovementEnd(void);
 void storeFrontDistanceSensorValue(measurement_t* measurement);
 
 /**
- * @brief Do a complete rotation and store all measurement for point tracing
+ * @brief Do a complete rotation, each measurement is given to the walls lines as it arrives
+ *
+ * @param[in] number            The number of measurements of the rotation
+ */
+void rotateAndMeasureWallsDistance(int number);
+
+/**
+ * @brief Rotate at constant speed while the TOF sampler records, then give the sweep to the mapping
+ *
+ * @param[in] startAngle        Relative angle where the sweep begins
+ * @param[in] angle             Angle covered by the sweep
+ * @param[in] measurements      A table where to store the measurements
+ * @param[in] maxMeasurements   The size of the table
  *
- * @param[in] measurement       A pointer to a storing area
- * @param[in] number            The number of unit spaces in the measurement area
+ * @param[out] The number of measurements
  */
-void rotateAndMeasureWallsDistance(measurement_t* measurement, int number);
+int scanContinuous(float startAngle, float angle, measurement_t * measurements, int maxMeasurements);
+
+/**
+ * @brief Returns the rotation done since the last call
+ *
+ * @param[in] lastTheta         The angle of the last call, updated
+ *
+ * @param[out] The rotation (in -PI -> PI)
+ */
+float rotationSince(float * lastTheta);
 
 /**
  * @brief 360 deg scan to identify objects
  */
 void scan360(void);
 
+/**
+ * @brief Take the picture of all objects added to the tour, in the shortest order found
+ */
+void visitObjects(void);
+
 /***************/
 
 
@@ -211,29 +216,23 @@ static THD_WORKING_AREA(changeMotorsStateAsync_wa, 1024);
 static THD_FUNCTION(changeMotorsStateAsync, arg){
     (void) arg;
     static bool isMoving = false;
-    static systime_t lastOrderTime;
     while(1){
         thread_t *tp = chMsgWait();
         const wheelSpeed_t *order = (const wheelSpeed_t *)chMsgGet(tp);
         
+        // Position is integrated from motors steps by the odometry thread
+        mod_motors_changeStateWheelSpeedType(*order);
         if(isMoving){
-            systime_t deltaTime = chVTGetSystemTime() - lastOrderTime;
-            lastOrderTime = chVTGetSystemTime();
-            mod_motors_changeStateWheelSpeedType(*order);
-            mod_mapping_updatePositionWheelSpeedType(&lastOrder, ST2MS(deltaTime));
-        }
-        else{
-            lastOrderTime = chVTGetSystemTime();
-            mod_motors_changeStateWheelSpeedType(*order);
+            mod_mapping_updatePosition();
         }
         
         if(order->left == 0 && order->right==0){
-            mod_com_writeMessage("Robot is not moving", 0);
+            LOG_DEBUG(FMT_ROBOT_NOT_MOVING);
             isMoving = false;
             signalEndMovement();
         }
         else{
-            mod_com_writeMessage("Robot is moving", 0);
+            LOG_DEBUG(FMT_ROBOT_MOVING);
             isMoving = true;
             lastOrder = *order;
         }
@@ -252,54 +251,17 @@ void stopMotors(void){
 }
 
 
-void moveAndComputePositionWheelSpeedType(const wheelSpeed_t* wheelSpeed, int deltaTime){
-    
-    changeMotorsState(*wheelSpeed);
-    systime_t time = chVTGetSystemTime();
-    chThdSleepUntilWindowed(time, time + MS2ST(deltaTime*1.0220));
-    stopMotors();
-    waitForMovementEnd();
-}
-
-
-void moveAndComputePositionRobotSpeedType(const robotSpeed_t* robotSpeed, int deltaTime){
-    wheelSpeed_t wheelSpeed = mod_motors_convertRobotSpeedToWheelspeed(*robotSpeed);
-    moveAndComputePositionWheelSpeedType(&wheelSpeed, deltaTime);
-}
-
-
-void moveWheelSpeedType(const wheelSpeed_t* wheelSpeed, int deltaTime){
-    mod_com_writeMessage("WARNING : You're using a function that corrupts your coordinates system", 5);
-    mod_motors_changeStateWheelSpeedType(*wheelSpeed);
-    systime_t time = chVTGetSystemTime();
-    chThdSleepUntilWindowed(time, time + MS2ST(deltaTime));
-    mod_motors_stop();
-}
-
-
-void moveRobotSpeedType(const robotSpeed_t* robotSpeed, int deltaTime){
-    mod_com_writeMessage("WARNING : You're using a function that corrupts your coordinates system", 5);
-    wheelSpeed_t wheelSpeed = mod_motors_convertRobotSpeedToWheelspeed(*robotSpeed);
-    moveWheelSpeedType(&wheelSpeed, deltaTime);
-}
-
-
-void moveAndComputePositionDistanceType(const robotDistance_t* robotDistance){
-    changeAngleRelative(robotDistance->rotation);
-    moveAndComputePositionRobotSpeedType(&((robotSpeed_t){((robotDistance->translation< 0) ? -1 : 1 )*DEFAULT_TRANSLATION_SPEED, 0}), 1000*fabs(robotDistance->translation/DEFAULT_TRANSLATION_SPEED));
-}
-
-
 void moveInAbsoluteDirection(float absoluteAngle){
-    mod_com_writeMessage("WARNING : You're using a useless function", 5);
-    float relativeAngle = mod_mapping_getRelativeAngle(absoluteAngle);
-    moveAndComputePositionRobotSpeedType(&((robotSpeed_t){0, ((relativeAngle < 0) ? -1 : 1 ) * DEFAULT_ROTATION_SPEED}), 1000*fabs(relativeAngle)/DEFAULT_ROTATION_SPEED);
+    LOG_WARNING(FMT_USELESS_FUNCTION);
+    changeAngleAbsolute(absoluteAngle);
     changeMotorsState(mod_motors_convertRobotSpeedToWheelspeed((robotSpeed_t){DEFAULT_TRANSLATION_SPEED, 0}));
 }
 
 
 void changeAngleRelative(float relativeAngle){
-    moveAndComputePositionRobotSpeedType(&((robotSpeed_t){0, ((relativeAngle< 0) ? -1 : 1 )*DEFAULT_ROTATION_SPEED}), (float)1000*fabs(relativeAngle)/DEFAULT_ROTATION_SPEED);
+    // Exact number of steps, the end is signaled by the motors driver
+    mod_motors_moveAndWait(0, relativeAngle, DEFAULT_ROTATION_SPEED*ROBOT_RADIUS);
+    mod_mapping_updatePosition();
 }
 
 
@@ -308,9 +270,80 @@ void changeAngleAbsolute(float absoluteAngle){
 }
 
 
-void goTo(const point_t * newAbsolutePosition){
-    robotDistance_t toDo = mod_mapping_getRobotDisplacement(newAbsolutePosition);
-    moveAndComputePositionDistanceType(&toDo);
+bool goTo(const point_t * newAbsolutePosition){
+    // The path goes around the obstacles of the grid, straight line if a point is outside of the planning area
+    robotPosition_t robot = mod_mapping_getActualPosition();
+    point_t path[PURSUIT_MAX_POINTS];
+    // A* gives the first path at once
+    int number = mod_planner_findPath((point_t) {robot.x, robot.y}, *newAbsolutePosition, path, PURSUIT_MAX_POINTS);
+    if(!mod_planner_startReplanning((point_t) {robot.x, robot.y}, *newAbsolutePosition)){
+        path[0] = *newAbsolutePosition;
+        number = 1;
+    }
+    else if(number == 0){
+        LOG_WARNING(FMT_NO_PATH, newAbsolutePosition->x, newAbsolutePosition->y);
+        return false;
+    }
+    chBSemReset(&goToArrival_sem, true);
+    mod_motion_followPath(path, number, signalArrival, NULL);
+    
+    // D* Lite searches the whole area once while the robot starts, the replannings then stay local
+    (void)mod_planner_replan((point_t) {robot.x, robot.y}, path, PURSUIT_MAX_POINTS);
+    
+    // The motion thread follows the path while the TOF samples seen on the way go in the grid,
+    // D* Lite only searches again around the changes
+    bool arrived = true;
+    int blockedTime = 0;
+    int progressTime = 0;
+    float closestDistance = hypotf(newAbsolutePosition->x - robot.x, newAbsolutePosition->y - robot.y);
+    mod_tofscan_startRecording();
+    while(!mod_motion_isIdle()){
+        (void)chBSemWaitTimeout(&goToArrival_sem, MS2ST(REPLANNING_PERIOD));
+        if(mod_motion_isIdle()) break;
+        
+        // The motion thread does not know that mod_safety holds the robot, a point behind an obstacle is never reached
+        robot = mod_mapping_getActualPosition();
+        float distance = hypotf(newAbsolutePosition->x - robot.x, newAbsolutePosition->y - robot.y);
+        blockedTime = mod_safety_isEmergency() ? blockedTime + REPLANNING_PERIOD : 0;
+        progressTime += REPLANNING_PERIOD;
+        if(distance < closestDistance - GOTO_MIN_PROGRESS){
+            closestDistance = distance;
+            progressTime = 0;
+        }
+        if(blockedTime >= GOTO_BLOCKED_TIMEOUT || progressTime >= GOTO_PROGRESS_TIMEOUT){
+            mod_motion_stop();
+            arrived = false;
+            LOG_WARNING(FMT_GOTO_ABORTED, newAbsolutePosition->x, newAbsolutePosition->y);
+            break;
+        }
+        
+        int samples = mod_tofscan_getMeasurements(sweep, TOFSCAN_BUFFER_SIZE);
+        mod_tofscan_startRecording();
+        for(int i = 0; i < samples; i++){
+            mod_mapping_addMeasurement(&sweep[i]);
+        }
+        mod_frontier_update();
+        if(!mod_planner_updateObstacles()) continue;
+        
+        // The obstacles seen on the way can close every path, the caller gives up the point
+        number = mod_planner_replan((point_t) {robot.x, robot.y}, path, PURSUIT_MAX_POINTS);
+        if(number == 0){
+            mod_motion_stop();
+            arrived = false;
+            LOG_WARNING(FMT_NO_PATH, newAbsolutePosition->x, newAbsolutePosition->y);
+            break;
+        }
+        mod_motion_followPath(path, number, signalArrival, NULL);
+    }
+    mod_tofscan_stopRecording();
+    mod_mapping_updatePosition();
+    return arrived;
+}
+
+
+void signalArrival(void * arg){
+    (void) arg;
+    chBSemSignal(&goToArrival_sem);
 }
 
 
@@ -335,71 +368,128 @@ void waitForMovementEnd(void){
 void storeFrontDistanceSensorValue(measurement_t* measurement){
     int value = mod_sensors_getValueTOF();
     *measurement = (measurement_t) {mod_mapping_getActualPosition(), value};
+    mod_mapping_addMeasurement(measurement);
 }
 
-void rotateAndMeasureWallsDistance(measurement_t* measurement, int number){
-    assert(measurement);
+void rotateAndMeasureWallsDistance(int number){
+    mod_mapping_startWallDiscovery();
     
     int i;
     for(i=0; i < number; i++){
         chThdSleepMilliseconds(200);
-        storeFrontDistanceSensorValue(&measurement[i]);
+        measurement_t measurement;
+        storeFrontDistanceSensorValue(&measurement);
+        mod_mapping_addWallMeasurement(&measurement);
         changeAngleRelative(ANGLE_ELEMENT);
     }
 }
 
 
-void scanInFront(void){
-    measurement_t *measurement = malloc(NUMBER_OF_STEPS_FRONT*sizeof(measurement_t));
-    changeAngleRelative(-M_PI/8);
-    for(int i=0; i < NUMBER_OF_STEPS_FRONT; i++){
-        chThdSleepMilliseconds(150);
-        storeFrontDistanceSensorValue(&measurement[i]);
-        changeAngleRelative(ANGLE_ELEMENT_FRONT);
+int scanContinuous(float startAngle, float angle, measurement_t * measurements, int maxMeasurements){
+    changeAngleRelative(startAngle);
+    mod_tofscan_startRecording();
+    changeAngleRelative(angle);
+    mod_tofscan_stopRecording();
+    
+    int number = mod_tofscan_getMeasurements(measurements, maxMeasurements);
+    for(int i=0; i < number; i++){
+        mod_mapping_addMeasurement(&measurements[i]);
     }
+    mod_frontier_update();
+    return number;
+}
+
+
+float rotationSince(float * lastTheta){
+    float theta = mod_mapping_getActualPosition().theta;
+    float rotation = theta - *lastTheta;
+    while(rotation > M_PI) rotation -= 2*M_PI;
+    while(rotation < -M_PI) rotation += 2*M_PI;
+    *lastTheta = theta;
+    return rotation;
+}
+
+
+void scanInFront(void){
+    int number = scanContinuous(-M_PI/8, SIZE_FRONT_SCAN, sweep, TOFSCAN_BUFFER_SIZE);
     changeAngleRelative(M_PI/8);
-    mod_mapping_checkEnvironment(measurement, NUMBER_OF_STEPS_FRONT);
+    mod_mapping_checkEnvironment(sweep, number);
     
+    mod_tour_reset();
     for(int i = 0; i < environment.numberOfnewObjects ;i++){
-        robotDistance_t toDo = mod_mapping_computeDistanceForPicture(environment.newObjectsLocation[i]);
-        moveAndComputePositionDistanceType(&toDo);
-        mod_image_sendPicture(environment.newObjectsLocation[i].x, environment.newObjectsLocation[i].y);
-        chThdSleepMilliseconds(1000);
-        moveAndComputePositionRobotSpeedType(&((robotSpeed_t){((-toDo.translation< 0) ? -1 : 1 )*DEFAULT_TRANSLATION_SPEED, 0}), 1000*fabs(-toDo.translation/DEFAULT_TRANSLATION_SPEED));
-        changeAngleRelative(-toDo.rotation);
+        mod_tour_addObject(environment.newObjectsLocation[i]);
     }
+    visitObjects();
 }
 
 void scan360(void){
-    measurement_t measurement;
-    float begginAngle = mod_mapping_getActualPosition().theta;
-    int numberOfScans= 0;
-    while(numberOfScans < NUMBER_OF_SCANS_MIN || (mod_mapping_getActualPosition().theta < begginAngle || mod_mapping_getActualPosition().theta > begginAngle + M_PI)){
-        chThdSleepMilliseconds(150);
-        storeFrontDistanceSensorValue(&measurement);
-        numberOfScans++;
-        if(mod_mapping_checkEnvironmentLimitsRobotReferencial(&measurement, history.discovering)){
-            changeAngleRelative(ANGLE_ELEMENT_SCAN360);
-            continue;
-        }
-        changeAngleRelative(-SIZE_FRONT_SCAN/2);
-        measurement_t distance[NUMBER_OF_STEPS_FRONT];
-        for(int j=0; j < NUMBER_OF_STEPS_FRONT; j++){
-            chThdSleepMilliseconds(150);
-            storeFrontDistanceSensorValue(&distance[j]);
-            changeAngleRelative(ANGLE_ELEMENT_FRONT);
+    float lastTheta = mod_mapping_getActualPosition().theta;
+    float rotationDone = 0;
+    mod_mapping_startSweep();
+    mod_tour_reset();
+    while(rotationDone < COMPLETE_ANGLE){
+        
+        // Rotate without stopping until a sample is not explained by the walls
+        measurement_t candidate;
+        bool found = false;
+        int checked = 0;
+        mod_tofscan_startRecording();
+        changeMotorsState(mod_motors_convertRobotSpeedToWheelspeed((robotSpeed_t){0, SCAN_ROTATION_SPEED}));
+        while(!found && rotationDone < COMPLETE_ANGLE && checked < TOFSCAN_BUFFER_SIZE/2){
+            chThdSleepMilliseconds(SCAN_POLLING_PERIOD);
+            rotationDone += rotationSince(&lastTheta);
+            int number = mod_tofscan_getMeasurements(sweep, TOFSCAN_BUFFER_SIZE);
+            for(; checked < number && !found; checked++){
+                mod_mapping_addMeasurement(&sweep[checked]);
+                if(!mod_mapping_checkEnvironmentLimitsRobotReferencial(&sweep[checked], history.discovering)){
+                    candidate = sweep[checked];
+                    found = true;
+                }
+            }
+            mod_frontier_update();
         }
+        stopMotors();
+        waitForMovementEnd();
+        mod_tofscan_stopRecording();
+        rotationDone += rotationSince(&lastTheta);
+        if(!found) continue;
+        
+        // Closer look centered on the candidate
+        changeAngleRelative(mod_mapping_getRelativeAngle(candidate.position.theta + M_PI/2));
+        int number = scanContinuous(-SIZE_FRONT_SCAN/2, SIZE_FRONT_SCAN, sweep, TOFSCAN_BUFFER_SIZE);
         point_t newObject;
-        robotDistance_t toDo = mod_mapping_findObjectBestPosition(distance, &newObject, history.discovering);
-        if(newObject.x ==-1 && newObject.y ==-1){
-            changeAngleRelative(ANGLE_ELEMENT_SCAN360);
-            continue;
+        (void)mod_mapping_findObjectBestPosition(sweep, number, &newObject, history.discovering);
+        if(newObject.x !=-1 || newObject.y !=-1){
+            // The picture is taken after the sweep, all objects in one tour
+            mod_tour_addObject(newObject);
         }
-        moveAndComputePositionDistanceType(&toDo);
-        mod_image_sendPicture(newObject.x, newObject.y);
-        moveAndComputePositionRobotSpeedType(&((robotSpeed_t){((-toDo.translation< 0) ? -1 : 1 )*DEFAULT_TRANSLATION_SPEED, 0}), 1000*fabs(-toDo.translation/DEFAULT_TRANSLATION_SPEED));
-        changeAngleRelative(ANGLE_ELEMENT_SCAN360-toDo.rotation);
+        rotationDone += rotationSince(&lastTheta);
     }
+    
+    // The sweep is matched before moving, its points were measured from here
+    mod_mapping_relocalize();
+    visitObjects();
+}
+
+
+void visitObjects(void){
+    robotPosition_t robot = mod_mapping_getActualPosition();
+    pictureStop_t tour[TOUR_MAX_STOPS];
+    int number = mod_tour_computeOrder((point_t) {robot.x, robot.y}, tour);
+    
+    for(int i = 0; i < number; i++){
+        // The picture would not be taken from the planned place
+        if(!goTo(&tour[i].position)) continue;
+        
+        // The turn to the object is one more segment of the motion queue after the path
+        robot = mod_mapping_getActualPosition();
+        float angle = mod_mapping_getRelativeAngle(atan2f(tour[i].object.y - robot.y, tour[i].object.x - robot.x));
+        mod_motion_addRotation(angle, NULL, NULL);
+        mod_motion_waitIdle();
+        mod_mapping_updatePosition();
+        mod_image_sendPicture(tour[i].object.x, tour[i].object.y);
+    }
+    mod_tour_reset();
 }
 
 // Actions on threads
@@ -415,13 +505,10 @@ static THD_FUNCTION(discover, arg){
 
     mod_mapping_resetCoordinates();
     
-    measurement_t * measurement = malloc(NUMBER_OF_STEPS*sizeof(measurement_t));
-    assert(measurement);
-    rotateAndMeasureWallsDistance(measurement, NUMBER_OF_STEPS);
-    mod_mapping_computeWallLocation(measurement);
-    free(measurement);
-    measurement = NULL;
+    rotateAndMeasureWallsDistance(NUMBER_OF_STEPS);
+    mod_mapping_computeWallLocation();
     point_t toGo = mod_mapping_getAreaCenter();
+    mod_planner_setArea((point_t) {0, 0}, (point_t) {2*toGo.x, 2*toGo.y});
     goTo(&(toGo));
     
     signalEndOfWork();
@@ -433,8 +520,25 @@ static THD_FUNCTION(discover, arg){
 static THD_WORKING_AREA(exploration_wa, 1024);
 static THD_FUNCTION(exploration, arg){
     (void) arg;
-    mod_com_writeMessage("Entering exploration thread", 3);
+    LOG_INFO(FMT_ENTERING_EXPLORATION);
+    point_t center = mod_mapping_getAreaCenter();
+    mod_frontier_setArea((point_t) {0, 0}, (point_t) {2*center.x, 2*center.y});
+    mod_planner_setArea((point_t) {0, 0}, (point_t) {2*center.x, 2*center.y});
+    
+    // Scans are done from the frontiers until the coverage does not grow anymore
     scan360();
+    mod_frontier_endOfScan();
+    while(!mod_frontier_isExplorationDone()){
+        robotPosition_t robot = mod_mapping_getActualPosition();
+        point_t goal;
+        if(!mod_frontier_selectGoal((point_t) {robot.x, robot.y}, &goal)) break;
+        if(!goTo(&goal)){
+            mod_frontier_markUnreachable(goal);
+            continue;
+        }
+        scan360();
+        mod_frontier_endOfScan();
+    }
     
     signalEndOfWork();
 }
@@ -450,6 +554,11 @@ void mod_explo_initModule(void){
     mod_sensors_initSensors();
     mod_motors_init();
     mod_mapping_init();
+    mod_odometry_start();
+    mod_localization_start();
+    mod_tofscan_start();
+    mod_motion_start();
+    mod_safety_start();
     mod_img_init();
     
     //mod_sensors_initObjectDetection();
@@ -470,6 +579,10 @@ void mod_explo_explorateTheAreaOnThread(){
 
 void mod_explo_sendTheMap(void){
     mod_com_writeCommand(SEND_MAP);
+    
+    // Messages lost since the start, when the serial port was too slow
+    LOG_INFO(FMT_DROPPED, mod_com_getStats(COM_LANE_CONTROL).dropped, mod_com_getStats(COM_LANE_TELEMETRY).dropped,
+             mod_com_getStats(COM_LANE_LOG).dropped, mod_log_getDropped());
 }
 
 
@@ -0,0 +1,345 @@
+/*
+ * File : mod_frontier.c
+ * Project : e_puck_project
+ * Description : Module that finds the boundaries between free and unknown cells of the grid to choose where to explore
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_frontier.h"
+
+// Standard headers
+#include <math.h>
+#include <string.h>
+
+// Our headers
+#include "mod_grid.h"
+#include "mod_planner.h"
+#include "mod_log.h"
+
+#define INFO_KNOWN                  (1 << 0)
+#define INFO_FRONTIER               (1 << 1)
+#define INFO_CLUSTERED              (1 << 2)
+
+#define FRONTIER_QUEUE_SIZE         512     // Cells of a cluster waiting to be expanded
+#define FRONTIER_CLEARANCE          PLANNER_ROBOT_CELLS // Cells around a goal that must not be occupied, else the planner refuses it
+#define FRONTIER_COST_OFFSET        100     // Avoids an infinite gain for close frontiers (in mm)
+#define FRONTIER_MIN_DISTANCE       50      // Frontiers closer to the robot are already seen (in mm)
+#define FRONTIER_VISITED_RADIUS     60      // A cluster near a previous goal can not be seen better (in mm)
+#define FRONTIER_UNREACHABLE_RADIUS 100     // The center of a cluster moves as it is seen, a goal without path is avoided wider (in mm)
+
+
+// Known and frontier flags of each cell, updated only in the blocks of the grid that changed
+static uint8_t cellInfo[GRID_ROWS][GRID_COLUMNS];
+static uint32_t lastStamp = 0;
+static uint16_t queue[FRONTIER_QUEUE_SIZE];
+
+// Area in cells, limits included
+static int minColumn = 0, maxColumn = GRID_COLUMNS - 1;
+static int minRow = 0, maxRow = GRID_ROWS - 1;
+static int numberOfAreaCells = GRID_ROWS*GRID_COLUMNS;
+static int numberOfKnownCells = 0;
+
+static point_t visitedGoals[FRONTIER_MAX_GOALS];
+static int numberOfGoals = 0;
+static point_t unreachableGoals[FRONTIER_MAX_GOALS];
+static int numberOfUnreachableGoals = 0;
+static float lastCoverage = 0;
+static float lastGain = 1;
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Check if the cell is inside the explored area
+ *
+ * @param[in] column, row   The cell
+ *
+ * @param[out] True if it's in
+ */
+bool isInArea(int column, int row);
+
+/**
+ * @brief Compute again the frontier flag of a cell from the grid
+ *
+ * @param[in] column, row   The cell
+ */
+void updateFrontier(int column, int row);
+
+/**
+ * @brief Compute again the known flag of a cell and the frontier flag of the cell and its neighbours
+ *
+ * @param[in] column, row   The cell that changed
+ */
+void updateCell(int column, int row);
+
+/**
+ * @brief Compute again the flags of the cells of a region that are in the area or next to it
+ *
+ * @param[in] region        The region
+ */
+void updateRegion(const gridRegion_t * region);
+
+/**
+ * @brief Check that no occupied cell is close to a cell
+ *
+ * @param[in] column, row   The cell
+ *
+ * @param[out] True if the robot can stand on the cell
+ */
+bool hasClearance(int column, int row);
+
+/**
+ * @brief Check if a point is close to a goal that was already visited or could not be reached
+ *
+ * @param[in] point     The point
+ *
+ * @param[out] True if such a goal is close
+ */
+bool isNearVisitedGoal(point_t point);
+
+/**
+ * @brief Returns the distance between two points
+ *
+ * @param[in] first, second     The points
+ *
+ * @param[out] The distance (in mm)
+ */
+float distanceBetweenPoints(point_t first, point_t second);
+
+/***************/
+
+
+bool isInArea(int column, int row){
+    return column >= minColumn && column <= maxColumn && row >= minRow && row <= maxRow;
+}
+
+
+void updateFrontier(int column, int row){
+    if(!isInArea(column, row)) return;
+    cellInfo[row][column] &= ~INFO_FRONTIER;
+    if(mod_grid_getCellState(column, row) != CELL_FREE) return;
+
+    // A free cell is a frontier if an unknown cell of the area is next to it
+    static const int neighbours[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+    for(int i = 0; i < 4; i++){
+        int neighbourColumn = column + neighbours[i][0];
+        int neighbourRow = row + neighbours[i][1];
+        if(isInArea(neighbourColumn, neighbourRow) &&
+           mod_grid_getCellState(neighbourColumn, neighbourRow) == CELL_UNKNOWN){
+            cellInfo[row][column] |= INFO_FRONTIER;
+            return;
+        }
+    }
+}
+
+
+void updateCell(int column, int row){
+    if(isInArea(column, row)){
+        bool isKnown = mod_grid_getCellState(column, row) != CELL_UNKNOWN;
+        bool wasKnown = cellInfo[row][column] & INFO_KNOWN;
+        if(isKnown && !wasKnown){
+            cellInfo[row][column] |= INFO_KNOWN;
+            numberOfKnownCells++;
+        }
+        else if(!isKnown && wasKnown){
+            cellInfo[row][column] &= ~INFO_KNOWN;
+            numberOfKnownCells--;
+        }
+    }
+    updateFrontier(column, row);
+    updateFrontier(column + 1, row);
+    updateFrontier(column - 1, row);
+    updateFrontier(column, row + 1);
+    updateFrontier(column, row - 1);
+}
+
+
+void updateRegion(const gridRegion_t * region){
+    // A cell just outside of the area changes the frontier flag of its neighbour inside
+    int firstColumn = (region->minColumn > minColumn - 1) ? region->minColumn : minColumn - 1;
+    int lastColumn = (region->maxColumn < maxColumn + 1) ? region->maxColumn : maxColumn + 1;
+    int firstRow = (region->minRow > minRow - 1) ? region->minRow : minRow - 1;
+    int lastRow = (region->maxRow < maxRow + 1) ? region->maxRow : maxRow + 1;
+    for(int row = firstRow; row <= lastRow; row++){
+        for(int column = firstColumn; column <= lastColumn; column++){
+            updateCell(column, row);
+        }
+    }
+}
+
+
+bool hasClearance(int column, int row){
+    for(int deltaRow = -FRONTIER_CLEARANCE; deltaRow <= FRONTIER_CLEARANCE; deltaRow++){
+        for(int deltaColumn = -FRONTIER_CLEARANCE; deltaColumn <= FRONTIER_CLEARANCE; deltaColumn++){
+            if(mod_grid_getCellState(column + deltaColumn, row + deltaRow) == CELL_OCCUPIED) return false;
+        }
+    }
+    return true;
+}
+
+
+bool isNearVisitedGoal(point_t point){
+    for(int i = 0; i < numberOfGoals; i++){
+        if(distanceBetweenPoints(point, visitedGoals[i]) < FRONTIER_VISITED_RADIUS) return true;
+    }
+    for(int i = 0; i < numberOfUnreachableGoals; i++){
+        if(distanceBetweenPoints(point, unreachableGoals[i]) < FRONTIER_UNREACHABLE_RADIUS) return true;
+    }
+    return false;
+}
+
+
+float distanceBetweenPoints(point_t first, point_t second){
+    float deltaX = second.x - first.x;
+    float deltaY = second.y - first.y;
+    return sqrtf(deltaX*deltaX + deltaY*deltaY);
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_frontier_setArea(point_t min, point_t max){
+    mod_grid_pointToCell(min, &minColumn, &minRow);
+    mod_grid_pointToCell(max, &maxColumn, &maxRow);
+    if(minColumn < 0) minColumn = 0;
+    if(minRow < 0) minRow = 0;
+    if(maxColumn >= GRID_COLUMNS) maxColumn = GRID_COLUMNS - 1;
+    if(maxRow >= GRID_ROWS) maxRow = GRID_ROWS - 1;
+    numberOfAreaCells = (maxColumn - minColumn + 1)*(maxRow - minRow + 1);
+
+    numberOfGoals = 0;
+    numberOfUnreachableGoals = 0;
+    lastCoverage = 0;
+    lastGain = 1;
+
+    // Every flag must be computed again for the new area
+    memset(cellInfo, 0, sizeof(cellInfo));
+    numberOfKnownCells = 0;
+    lastStamp = mod_grid_getStamp();
+    updateRegion(&((gridRegion_t) {minColumn, minRow, maxColumn, maxRow}));
+}
+
+
+void mod_frontier_update(void){
+    uint32_t stamp = mod_grid_getStamp();
+    if(stamp == lastStamp) return;
+
+    for(int block = 0; block < GRID_BLOCKS; block++){
+        gridRegion_t region;
+        if(mod_grid_getChangedBlock(block, lastStamp, &region)) updateRegion(&region);
+    }
+    lastStamp = stamp;
+}
+
+
+float mod_frontier_getCoverage(void){
+    mod_frontier_update();
+    if(numberOfAreaCells <= 0) return 1;
+    return (float) numberOfKnownCells/numberOfAreaCells;
+}
+
+
+bool mod_frontier_selectGoal(point_t position, point_t * goal){
+    mod_frontier_update();
+
+    float bestUtility = 0;
+    bool isFound = false;
+
+    for(int row = minRow; row <= maxRow; row++){
+        for(int column = minColumn; column <= maxColumn; column++){
+            cellInfo[row][column] &= ~INFO_CLUSTERED;
+        }
+    }
+
+    for(int row = minRow; row <= maxRow; row++){
+        for(int column = minColumn; column <= maxColumn; column++){
+            if((cellInfo[row][column] & (INFO_FRONTIER | INFO_CLUSTERED)) != INFO_FRONTIER) continue;
+
+            // Flood fill of the connected frontier cells (8 neighbours)
+            int size = 0, queueStart = 0, queueEnd = 0;
+            long sumColumn = 0, sumRow = 0;
+            cellInfo[row][column] |= INFO_CLUSTERED;
+            queue[queueEnd++] = row*GRID_COLUMNS + column;
+            while(queueStart < queueEnd){
+                int cellColumn = queue[queueStart] % GRID_COLUMNS;
+                int cellRow = queue[queueStart] / GRID_COLUMNS;
+                queueStart++;
+                size++;
+                sumColumn += cellColumn;
+                sumRow += cellRow;
+                for(int deltaRow = -1; deltaRow <= 1; deltaRow++){
+                    for(int deltaColumn = -1; deltaColumn <= 1; deltaColumn++){
+                        int nextColumn = cellColumn + deltaColumn;
+                        int nextRow = cellRow + deltaRow;
+                        if(!isInArea(nextColumn, nextRow) || queueEnd >= FRONTIER_QUEUE_SIZE) continue;
+                        if((cellInfo[nextRow][nextColumn] & (INFO_FRONTIER | INFO_CLUSTERED)) != INFO_FRONTIER) continue;
+                        cellInfo[nextRow][nextColumn] |= INFO_CLUSTERED;
+                        queue[queueEnd++] = nextRow*GRID_COLUMNS + nextColumn;
+                    }
+                }
+            }
+            if(size < FRONTIER_MIN_SIZE) continue;
+
+            // The goal is the cell of the cluster closest to its center where the robot fits
+            float centerColumn = (float) sumColumn/size;
+            float centerRow = (float) sumRow/size;
+            int bestCell = -1;
+            float bestCenterDistance = 0;
+            for(int i = 0; i < queueEnd; i++){
+                int cellColumn = queue[i] % GRID_COLUMNS;
+                int cellRow = queue[i] / GRID_COLUMNS;
+                float centerDistance = (cellColumn - centerColumn)*(cellColumn - centerColumn) +
+                                       (cellRow - centerRow)*(cellRow - centerRow);
+                if((bestCell < 0 || centerDistance < bestCenterDistance) && hasClearance(cellColumn, cellRow)){
+                    bestCell = queue[i];
+                    bestCenterDistance = centerDistance;
+                }
+            }
+            if(bestCell < 0) continue;
+
+            point_t candidate = mod_grid_cellToPoint(bestCell % GRID_COLUMNS, bestCell / GRID_COLUMNS);
+            float distance = distanceBetweenPoints(position, candidate);
+            if(distance < FRONTIER_MIN_DISTANCE || isNearVisitedGoal(candidate)) continue;
+
+            // Information gain is the size of the frontier, the cost is the distance to travel
+            float utility = size/(distance + FRONTIER_COST_OFFSET);
+            if(!isFound || utility > bestUtility){
+                bestUtility = utility;
+                *goal = candidate;
+                isFound = true;
+            }
+        }
+    }
+
+    if(isFound && numberOfGoals < FRONTIER_MAX_GOALS){
+        visitedGoals[numberOfGoals++] = *goal;
+    }
+    return isFound;
+}
+
+
+void mod_frontier_markUnreachable(point_t goal){
+    if(numberOfUnreachableGoals < FRONTIER_MAX_GOALS){
+        unreachableGoals[numberOfUnreachableGoals++] = goal;
+    }
+}
+
+
+void mod_frontier_endOfScan(void){
+    float coverage = mod_frontier_getCoverage();
+    lastGain = coverage - lastCoverage;
+    lastCoverage = coverage;
+
+    LOG_INFO(FMT_COVERAGE, (int) (100*coverage), (int) (1000*lastGain));
+}
+
+
+bool mod_frontier_isExplorationDone(void){
+    return lastCoverage >= FRONTIER_COVERAGE_TARGET || lastGain < FRONTIER_MIN_GAIN ||
+           numberOfGoals >= FRONTIER_MAX_GOALS;
+}
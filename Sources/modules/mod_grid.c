@@ -0,0 +1,204 @@
+/*
+ * File : mod_grid.c
+ * Project : e_puck_project
+ * Description : Module that stores the area as a log-odds occupancy grid
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_grid.h"
+
+// Standard headers
+#include <stdlib.h>
+#include <string.h>
+
+
+#define LOGODDS_HIT             9       // Added to a cell where the ray stops
+#define LOGODDS_PASS            -3      // Added to a cell crossed by the ray
+#define LOGODDS_LIMIT           100     // Saturation of a cell value
+#define THRESHOLD_OCCUPIED      5
+#define THRESHOLD_FREE          -2
+
+
+// Fixed size storage of the area, grid[row][column]
+static int8_t grid[GRID_ROWS][GRID_COLUMNS];
+
+// Stamp of the last change of each block, the stamp grows at each change of a cell state
+static uint32_t blockStamps[GRID_BLOCKS];
+static uint32_t stamp = 0;
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Check if the cell is inside the grid
+ *
+ * @param[in] column      The column of the cell
+ * @param[in] row         The row of the cell
+ *
+ * @param[out] True if it's in
+ */
+bool isInGrid(int column, int row);
+
+/**
+ * @brief Convert a coordinate to a cell index, also outside of the grid (floor division)
+ *
+ * @param[in] coordinate  The coordinate in mm
+ * @param[in] origin      The coordinate of the grid origin on this axis
+ *
+ * @param[out] The cell index
+ */
+int coordinateToCell(int coordinate, int origin);
+
+/**
+ * @brief Add a value to a cell with saturation
+ *
+ * @param[in] column      The column of the cell
+ * @param[in] row         The row of the cell
+ * @param[in] value       The value to add
+ */
+void addToCell(int column, int row, int value);
+
+/**
+ * @brief Returns the state matching a log-odds value
+ *
+ * @param[in] value       The log-odds value
+ *
+ * @param[out] The state
+ */
+cellState_t valueToState(int value);
+
+/***************/
+
+
+bool isInGrid(int column, int row){
+    return column >= 0 && column < GRID_COLUMNS && row >= 0 && row < GRID_ROWS;
+}
+
+
+int coordinateToCell(int coordinate, int origin){
+    int delta = coordinate - origin;
+    if(delta >= 0) return delta/GRID_CELL_SIZE;
+    return -((-delta + GRID_CELL_SIZE - 1)/GRID_CELL_SIZE);
+}
+
+
+void addToCell(int column, int row, int value){
+    if(!isInGrid(column, row)) return;
+
+    int newValue = grid[row][column] + value;
+    if(newValue > LOGODDS_LIMIT) newValue = LOGODDS_LIMIT;
+    else if(newValue < -LOGODDS_LIMIT) newValue = -LOGODDS_LIMIT;
+
+    if(valueToState(newValue) != valueToState(grid[row][column])){
+        blockStamps[(row/GRID_BLOCK_CELLS)*GRID_BLOCK_COLUMNS + column/GRID_BLOCK_CELLS] = ++stamp;
+    }
+    grid[row][column] = (int8_t) newValue;
+}
+
+
+cellState_t valueToState(int value){
+    if(value > THRESHOLD_OCCUPIED) return CELL_OCCUPIED;
+    if(value < THRESHOLD_FREE) return CELL_FREE;
+    return CELL_UNKNOWN;
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_grid_init(void){
+    mod_grid_reset();
+}
+
+
+void mod_grid_reset(void){
+    memset(grid, 0, sizeof(grid));
+    stamp++;
+    for(int i = 0; i < GRID_BLOCKS; i++) blockStamps[i] = stamp;
+}
+
+
+void mod_grid_updateRay(point_t origin, point_t end, bool hit){
+    // Cells are computed even outside of the grid, the traversal just skips them
+    int column0 = coordinateToCell(origin.x, GRID_ORIGIN_X);
+    int row0 = coordinateToCell(origin.y, GRID_ORIGIN_Y);
+    int column1 = coordinateToCell(end.x, GRID_ORIGIN_X);
+    int row1 = coordinateToCell(end.y, GRID_ORIGIN_Y);
+
+    // Integer Bresenham traversal, the last cell is handled after the loop
+    int deltaColumn = abs(column1 - column0);
+    int deltaRow = -abs(row1 - row0);
+    int stepColumn = column0 < column1 ? 1 : -1;
+    int stepRow = row0 < row1 ? 1 : -1;
+    int error = deltaColumn + deltaRow;
+
+    while(column0 != column1 || row0 != row1){
+        addToCell(column0, row0, LOGODDS_PASS);
+
+        int doubleError = 2*error;
+        if(doubleError >= deltaRow){
+            error += deltaRow;
+            column0 += stepColumn;
+        }
+        if(doubleError <= deltaColumn){
+            error += deltaColumn;
+            row0 += stepRow;
+        }
+    }
+
+    addToCell(column1, row1, hit ? LOGODDS_HIT : LOGODDS_PASS);
+}
+
+
+bool mod_grid_pointToCell(point_t point, int * column, int * row){
+    *column = coordinateToCell(point.x, GRID_ORIGIN_X);
+    *row = coordinateToCell(point.y, GRID_ORIGIN_Y);
+    return isInGrid(*column, *row);
+}
+
+
+point_t mod_grid_cellToPoint(int column, int row){
+    return (point_t) {GRID_ORIGIN_X + column*GRID_CELL_SIZE + GRID_CELL_SIZE/2,
+                      GRID_ORIGIN_Y + row*GRID_CELL_SIZE + GRID_CELL_SIZE/2};
+}
+
+
+cellState_t mod_grid_getCellState(int column, int row){
+    if(!isInGrid(column, row)) return CELL_UNKNOWN;
+    return valueToState(grid[row][column]);
+}
+
+
+cellState_t mod_grid_getState(point_t point){
+    int column, row;
+    if(!mod_grid_pointToCell(point, &column, &row)) return CELL_UNKNOWN;
+    return mod_grid_getCellState(column, row);
+}
+
+
+int8_t mod_grid_getLogOdds(int column, int row){
+    if(!isInGrid(column, row)) return 0;
+    return grid[row][column];
+}
+
+
+uint32_t mod_grid_getStamp(void){
+    return stamp;
+}
+
+
+bool mod_grid_getChangedBlock(int block, uint32_t since, gridRegion_t * region){
+    if(block < 0 || block >= GRID_BLOCKS || blockStamps[block] <= since) return false;
+
+    region->minColumn = (block % GRID_BLOCK_COLUMNS)*GRID_BLOCK_CELLS;
+    region->minRow = (block / GRID_BLOCK_COLUMNS)*GRID_BLOCK_CELLS;
+    region->maxColumn = region->minColumn + GRID_BLOCK_CELLS - 1;
+    region->maxRow = region->minRow + GRID_BLOCK_CELLS - 1;
+    if(region->maxColumn >= GRID_COLUMNS) region->maxColumn = GRID_COLUMNS - 1;
+    if(region->maxRow >= GRID_ROWS) region->maxRow = GRID_ROWS - 1;
+    return true;
+}
@@ -12,15 +12,18 @@
 #include "camera/dcmi_camera.h"
 #include "camera/po8030.h"
 #include "mod_communication.h"
+#include "mod_log.h"
 #include "stdio.h"
 #include "mod_check.h"
 #include "mod_basicIO.h"
 #include "mod_audio.h"
+#include "mod_compression.h"
 
 #define IMAGE_WALDY_BIAS 1000
-#define IMAGE_BUFFER_SIZE        19200
+#define IMAGE_CODEC              CODEC_LOSSY
 
 static uint8_t * imagePtr;
+static uint8_t compressedImage[IMAGE_SIZE];    // Sent from here, the raw picture if it does not fit
 
 void mod_image_happyToSeeWally(void){
     mod_audio_alertInterruption(SHORT);
@@ -35,9 +38,7 @@ void mod_image_whereIsWally(void){
         redcount += (int)((imagePtr[i]&0xF8)>>3);
         bluecount += (int)(imagePtr[i]&0x001F);
     }
-    char toSend[100];
-    sprintf(toSend, "redsum %d, bluesum%d",  redcount,  bluecount);
-    mod_com_writeMessage(toSend, 3);
+    LOG_INFO(FMT_COLOR_SUMS, redcount, bluecount);
     
     if((redcount-bluecount)>IMAGE_WALDY_BIAS) mod_image_happyToSeeWally();
 }
@@ -45,10 +46,11 @@ void mod_image_whereIsWally(void){
 void mod_img_init(void){
     if(dcmi_start()) error(DCMI_CAMERA_MEM_ALLOC);
     po8030_start();
-    imagePtr = malloc(IMAGE_BUFFER_SIZE*sizeof(uint8_t));
+    imagePtr = malloc(IMAGE_SIZE*sizeof(uint8_t));
     po8030_advanced_config(FORMAT_RGB565, 160, 0, 320, 480, SUBSAMPLING_X4, SUBSAMPLING_X4);
     dcmi_disable_double_buffering();
     dcmi_set_capture_mode(CAPTURE_ONE_SHOT);
+    mod_compress_init();
     
 }
 
@@ -56,6 +58,7 @@ void mod_img_init(void){
 void mod_image_capture(void){
     mod_basicIO_changeRobotState(ALL_OFF);
     chThdSleepMilliseconds(400);
+    mod_com_waitBulkEnd();     // The last picture is sent from the same buffers
     if(dcmi_prepare()) error(DCMI_CAMERA_SIZE_NOT_FIT);
     //starts a capture
     dcmi_capture_start();
@@ -77,9 +80,9 @@ void mod_image_capture(void){
 void mod_image_sendPicture(int x, int y){
     mod_image_capture();
     mod_image_whereIsWally();
-    char imageInfos[70];
-    sprintf(imageInfos, "Image:%d:%d: ", x, y);
-    mod_com_writeDatas(imageInfos, (char*) imagePtr,  IMAGE_BUFFER_SIZE);
+    size_t size = mod_compress_image(IMAGE_CODEC, imagePtr, compressedImage, IMAGE_SIZE);
+    if(size > 0) mod_com_sendImage(x, y, IMAGE_CODEC, compressedImage, size);
+    else mod_com_sendImage(x, y, CODEC_RAW, imagePtr, IMAGE_SIZE);
 }
 
 
@@ -0,0 +1,245 @@
+/*
+ * File : mod_localization.c
+ * Project : e_puck_project
+ * Description : Module that fuses the gyroscope and the wheels odometry in one pose estimate with its covariance
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_localization.h"
+
+// Standard headers
+#include <math.h>
+
+// Epuck/ChibiOS headers
+#include "msgbus/messagebus.h"
+#include "sensors/imu.h"
+#include <main.h>
+
+// Our headers
+#include "mod_odometry.h"
+#include "mod_motors.h"
+
+#define GYRO_Z_DIRECTION            1       // Sign between the gyroscope z axis and theta
+
+// Noise model of the filter
+#define GYRO_VARIANCE_RATE          1e-6f   // Variance of the integrated gyroscope angle (rad²/s)
+#define SLIP_VARIANCE_RATE          1e-4f   // Variance of the odometry rotation for each mm of wheel (rad²/mm)
+#define ODOMETRY_MIN_VARIANCE       1e-12f  // The robot can't turn if wheels don't move
+#define DISTANCE_VARIANCE_RATE      0.01f   // Variance of the travelled distance for each mm (mm²/mm)
+#define INITIAL_POSITION_VARIANCE   1.0f    // After a reset (mm²)
+#define INITIAL_ANGLE_VARIANCE      1e-4f   // After a reset (rad²)
+
+#define US_TO_S                     1000000
+#define BIAS_FILTER_GAIN            0.01f   // Speed of the gyroscope bias tracking when the robot is stopped
+
+
+// Position is kept in float, increments of one IMU period are smaller than 1 mm
+static float stateX = 0;
+static float stateY = 0;
+static float stateTheta = 0;
+static float covariance[3][3];
+static float gyroBias = 0;
+static systime_t lastUpdate = 0;
+
+MUTEX_DECL(estimate_lock);
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Put the angle in the interval 0 -> 2PI
+ *
+ * @param[in] angle     The angle to change
+ */
+void wrapAngle(float *angle);
+
+/**
+ * @brief Set the covariance to the uncertainty after a reset
+ */
+void resetCovariance(void);
+
+/**
+ * @brief Predict the new pose from one odometry and one gyroscope increment (lock must be taken)
+ *
+ * @param[in] leftDistance      Distance done by the left wheel (in mm)
+ * @param[in] rightDistance     Distance done by the right wheel (in mm)
+ * @param[in] gyroRate          Rotation speed measured by the gyroscope (in rad/s)
+ * @param[in] deltaTime         Time since the last update (in s)
+ */
+void predict(float leftDistance, float rightDistance, float gyroRate, float deltaTime);
+
+/**
+ * @brief Returns the estimate in the structure of the module (lock must be taken)
+ *
+ * @param[out] The estimate
+ */
+robotPoseEstimate_t buildEstimate(void);
+
+/***************/
+
+
+void wrapAngle(float *angle){
+    while(*angle >= 2*M_PI) *angle -= 2*M_PI;
+    while(*angle < 0) *angle += 2*M_PI;
+}
+
+
+void resetCovariance(void){
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++) covariance[i][j] = 0;
+    }
+    covariance[0][0] = INITIAL_POSITION_VARIANCE;
+    covariance[1][1] = INITIAL_POSITION_VARIANCE;
+    covariance[2][2] = INITIAL_ANGLE_VARIANCE;
+}
+
+
+void predict(float leftDistance, float rightDistance, float gyroRate, float deltaTime){
+    float distance = (leftDistance + rightDistance)/2;
+    float odometryRotation = (rightDistance - leftDistance)/(2*ROBOT_RADIUS);
+
+    // The bias drifts with temperature, it is followed while wheels don't move
+    if(leftDistance == 0 && rightDistance == 0){
+        gyroBias += BIAS_FILTER_GAIN*(gyroRate - gyroBias);
+    }
+    float gyroRotation = (gyroRate - gyroBias)*deltaTime;
+
+    // Rotation : both measurements are weighted by their variance (scalar Kalman update)
+    float odometryVariance = SLIP_VARIANCE_RATE*(fabsf(leftDistance) + fabsf(rightDistance)) + ODOMETRY_MIN_VARIANCE;
+    float gyroVariance = GYRO_VARIANCE_RATE*deltaTime;
+    float gain = odometryVariance/(odometryVariance + gyroVariance);
+    float rotation = odometryRotation + gain*(gyroRotation - odometryRotation);
+    float rotationVariance = (1 - gain)*odometryVariance;
+
+    // Midpoint integration, theta = 0 is the y axis
+    float sinus = sinf(stateTheta + rotation/2);
+    float cosinus = cosf(stateTheta + rotation/2);
+    stateX -= distance*sinus;
+    stateY += distance*cosinus;
+    stateTheta += rotation;
+    wrapAngle(&stateTheta);
+
+    // Covariance : P = F.P.F' + G.Q.G', F is the jacobian of the pose, G of (distance, rotation)
+    float f[3][3] = {{1, 0, -distance*cosinus},
+                     {0, 1, -distance*sinus},
+                     {0, 0, 1}};
+    float g[3][2] = {{-sinus, -distance*cosinus/2},
+                     {cosinus, -distance*sinus/2},
+                     {0, 1}};
+    float noise[2] = {DISTANCE_VARIANCE_RATE*fabsf(distance), rotationVariance};
+
+    float temp[3][3];
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            temp[i][j] = 0;
+            for(int k = 0; k < 3; k++) temp[i][j] += f[i][k]*covariance[k][j];
+        }
+    }
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++){
+            float value = g[i][0]*noise[0]*g[j][0] + g[i][1]*noise[1]*g[j][1];
+            for(int k = 0; k < 3; k++) value += temp[i][k]*f[j][k];
+            covariance[i][j] = value;
+        }
+    }
+}
+
+
+robotPoseEstimate_t buildEstimate(void){
+    robotPoseEstimate_t estimate;
+    estimate.position.x = (int) lroundf(stateX);
+    estimate.position.y = (int) lroundf(stateY);
+    estimate.position.theta = stateTheta;
+    for(int i = 0; i < 3; i++){
+        for(int j = 0; j < 3; j++) estimate.covariance[i][j] = covariance[i][j];
+    }
+    estimate.timestamp = lastUpdate;
+    return estimate;
+}
+
+
+/**
+ * @brief Thread that runs the filter for each IMU sample and publishes the estimate
+ */
+static THD_WORKING_AREA(localizationThread_wa, 1024);
+static THD_FUNCTION(localizationThread, arg){
+    (void) arg;
+
+    robotPoseEstimate_t message;
+    messagebus_topic_t localization_topic;
+    MUTEX_DECL(localization_topic_lock);
+    CONDVAR_DECL(localization_topic_condvar);
+    messagebus_topic_init(&localization_topic, &localization_topic_lock, &localization_topic_condvar, &message, sizeof(message));
+    messagebus_advertise_topic(&bus, &localization_topic, "/localization");
+
+    messagebus_topic_t *imu_topic = messagebus_find_topic_blocking(&bus, "/imu");
+    imu_msg_t imu_values;
+
+    int32_t lastLeft, lastRight;
+    mod_odometry_getWheelDistances(&lastLeft, &lastRight);
+    lastUpdate = chVTGetSystemTime();
+
+    while(1){
+        messagebus_topic_wait(imu_topic, &imu_values, sizeof(imu_values));
+
+        int32_t left, right;
+        mod_odometry_getWheelDistances(&left, &right);
+        systime_t time = chVTGetSystemTime();
+
+        // Differences are valid even if the totals wrapped around
+        float leftDistance = (int32_t)((uint32_t)left - (uint32_t)lastLeft)/(float)(1 << ODOMETRY_FRACTION_BITS);
+        float rightDistance = (int32_t)((uint32_t)right - (uint32_t)lastRight)/(float)(1 << ODOMETRY_FRACTION_BITS);
+
+        chMtxLock(&estimate_lock);
+        predict(leftDistance, rightDistance, GYRO_Z_DIRECTION*imu_values.gyro_rate[2],
+                ST2US(time - lastUpdate)/(float)US_TO_S);
+        lastUpdate = time;
+        message = buildEstimate();
+        chMtxUnlock(&estimate_lock);
+
+        lastLeft = left;
+        lastRight = right;
+
+        messagebus_topic_publish(&localization_topic, &message, sizeof(message));
+    }
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_localization_start(void){
+    resetCovariance();
+    chThdCreateStatic(localizationThread_wa, sizeof(localizationThread_wa), NORMALPRIO+8, localizationThread, NULL);
+}
+
+
+void mod_localization_setPosition(robotPosition_t position){
+    chMtxLock(&estimate_lock);
+    stateX = position.x;
+    stateY = position.y;
+    stateTheta = position.theta;
+    wrapAngle(&stateTheta);
+    resetCovariance();
+    chMtxUnlock(&estimate_lock);
+
+    // Odometry alone stays in the same coordinates system
+    mod_odometry_setPosition(position);
+}
+
+
+robotPosition_t mod_localization_getPosition(void){
+    return mod_localization_getEstimate().position;
+}
+
+
+robotPoseEstimate_t mod_localization_getEstimate(void){
+    chMtxLock(&estimate_lock);
+    robotPoseEstimate_t estimate = buildEstimate();
+    chMtxUnlock(&estimate_lock);
+    return estimate;
+}
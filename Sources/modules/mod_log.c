@@ -0,0 +1,62 @@
+/*
+ * File : mod_log.c
+ * Project : e_puck_project
+ * Description : Module that stores log records (format identifier, time and raw arguments), they are formatted by the receiver
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_log.h"
+
+// Epuck/ChibiOS headers
+#include <ch.h>
+
+
+// Records wait between tail and head, one place stays empty
+static logRecord_t ring[LOG_RING_SIZE];
+static uint16_t head = 0;
+static uint16_t tail = 0;
+static uint32_t dropped = 0;
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_log_write(logFormat_t format, const uint32_t * args, int numberOfArgs, uint8_t floatArgs){
+    uint32_t time = ST2MS(chVTGetSystemTimeX());
+
+    chSysLock();
+    uint16_t next = (head + 1) % LOG_RING_SIZE;
+    if(next == tail){
+        dropped++;
+        chSysUnlock();
+        return;
+    }
+    logRecord_t * record = &ring[head];
+    record->time = time;
+    record->format = format;
+    record->numberOfArgs = numberOfArgs;
+    record->floatArgs = floatArgs;
+    for(int i = 0; i < numberOfArgs; i++) record->args[i] = args[i];
+    head = next;
+    chSysUnlock();
+}
+
+
+bool mod_log_takeRecord(logRecord_t * record){
+    chSysLock();
+    if(tail == head){
+        chSysUnlock();
+        return false;
+    }
+    *record = ring[tail];
+    tail = (tail + 1) % LOG_RING_SIZE;
+    chSysUnlock();
+    return true;
+}
+
+
+uint32_t mod_log_getDropped(void){
+    return dropped;
+}
@@ -14,8 +14,14 @@
 #include <hal.h>
 #include "math.h"
 #include "mod_communication.h"
+#include "mod_log.h"
 #include "mod_basicIO.h"
 #include "mod_check.h"
+#include "mod_grid.h"
+#include "mod_objects.h"
+#include "mod_walls.h"
+#include "mod_localization.h"
+#include "mod_scanmatch.h"
 
 
 
@@ -24,33 +30,25 @@
 #define ROTATION_ELMT_TIME                              50
 #define TOLERATE_ERROR                                  4 // Error in mm
 #define TOLERANCE_WALL                                  50
+#define MIN_WALLS                                       3 // Fewer lines can't close the area
+#define SAME_WALL_ANGLE                                 (M_PI/8) // Lines closer than this in direction hide each other
+#define MIN_CORNER_ANGLE                                (M_PI/8) // Sharper corners have far and unstable intersections
 #define TOLERANCE_OBJECT                                60
 #define TOLERANCE_OBJECT_BIS                            20
 #define PICTURE_DISTANCE                                120
 
 #define ROBOT_RADIUS    27
 #define TOF_RADIUS      33
-#define NUMBER_OF_WALLS 4
 
 static robotPosition_t robotActualPosition;
 
-
-// Points of found objects
-typedef struct {
-    int x0;
-    int x2;
-    int y1;
-    int y3;
-} wall_t;
-
-wall_t wall;
+// Walls of the area, sorted by direction of their normal that points outside, corners[i] ends walls[i]
+static line_t walls[MAPPING_MAX_WALLS];
+static point_t corners[MAPPING_MAX_WALLS];
+static int numberOfWalls = 0;
 
 actualEnvironement_t environment;
 
-// Points of found objects
-point_t *objectList;
-int objectListSize=0;
-
 static int lastStepObjectDistance = 1000;
 
 
@@ -67,15 +65,9 @@ static int lastStepObjectDistance = 1000;
 void checkAngle(float *angle);
 
 /**
- * @brief Compute the new position of the robot based on a position and a displacement
- *
- * @param[in] lastPosition        The last position
- * @param[in] wheelSpeed          The speed of the displacement
- * @param[in] time                The time of the movement
+ * @brief Copy the last position fused by the localization thread in robotActualPosition
  */
-robotPosition_t newAbsolutePositionWheelSpeedType(robotPosition_t* lastPosition,
-                                                  const wheelSpeed_t *wheelSpeed, int time);
-
+void syncPosition(void);
 
 /**
  * @brief Returns the point corresponding to the object in the actual coordinates system
@@ -87,21 +79,9 @@ point_t measurementToPoint(measurement_t * measurement);
 /**
  * @brief Changes the origin location based on robot measures
  *
- * @param[in] intersection       The intersection of wall point
- * @param[in] thetaWall          The wall angle
- */
-void moveOrigin(point_t intersection, float thetaWall);
-
-
-
-/**
- * @brief Computes straight line coefs based on points
- *
- * @param[in] point       The list of points
- * @param[in] nbPoints    The number of points
- * @param[in] tot         The table where to store coefs (y = a*x + b, tot[0] = a, tot[1] = b)
+ * @param[in] newPosition        The position of the robot in the new coordinates system
  */
-void computeCoefDirecteur(point_t * point, int nbPoints, float * tot);
+void moveOrigin(robotPosition_t newPosition);
 
 
 /**
@@ -114,26 +94,29 @@ void computeCoefDirecteur(point_t * point, int nbPoints, float * tot);
  */
 int computeObjectDistance(point_t point1, point_t point2);
 
+/**
+ * @brief Returns the absolute difference between two angles, between 0 and PI
+ */
+float angleBetween(float angle1, float angle2);
 
 /**
- * @brief Check if a point is in the circle around another point (defined by TOLERANCE_OBJECT)
- *
- * @param[in] point1      The point
- * @param[in] circle      The object
+ * @brief Computes the intersection of two lines, they must not be parallel
  *
- * @param[out] True if it's in
+ * @param[in] line1       The first line
+ * @param[in] line2       The second line
+ * @param[out] x          The x coordinate of the intersection
+ * @param[out] y          The y coordinate of the intersection
  */
-bool checkIfPointObjectInCircle(point_t point, point_t circle);
-
+void intersectLines(const line_t * line1, const line_t * line2, float * x, float * y);
 
 /**
- * @brief Check if the object is in the object list
+ * @brief Returns the wall that explains a point, on its line or behind it
  *
- * @param[in] object      The object to check
+ * @param[in] point       The point
  *
- * @param[out] True if it's in
+ * @param[out]      The index of the wall, -1 if no wall explains the point
  */
-bool checkIfObjectExists(point_t object);
+int findWall(point_t point);
 
 
 /**
@@ -154,19 +137,35 @@ void checkAngle(float *angle){
 }
 
 
-robotPosition_t newAbsolutePositionWheelSpeedType(robotPosition_t* lastPosition,
-                                                  const wheelSpeed_t *wheelSpeed, int time){
-    robotPosition_t newPosition;
-    newPosition.x = lastPosition->x +   time*(wheelSpeed->right+wheelSpeed->left)*cos(lastPosition->theta+M_PI/2)/(2*1000);
-    newPosition.y = lastPosition->y +   time*(wheelSpeed->right+wheelSpeed->left)*sin(lastPosition->theta+M_PI/2)/(2*1000);
-    newPosition.theta = lastPosition->theta +   (wheelSpeed->right-wheelSpeed->left)*time/(ROBOT_RADIUS*2*1000); // A revoir (1020)
-    
-    
-    checkAngle(&newPosition.theta);
-    
-    return newPosition;
+float angleBetween(float angle1, float angle2){
+    float angle = fabsf(angle1 - angle2);
+    while(angle > 2*M_PI) angle -= 2*M_PI;
+    if(angle > M_PI) angle = 2*M_PI - angle;
+    return angle;
+}
+
+
+void intersectLines(const line_t * line1, const line_t * line2, float * x, float * y){
+    float determinant = sinf(line2->angle - line1->angle);
+    *x = (line1->distance*sinf(line2->angle) - line2->distance*sinf(line1->angle))/determinant;
+    *y = (line2->distance*cosf(line1->angle) - line1->distance*cosf(line2->angle))/determinant;
 }
 
+
+int findWall(point_t point){
+    for(int i=0; i < numberOfWalls; i++){
+        float distance = point.x*cosf(walls[i].angle) + point.y*sinf(walls[i].angle) - walls[i].distance;
+        if(distance > -TOLERANCE_WALL) return i;
+    }
+    return -1;
+}
+
+
+void syncPosition(void){
+    robotActualPosition = mod_localization_getPosition();
+}
+
+
 point_t measurementToPoint(measurement_t * measurement){
     point_t point;
     point.x = -(measurement->value+TOF_RADIUS)*sin(measurement->position.theta)+measurement->position.x;
@@ -175,53 +174,18 @@ point_t measurementToPoint(measurement_t * measurement){
 }
 
 
-void moveOrigin(point_t intersection, float thetaWall){
-    robotActualPosition.x -= cos(thetaWall)*intersection.x - sin(thetaWall)*intersection.y;
-    robotActualPosition.y -= sin(thetaWall)*intersection.x + cos(thetaWall)*intersection.y;
-    robotActualPosition.theta += thetaWall;
+void moveOrigin(robotPosition_t newPosition){
+    robotActualPosition = newPosition;
     checkAngle(&robotActualPosition.theta);
-    char toSend[50];
-    sprintf(toSend, "New origin: %d, %d, %f", robotActualPosition.x, robotActualPosition.y, robotActualPosition.theta);
-    mod_com_writeMessage(toSend, 3);
+    mod_localization_setPosition(robotActualPosition);
+    mod_com_sendPose(robotActualPosition);
 }
 
 
-void computeCoefDirecteur(point_t * point, int nbPoints, float * tot){
-    float m, p, mtot = .0, ptot = .0;
-    int i;
-    for(i=0;i <(nbPoints-2);i++){
-        m =  (float) (point[i].y-point[i+2].y) / (float) (point[i].x-point[i+2].x);
-        p = (float) point[i].y - m * point[i].x;
-        
-
-        mtot += m;
-        ptot += p;
-    }
-    tot[0] = mtot/i;
-    tot[1] = ptot/i;
-    char toSend[50];
-    sprintf(toSend, "m: %f / %f", mtot, ptot);
-    mod_com_writeMessage(toSend, 3);
-    
-}
-
 int computeObjectDistance(point_t point1, point_t point2){
     return sqrt((point1.x-point2.x)*(point1.x-point2.x) + (point1.y-point2.y)*(point1.y-point2.y));
 }
 
-bool checkIfPointObjectInCircle(point_t point, point_t circle){
-    if(((point.x-circle.x)*(point.x-circle.x) + (point.y-circle.y)*(point.y-circle.y)) < TOLERANCE_OBJECT) return true;
-    else return false;
-    
-}
-
-bool checkIfObjectExists(point_t object){
-    for(int i = 0; i < objectListSize; i++)
-        if(checkIfPointObjectInCircle(object, objectList[i]))
-            return true;
-    return false;
-}
-
 bool isNear(point_t point){
     if(computeObjectDistance(point, (point_t) {robotActualPosition.x, robotActualPosition.y}) < TOF_RADIUS + 150){
         return true;
@@ -237,203 +201,193 @@ bool isNear(point_t point){
 
 void mod_mapping_init(void){
 
+    mod_grid_init();
+    mod_objects_init();
     mod_mapping_resetCoordinates();
-    
-    objectList = malloc(sizeof(point_t));
-    assert(objectList);
 }
 
 
 void mod_mapping_resetCoordinates(void){
     robotActualPosition = (robotPosition_t) {0,0,0};
+    mod_localization_setPosition(robotActualPosition);
+    mod_grid_reset();
 }
 
 
-void mod_mapping_updatePositionWheelSpeedType(const wheelSpeed_t *wheelSpeed, int time){
-    robotActualPosition = newAbsolutePositionWheelSpeedType(&robotActualPosition, wheelSpeed, time);
-    char toSend[50];
-    sprintf(toSend, "New position:%d:%d:%f: ", robotActualPosition.x, robotActualPosition.y, robotActualPosition.theta);
-    mod_com_writeMessage(toSend, 3);
+void mod_mapping_addMeasurement(measurement_t * measurement){
+    if(measurement->value < 1) return;
+    
+    point_t origin = {measurement->position.x, measurement->position.y};
+    if(measurement->value > GRID_MAX_RANGE){
+        measurement_t limit = {measurement->position, GRID_MAX_RANGE};
+        mod_grid_updateRay(origin, measurementToPoint(&limit), false);
+    }
+    else{
+        point_t end = measurementToPoint(measurement);
+        mod_grid_updateRay(origin, end, true);
+        mod_scanmatch_addPoint(end);
+    }
 }
 
 
-bool mod_mapping_computeWallLocation(measurement_t* measurement){
-    int i;
-    int measureNumber = 0;
-    int currentTable = 0;
+void mod_mapping_startSweep(void){
+    mod_scanmatch_reset();
+}
+
+
+bool mod_mapping_relocalize(void){
+    if(numberOfWalls == 0) return false; // Walls are not known yet
     
-    typedef enum {
-        INCREASING =0,
-        DECREASING,
-        NOTHING
-    } direction_t;
+    syncPosition();
+    scanMatch_t match = mod_scanmatch_match(walls, numberOfWalls, robotActualPosition);
+    if(!match.converged || match.inliers < SCANMATCH_MIN_INLIERS) return false;
     
-    typedef struct {
-        measurement_t* measurement[NUMBER_OF_STEPS];
-        direction_t direction;
-        int total;
-    } measurementsVariations_t;
+    robotActualPosition.x += lroundf(match.x);
+    robotActualPosition.y += lroundf(match.y);
+    robotActualPosition.theta += match.theta;
+    checkAngle(&robotActualPosition.theta);
+    mod_localization_setPosition(robotActualPosition);
+    mod_scanmatch_reset();
     
-    measurementsVariations_t * table = malloc(8*sizeof(measurementsVariations_t));
-    assert(table);
-    table[currentTable].direction = NOTHING;
-    for(i=0; i < NUMBER_OF_STEPS; i++){
-        if(measurement[i].value < 50) continue;
+    mod_com_sendPose(robotActualPosition);
+    LOG_INFO(FMT_RELOCALIZED, match.iterations);
+    return true;
+}
 
-        
-        if((table[currentTable].direction == NOTHING) && (measureNumber == 0)){
-            table[currentTable].measurement[measureNumber] = &measurement[i];
+
+void mod_mapping_updatePosition(void){
+    syncPosition();
+    mod_com_sendPose(robotActualPosition);
+}
+
+
+void mod_mapping_startWallDiscovery(void){
+    mod_walls_reset();
+}
+
+
+void mod_mapping_addWallMeasurement(measurement_t * measurement){
+    if(measurement->value < 50 || measurement->value > GRID_MAX_RANGE) return;
+    mod_walls_addPoint(measurementToPoint(measurement));
+}
+
+
+bool mod_mapping_computeWallLocation(void){
+    line_t lines[MAPPING_MAX_WALLS];
+    int numberOfLines = mod_walls_findLines(lines, MAPPING_MAX_WALLS);
+    
+    // Direction and distance of each wall seen from the robot, sorted by direction
+    syncPosition();
+    line_t seen[MAPPING_MAX_WALLS];
+    int numberOfSeen = 0;
+    for(int i=0; i < numberOfLines; i++){
+        line_t line = lines[i];
+        line.distance -= robotActualPosition.x*cosf(line.angle) + robotActualPosition.y*sinf(line.angle);
+        if(line.distance < 0){
+            line.distance = -line.distance;
+            line.angle += M_PI;
         }
+        checkAngle(&line.angle);
         
-        else if(table[currentTable].direction == NOTHING) {
-            if(measurement[i].value < table[currentTable].measurement[0]->value){
-                table[currentTable].direction = DECREASING;
-                table[currentTable].measurement[measureNumber] = &measurement[i];
-            }
-            else if(measurement[i].value == table[currentTable].measurement[0]->value){
-                continue;
-            }
-            else{
-                table[currentTable].direction = INCREASING;
-                table[currentTable].measurement[measureNumber] = &measurement[i];
-            }
-        }
-        else if(table[currentTable].direction == DECREASING) {
-            if(measurement[i].value < table[currentTable].measurement[measureNumber-1]->value){
-                table[currentTable].measurement[measureNumber] = &measurement[i];
-            }
-            else if(measurement[i].value == table[currentTable].measurement[measureNumber-1]->value){
-                continue;
-            }
-            else{
-                table[currentTable].total=measureNumber;
-                currentTable++;
-                measureNumber = 0;
-                if(currentTable>7) break;
-                table[currentTable].measurement[measureNumber] = &measurement[i];
-                table[currentTable].direction = INCREASING;
-            }
+        // An object in front of a wall is seen in the same direction, the lines come by number of points
+        bool isHidden = false;
+        for(int j=0; j < numberOfSeen; j++){
+            if(angleBetween(seen[j].angle, line.angle) < SAME_WALL_ANGLE) isHidden = true;
         }
-        else if(table[currentTable].direction == INCREASING) {
-            if(measurement[i].value > table[currentTable].measurement[measureNumber-1]->value){
-                table[currentTable].measurement[measureNumber] = &measurement[i];
-            }
-            else if(measurement[i].value == table[currentTable].measurement[measureNumber-1]->value){
-                continue;
-            }
-            else{
-                table[currentTable].total=measureNumber;
-                currentTable++;
-                measureNumber = 0;
-                if(currentTable>7) break;
-                table[currentTable].measurement[measureNumber] = &measurement[i];
-                table[currentTable].direction = DECREASING;
-            }
+        if(isHidden) continue;
+        
+        int position = numberOfSeen++;
+        while(position > 0 && seen[position-1].angle > line.angle){
+            seen[position] = seen[position-1];
+            position--;
         }
-        measureNumber++;
+        seen[position] = line;
     }
-    table[currentTable].total=measureNumber;
+    if(numberOfSeen < MIN_WALLS) return false;
     
-
-    if(currentTable <7) return false;
+    // Consecutive walls must meet on the side of the robot, else the area is open
+    for(int i=0; i < numberOfSeen; i++){
+        float turn = seen[(i+1) % numberOfSeen].angle - seen[i].angle;
+        if(turn < 0) turn += 2*M_PI;
+        if(turn > M_PI - MIN_CORNER_ANGLE) return false;
+    }
     
-    int j;
-    float coefsWall[NUMBER_OF_WALLS][2];
+    float cornerX[MAPPING_MAX_WALLS];
+    float cornerY[MAPPING_MAX_WALLS];
+    for(int i=0; i < numberOfSeen; i++){
+        intersectLines(&seen[i], &seen[(i+1) % numberOfSeen], &cornerX[i], &cornerY[i]);
+    }
     
-    {
-        point_t * wall[NUMBER_OF_WALLS];
-        int step[NUMBER_OF_WALLS] ={0,0,0,0};
-        
-        for(int i =0; i <NUMBER_OF_WALLS;i++) wall[i] = malloc(sizeof(point_t));
-        int id;
-        for(i=0;i<8;i++){
-            id = i/2;
-            for(j=0;j<table[i].total;j++){
-                wall[id] = realloc(wall[id], (step[id]+1)*sizeof(point_t));
-                assert(wall[id]);
-                wall[id][step[id]] = measurementToPoint(table[i].measurement[j]);
-                step[id]++;
-            }
-        }
-        free(table);
-        table = NULL;
-        
-        
-        for(int i =0; i <NUMBER_OF_WALLS;i++){
-            computeCoefDirecteur(wall[i], step[i], coefsWall[i]);
+    // Choose the wall that becomes x = 0, keep the same orientation than the reception program (x is the smallest side)
+    float rotation = 0, minX = 0, minY = 0, maxX = 0, maxY = 0;
+    for(int reference=numberOfSeen-1; reference >= 0; reference--){
+        rotation = M_PI - seen[reference].angle;
+        minX = minY = INFINITY;
+        maxX = maxY = -INFINITY;
+        for(int i=0; i < numberOfSeen; i++){
+            float x = cornerX[i]*cosf(rotation) - cornerY[i]*sinf(rotation);
+            float y = cornerX[i]*sinf(rotation) + cornerY[i]*cosf(rotation);
+            minX = fminf(minX, x);
+            maxX = fmaxf(maxX, x);
+            minY = fminf(minY, y);
+            maxY = fmaxf(maxY, y);
         }
-        for(int i =0; i <NUMBER_OF_WALLS;i++){
-            free(wall[i]);
-            wall[i] = NULL;}
+        if(maxX - minX <= maxY - minY) break;
     }
-
-    point_t intersection[NUMBER_OF_WALLS-1];
-    for(int i=1;i < NUMBER_OF_WALLS;i++){
-        intersection[i-1].x = (coefsWall[i][1] - coefsWall[i-1][1]) /(coefsWall[i-1][0] - coefsWall[i][0]);
-        intersection[i-1].y =  coefsWall[i][0] * intersection[i-1].x + coefsWall[i][1];
-    }
-    float thetaWall = (-atan(coefsWall[1][0]));
-
-    moveOrigin(intersection[0], thetaWall);
     
-    wall.x0 = 0;
-    wall.y1 = 0;
-    wall.x2 = robotActualPosition.x + cos(thetaWall)*intersection[1].x - sin(thetaWall)*intersection[1].y;
-    wall.y3 = robotActualPosition.y + sin(thetaWall)*intersection[2].x + cos(thetaWall)*intersection[2].y;
+    float theta = robotActualPosition.theta + rotation;
+    checkAngle(&theta);
+    moveOrigin((robotPosition_t) {-minX, -minY, theta});
+    mod_grid_reset(); // Cells were stored in the old coordinates system
+    
+    // The robot is at (-minX, -minY) in the new coordinates system
+    numberOfWalls = numberOfSeen;
+    for(int i=0; i < numberOfWalls; i++){
+        walls[i].angle = seen[i].angle + rotation;
+        checkAngle(&walls[i].angle);
+        walls[i].distance = seen[i].distance - minX*cosf(walls[i].angle) - minY*sinf(walls[i].angle);
+        walls[i].inliers = seen[i].inliers;
+        corners[i].x = lroundf(cornerX[i]*cosf(rotation) - cornerY[i]*sinf(rotation) - minX);
+        corners[i].y = lroundf(cornerX[i]*sinf(rotation) + cornerY[i]*cosf(rotation) - minY);
+    }
     
-    char toSend[50];
-    sprintf(toSend, "Walls:%d:%d: ",  wall.x2,  wall.y3);
-    mod_com_writeMessage(toSend, 3);
+    mod_com_sendWalls(corners, numberOfWalls);
     
     return true;
-    
 }
 
 
 robotDistance_t mod_mapping_getRobotDisplacement(const point_t * newAbsolutePosition){
     robotDistance_t displacement;
+    syncPosition();
     
     int deltaX = newAbsolutePosition->x - robotActualPosition.x;
     int deltaY = newAbsolutePosition->y - robotActualPosition.y;
-    float movementAngle = atan(deltaY/deltaX);
-    
-    char toSend[50];
-    sprintf(toSend, "deltaX: %d, deltaY; %d angle: %f",  deltaX,  deltaY, movementAngle);
-    mod_com_writeMessage(toSend, 3);
+    float movementAngle = atan2f(deltaY, deltaX); // Defined for all quadrants, deltaX = 0 included
     
-    //displacement.rotation= acos((deltaX*cos(robotActualPosition.theta+M_PI/2) + deltaY*sin(robotActualPosition.theta+M_PI/2))/sqrt(deltaX*deltaX+deltaY*deltaY));
-    //if((robotActualPosition.theta+M_PI/2 < movementAngle && M_PI + robotActualPosition.theta+M_PI/2 > movementAngle))
-       // displacement.rotation = -displacement.rotation;
-
-    float angle;
-    
-    if(deltaX >= 0 ){
-        angle = 3*M_PI/2 - robotActualPosition.theta + atan(deltaY / deltaX);
-    }
-    else{
-        angle = M_PI/2 - robotActualPosition.theta + atan(deltaY / deltaX);
-    }
-
-    displacement.rotation = angle;
+    LOG_INFO(FMT_MOVEMENT, deltaX, deltaY, movementAngle);
     
+    // The direction of the robot is theta + PI/2
+    displacement.rotation = movementAngle - robotActualPosition.theta - M_PI/2;
     displacement.translation = sqrt(deltaX*deltaX + deltaY*deltaY);
 
     while(displacement.rotation > M_PI) displacement.rotation -= 2*M_PI;
     while(displacement.rotation < -M_PI) displacement.rotation += 2*M_PI;
     
-    sprintf(toSend, "To do: %d, %f",  displacement.translation,  displacement.rotation);
-    mod_com_writeMessage(toSend, 3);
+    LOG_INFO(FMT_TO_DO, displacement.translation, displacement.rotation);
 
     return displacement;
 }
 
 
 robotPosition_t mod_mapping_getActualPosition(void){
+    syncPosition();
     return robotActualPosition;
 }
 
 
 float mod_mapping_getRelativeAngle(const float angle){
+    syncPosition();
     float newAngle = angle - robotActualPosition.theta - M_PI/2;
     
     while(newAngle > M_PI) newAngle -= 2*M_PI;
@@ -444,41 +398,36 @@ float mod_mapping_getRelativeAngle(const float angle){
 
 
 void mod_mapping_checkEnvironment(measurement_t * measurement, int numberOfMeasurements){
-    point_t * point = malloc(numberOfMeasurements*sizeof(point_t));
-    assert(point);
     environment.numberOfknownObjects = 0;
     environment.numberOfnewObjects = 0;
+    syncPosition();
     
-    for(int i=0; i< NUMBER_OF_WALLS; i++){
+    for(int i=0; i< MAPPING_MAX_WALLS; i++){
         environment.nearWall[i] = false;
     }
     
     for(int i=0; i< numberOfMeasurements; i++){
         if(measurement[i].value < 1) continue;
-        point[i] = measurementToPoint(&measurement[i]);
+        point_t point = measurementToPoint(&measurement[i]);
         
-        if(!isNear(point[i])) continue;
+        if(!isNear(point)) continue;
+        if(mod_grid_getState(point) != CELL_OCCUPIED) continue; // Contradicted or not confirmed by the rays
         
-        if(point[i].x < wall.x0 + TOLERANCE_WALL) environment.nearWall[0] = true;
-        else if(point[i].x > wall.x2 - TOLERANCE_WALL) environment.nearWall[1] = true;
-        else if(point[i].y < wall.y1 + TOLERANCE_WALL) environment.nearWall[2] = true;
-        else if(point[i].y > wall.y3 - TOLERANCE_WALL) environment.nearWall[3] = true;
+        int wallIndex = findWall(point);
+        if(wallIndex >= 0) environment.nearWall[wallIndex] = true;
         
         else{
-            if(checkIfObjectExists(point[i])){
-                environment.knownObjectsLocation[environment.numberOfknownObjects] = point[i];
+            bool isNew;
+            if(mod_objects_merge(point, TOLERANCE_OBJECT, &isNew) == OBJECT_NONE) continue;
+            
+            if(!isNew){
+                environment.knownObjectsLocation[environment.numberOfknownObjects] = point;
                 environment.numberOfknownObjects++;
             }
             else{
-                environment.newObjectsLocation[environment.numberOfnewObjects] = point[i];
+                environment.newObjectsLocation[environment.numberOfnewObjects] = point;
                 environment.numberOfnewObjects++;
-                char toSend[50];
-                sprintf(toSend, "New object found: %d, %d", point[i].x, point[i].y);
-                mod_com_writeMessage(toSend, 3);
-                
-                objectList = realloc(objectList, sizeof(point_t)*(objectListSize+1));
-                objectList[objectListSize] = point[i];
-                objectListSize++;
+                mod_com_sendObject(point);
             }
             if((environment.numberOfnewObjects == 3) || (environment.numberOfknownObjects == 3)){
                 break;
@@ -487,9 +436,6 @@ void mod_mapping_checkEnvironment(measurement_t * measurement, int numberOfMeasu
         
     }
     
-    free(point);
-    point = NULL;
-    
 }
 
 
@@ -497,38 +443,39 @@ robotDistance_t mod_mapping_computeDistanceForPicture(point_t point){
     robotDistance_t toDo = mod_mapping_getRobotDisplacement(&point);
     toDo.translation -= PICTURE_DISTANCE + TOF_RADIUS;
     
-    char toSend[50];
-    sprintf(toSend, "To do2: %d, %f",  toDo.translation,  toDo.rotation);
-    mod_com_writeMessage(toSend, 3);
+    LOG_INFO(FMT_TO_DO_PICTURE, toDo.translation, toDo.rotation);
     
     return toDo;
 }
 
 
 point_t mod_mapping_getAreaCenter(void){
-    return (point_t) {wall.x2/2, wall.y3/2};
+    // Mean of the corners, inside of the area as it is convex
+    point_t center = {0, 0};
+    for(int i=0; i < numberOfWalls; i++){
+        center.x += corners[i].x;
+        center.y += corners[i].y;
+    }
+    if(numberOfWalls > 0){
+        center.x /= numberOfWalls;
+        center.y /= numberOfWalls;
+    }
+    return center;
 }
 
 
 point_t mod_mapping_checkEnvironmentRobotReferencial(measurement_t * measurement, bool considerWalls){
     point_t point = measurementToPoint(measurement);
     
-    char toSend[50];
-    sprintf(toSend, "PointClosest:%d:%d: ", point.x, point.y);
-    mod_com_writeMessage(toSend, 3);
+    mod_com_sendScanPoint(point, SCAN_CLOSEST);
     
     int distance = measurement->value + TOF_RADIUS;
     if(considerWalls){
-        if(checkIfObjectExists(point)){
-            sprintf(toSend, "Already seen");
-            mod_com_writeMessage(toSend, 3);
+        bool isNew;
+        if(mod_objects_merge(point, TOLERANCE_OBJECT, &isNew) != OBJECT_NONE && !isNew){
+            LOG_INFO(FMT_ALREADY_SEEN);
             return (point_t){-1,-1};
         }
-        else{
-            objectList = realloc(objectList, sizeof(point_t)*(objectListSize+1));
-            objectList[objectListSize] = point;
-            objectListSize++;
-        }
     }
     else{
         if((distance < lastStepObjectDistance + TOLERANCE_OBJECT_BIS && distance > lastStepObjectDistance - TOLERANCE_OBJECT_BIS)){
@@ -543,21 +490,17 @@ point_t mod_mapping_checkEnvironmentRobotReferencial(measurement_t * measurement
 bool mod_mapping_checkEnvironmentLimitsRobotReferencial(measurement_t * measurement, bool considerWalls){
     point_t point = measurementToPoint(measurement);
     
-    char toSend[50];
-    sprintf(toSend, "PointInEnvironment:%d:%d: ", point.x, point.y);
-    mod_com_writeMessage(toSend, 3);
+    mod_com_sendScanPoint(point, SCAN_ENVIRONMENT);
     
     int distance = measurement->value + TOF_RADIUS;
     
     if(considerWalls){
-        if(point.x < wall.x0 + TOLERANCE_WALL || point.x > wall.x2 - TOLERANCE_WALL ||
-           point.y < wall.y1 + TOLERANCE_WALL || point.y > wall.y3 - TOLERANCE_WALL){
+        if(mod_grid_getState(point) != CELL_OCCUPIED || findWall(point) >= 0){
             lastStepObjectDistance = 1000;
             return true;
         }
         else{
-            sprintf(toSend, "Not a wall");
-            mod_com_writeMessage(toSend, 3);
+            LOG_INFO(FMT_NOT_A_WALL);
             return false;
         }
     }
@@ -577,19 +520,20 @@ int mod_mapping_computeDistanceForPictureRobotReferencial(measurement_t * measur
 }
 
 // returns the relative angle to do and the distance to take
-robotDistance_t mod_mapping_findObjectBestPosition(measurement_t* measurement, point_t* newPoint, bool considerWalls){
-    measurement_t* currentMeasurement = &measurement[0];
-    measurement_t* bestMeasurement = &measurement[0];
-    float angleToDo = -SIZE_FRONT_SCAN;
-    int distanceMin = currentMeasurement->value;
-    for(int i =0; i < NUMBER_OF_STEPS_FRONT; i++ ){
-        if(currentMeasurement->value < distanceMin){
-            distanceMin = currentMeasurement->value;
-            bestMeasurement = currentMeasurement;
-            angleToDo = i* ANGLE_ELEMENT_FRONT-SIZE_FRONT_SCAN;
+robotDistance_t mod_mapping_findObjectBestPosition(measurement_t* measurement, int numberOfMeasurements, point_t* newPoint, bool considerWalls){
+    measurement_t* bestMeasurement = NULL;
+    for(int i =0; i < numberOfMeasurements; i++ ){
+        if(measurement[i].value < 1) continue;
+        if(bestMeasurement == NULL || measurement[i].value < bestMeasurement->value){
+            bestMeasurement = &measurement[i];
         }
-        currentMeasurement++;
     }
+    if(bestMeasurement == NULL){
+        *newPoint = (point_t){-1,-1};
+        return (robotDistance_t) {0, 0};
+    }
+    // Each sample has its own pose, the rotation is relative to the actual orientation
+    float angleToDo = mod_mapping_getRelativeAngle(bestMeasurement->position.theta + M_PI/2);
     *newPoint = mod_mapping_checkEnvironmentRobotReferencial(bestMeasurement, considerWalls);
     return (robotDistance_t) {mod_mapping_computeDistanceForPictureRobotReferencial(bestMeasurement), angleToDo};
 }
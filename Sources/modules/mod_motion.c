@@ -0,0 +1,374 @@
+/*
+ * File : mod_motion.c
+ * Project : e_puck_project
+ * Description : Module that executes a queue of motion segments (line, arc, rotation, point) without stopping between them
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_motion.h"
+
+// Standard headers
+#include <math.h>
+#include <stddef.h>
+
+// Epuck/ChibiOS headers
+#include <ch.h>
+
+// Our headers
+#include "mod_motors.h"
+#include "mod_odometry.h"
+#include "mod_localization.h"
+
+#define MOTION_ACCELERATION         100.0f  // Of the fastest wheel (in mm/s²)
+#define MOTION_MAX_SPEED_JUMP       20.0f   // Speed change that the steppers do without ramp (in mm/s)
+#define MOTION_MIN_SPEED            5.0f    // Under this speed the robot would never finish a segment (in mm/s)
+
+/**
+ * @brief Distances that each wheel must do for a segment
+ */
+typedef struct {
+    float left;
+    float right;
+    float length;       // Distance of the fastest wheel (in mm)
+} wheelTarget_t;
+
+
+// Segments are preallocated, the free ones wait in a second mailbox
+static motionSegment_t segmentsPool[MOTION_QUEUE_SIZE];
+static msg_t freeBuffer[MOTION_QUEUE_SIZE];
+static msg_t pendingBuffer[MOTION_QUEUE_SIZE];
+static MAILBOX_DECL(freeSegments, freeBuffer, MOTION_QUEUE_SIZE);
+static MAILBOX_DECL(pendingSegments, pendingBuffer, MOTION_QUEUE_SIZE);
+
+// Segments taken by the thread, the first one is running and the next ones are the lookahead
+static motionSegment_t * segments[MOTION_QUEUE_SIZE];
+static int numberOfSegments = 0;
+static int remainingSegments = 0;      // Enqueued and not finished
+static bool isStopped = true;
+
+// Profile of the running line, arc or rotation
+static const motionSegment_t * profiled = NULL;
+static wheelTarget_t target = {0, 0, 0};
+static float done = 0;                  // Progress of the fastest wheel on the segment (in mm)
+static float carried = 0;               // Overshoot of the previous segment, already done on this one (in mm)
+static float speed = 0;
+static int32_t lastLeft = 0, lastRight = 0;
+
+// Points given to the pursuit, the last finished one is kept so the controller still aims on its segment
+static point_t pursuitPoints[MOTION_QUEUE_SIZE + 1];
+static point_t previousPoint;
+static bool hasPrevious = false;
+
+// Taken by the thread during a tick and by the functions that remove segments
+MUTEX_DECL(motion_lock);
+BSEMAPHORE_DECL(motionIdle_sem, true);
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Compute the distances of the wheels for a segment
+ *
+ * @param[in] segment   The segment
+ *
+ * @param[out] The distances
+ */
+wheelTarget_t computeWheelTarget(const motionSegment_t * segment);
+
+/**
+ * @brief Returns the speed at which the robot can go from a segment to the next one without stopping
+ *
+ * @param[in] current   The finishing segment
+ * @param[in] next      The next segment
+ *
+ * @param[out] The speed of the fastest wheel at the junction (in mm/s)
+ */
+float computeJunctionSpeed(const motionSegment_t * current, const motionSegment_t * next);
+
+/**
+ * @brief Call the callbacks of the first segments and give them back to the pool
+ *
+ * @param[in] number    The number of finished segments
+ */
+void finishSegments(int number);
+
+/**
+ * @brief Give all the segments back to the pool without calling their callbacks, with the lock
+ */
+void discardSegments(void);
+
+/**
+ * @brief One tick on the points at the head of the queue, with the pure pursuit controller
+ */
+void followPoints(void);
+
+/**
+ * @brief One tick on the line, arc or rotation at the head of the queue, with a trapezoidal profile
+ */
+void followProfile(void);
+
+/***************/
+
+
+wheelTarget_t computeWheelTarget(const motionSegment_t * segment){
+    wheelTarget_t target;
+    float length = (segment->type == MOTION_ROTATE) ? 0 : segment->length;
+    float angle = (segment->type == MOTION_LINE) ? 0 : segment->angle;
+    target.left = length - angle*ROBOT_RADIUS;
+    target.right = length + angle*ROBOT_RADIUS;
+    target.length = fmaxf(fabsf(target.left), fabsf(target.right));
+    return target;
+}
+
+
+float computeJunctionSpeed(const motionSegment_t * current, const motionSegment_t * next){
+    wheelTarget_t first = computeWheelTarget(current);
+    wheelTarget_t second = computeWheelTarget(next);
+    if(first.length == 0 || second.length == 0) return 0;
+
+    // Each wheel speed may only jump by a small amount between both segments
+    float jump = fmaxf(fabsf(first.left/first.length - second.left/second.length),
+                       fabsf(first.right/first.length - second.right/second.length));
+    float speed = fminf(current->speed, next->speed);
+    if(jump*speed > MOTION_MAX_SPEED_JUMP) speed = MOTION_MAX_SPEED_JUMP/jump;
+    return speed;
+}
+
+
+void finishSegments(int number){
+    for(int i = 0; i < number; i++){
+        // Back in the pool first, the callback can enqueue a new segment
+        motionCallback_t callback = segments[i]->callback;
+        void * arg = segments[i]->arg;
+        (void)chMBPost(&freeSegments, (msg_t) segments[i], TIME_INFINITE);
+        if(callback != NULL) callback(arg);
+    }
+    for(int i = number; i < numberOfSegments; i++){
+        segments[i - number] = segments[i];
+    }
+    numberOfSegments -= number;
+
+    chSysLock();
+    remainingSegments -= number;
+    chSysUnlock();
+}
+
+
+void discardSegments(void){
+    int discarded = numberOfSegments;
+    for(int i = 0; i < numberOfSegments; i++){
+        (void)chMBPost(&freeSegments, (msg_t) segments[i], TIME_INFINITE);
+    }
+    numberOfSegments = 0;
+
+    msg_t message;
+    while(chMBFetch(&pendingSegments, &message, TIME_IMMEDIATE) == MSG_OK){
+        (void)chMBPost(&freeSegments, message, TIME_INFINITE);
+        discarded++;
+    }
+    profiled = NULL;
+    carried = 0;
+    hasPrevious = false;
+
+    chSysLock();
+    remainingSegments -= discarded;
+    chSysUnlock();
+}
+
+
+void followPoints(void){
+    int number = 0;
+    if(hasPrevious) pursuitPoints[number++] = previousPoint;
+    int first = number;
+    for(int i = 0; i < numberOfSegments && segments[i]->type == MOTION_POINT; i++){
+        pursuitPoints[number++] = segments[i]->point;
+    }
+    profiled = NULL;
+    carried = 0;
+    speed = 0;
+
+    int segment = first;
+    wheelSpeed_t wheelSpeed;
+    bool arrived = mod_pursuit_computeWheelSpeed(mod_localization_getPosition(), pursuitPoints, number,
+                                                 &segment, &wheelSpeed);
+    if(arrived) mod_motors_stop();     // Before the callbacks, the robot is stopped at the end of the points
+    else mod_motors_changeStateWheelSpeedType(wheelSpeed);
+
+    // The points before the one the controller aims at are passed
+    int passed = arrived ? number - first : segment - first;
+    if(passed > 0){
+        previousPoint = pursuitPoints[first + passed - 1];
+        hasPrevious = !arrived;
+        finishSegments(passed);
+    }
+}
+
+
+void followProfile(void){
+    const motionSegment_t * current = segments[0];
+    hasPrevious = false;
+    if(profiled != current){
+        profiled = current;
+        target = computeWheelTarget(current);
+        done = carried;
+        carried = 0;
+        mod_odometry_getWheelDistances(&lastLeft, &lastRight);
+    }
+
+    // Progress is the displacement of the wheels projected on the segment direction
+    int32_t left, right;
+    mod_odometry_getWheelDistances(&left, &right);
+    float deltaLeft = (int32_t)((uint32_t)left - (uint32_t)lastLeft)/(float)(1 << ODOMETRY_FRACTION_BITS);
+    float deltaRight = (int32_t)((uint32_t)right - (uint32_t)lastRight)/(float)(1 << ODOMETRY_FRACTION_BITS);
+    lastLeft = left;
+    lastRight = right;
+    if(target.length > 0){
+        done += (deltaLeft*target.left + deltaRight*target.right)*target.length/
+                (target.left*target.left + target.right*target.right);
+    }
+
+    // Lookahead : the next segment is already in the list when it was enqueued in time
+    const motionSegment_t * next = (numberOfSegments > 1) ? segments[1] : NULL;
+    float remaining = target.length - done;
+    if(remaining <= 0){
+        if(next == NULL) mod_motors_stop(); // Before the callback, the robot is stopped when idle
+        // The overshoot is already done on the next line, arc or rotation
+        carried = (next != NULL && next->type != MOTION_POINT) ? -remaining : 0;
+        profiled = NULL;
+        finishSegments(1);
+        return;
+    }
+
+    // Trapezoidal profile that ends at the junction speed, the pursuit starts from the speed of the wheels
+    float exitSpeed = (next != NULL && next->type != MOTION_POINT) ? computeJunctionSpeed(current, next) : 0;
+    float maxSpeed = sqrtf(exitSpeed*exitSpeed + 2*MOTION_ACCELERATION*remaining);
+    speed = fminf(speed + MOTION_ACCELERATION/MOTION_FREQUENCY, fminf(current->speed, maxSpeed));
+    if(speed < MOTION_MIN_SPEED) speed = MOTION_MIN_SPEED;
+
+    mod_motors_changeStateWheelSpeedType((wheelSpeed_t) {speed*target.left/target.length,
+                                                         speed*target.right/target.length});
+}
+
+
+/**
+ * @brief Thread that drives the wheels along the queued segments
+ *
+ * @note    The next segments are fetched as soon as they are enqueued, so the speed at the end of a segment
+ *          is the junction speed instead of zero, and consecutive points are one path for the pursuit
+ */
+static THD_WORKING_AREA(motionThread_wa, 512);
+static THD_FUNCTION(motionThread, arg){
+    (void) arg;
+
+    systime_t time = chVTGetSystemTime();
+    while(1){
+        time += MS2ST(1000/MOTION_FREQUENCY);
+        chThdSleepUntil(time);
+
+        chMtxLock(&motion_lock);
+        msg_t message;
+        while(numberOfSegments < MOTION_QUEUE_SIZE && chMBFetch(&pendingSegments, &message, TIME_IMMEDIATE) == MSG_OK){
+            segments[numberOfSegments++] = (motionSegment_t *) message;
+        }
+
+        if(numberOfSegments == 0){
+            if(!isStopped){
+                mod_motors_stop();
+                isStopped = true;
+                speed = 0;
+                hasPrevious = false;
+                chBSemSignal(&motionIdle_sem);
+            }
+        }
+        else{
+            isStopped = false;
+            if(segments[0]->type == MOTION_POINT) followPoints();
+            else followProfile();
+        }
+        chMtxUnlock(&motion_lock);
+    }
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_motion_start(void){
+    for(int i = 0; i < MOTION_QUEUE_SIZE; i++){
+        (void)chMBPost(&freeSegments, (msg_t) &segmentsPool[i], TIME_INFINITE);
+    }
+    chThdCreateStatic(motionThread_wa, sizeof(motionThread_wa), NORMALPRIO+9, motionThread, NULL);
+}
+
+
+void mod_motion_enqueue(const motionSegment_t * segment){
+    msg_t message;
+    (void)chMBFetch(&freeSegments, &message, TIME_INFINITE);
+    *((motionSegment_t *) message) = *segment;
+
+    chSysLock();
+    remainingSegments++;
+    chSysUnlock();
+    (void)chMBPost(&pendingSegments, message, TIME_INFINITE);
+}
+
+
+void mod_motion_addLine(float length, motionCallback_t callback, void * arg){
+    mod_motion_enqueue(&((motionSegment_t) {MOTION_LINE, length, 0, MOTION_DEFAULT_SPEED, {0, 0}, callback, arg}));
+}
+
+
+void mod_motion_addArc(float length, float angle, motionCallback_t callback, void * arg){
+    mod_motion_enqueue(&((motionSegment_t) {MOTION_ARC, length, angle, MOTION_DEFAULT_SPEED, {0, 0}, callback, arg}));
+}
+
+
+void mod_motion_addRotation(float angle, motionCallback_t callback, void * arg){
+    mod_motion_enqueue(&((motionSegment_t) {MOTION_ROTATE, 0, angle, MOTION_DEFAULT_ROTATION*ROBOT_RADIUS, {0, 0},
+                                            callback, arg}));
+}
+
+
+void mod_motion_addPoint(point_t point, motionCallback_t callback, void * arg){
+    mod_motion_enqueue(&((motionSegment_t) {MOTION_POINT, 0, 0, 0, point, callback, arg}));
+}
+
+
+void mod_motion_followPath(const point_t * path, int numberOfPoints, motionCallback_t callback, void * arg){
+    if(numberOfPoints > MOTION_QUEUE_SIZE) numberOfPoints = MOTION_QUEUE_SIZE;
+
+    // The thread does not tick in between, the motors keep their speed until the new points are followed
+    chMtxLock(&motion_lock);
+    discardSegments();
+    for(int i = 0; i < numberOfPoints; i++){
+        mod_motion_addPoint(path[i], (i == numberOfPoints-1) ? callback : NULL, arg);
+    }
+    chMtxUnlock(&motion_lock);
+}
+
+
+void mod_motion_stop(void){
+    chMtxLock(&motion_lock);
+    discardSegments();
+    mod_motors_stop();
+    isStopped = true;
+    speed = 0;
+    chBSemSignal(&motionIdle_sem);
+    chMtxUnlock(&motion_lock);
+}
+
+
+bool mod_motion_isIdle(void){
+    return remainingSegments == 0;
+}
+
+
+void mod_motion_waitIdle(void){
+    while(remainingSegments > 0){
+        chBSemWait(&motionIdle_sem);
+    }
+}
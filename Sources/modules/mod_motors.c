@@ -13,15 +13,64 @@
 #include "motors.h"
 #include "mod_mapping.h"
 #include <arm_math.h>
+#include <ch.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include "mod_communication.h"
 
+#define MOTORS_ACCELERATION     2000    // Limit of the profile in the motors driver (in step/s²)
+#define MOTORS_JERK             20000   // (in step/s³)
+#define MOTOR_STEPS_PER_TURN    2000    // Half steps for one turn of a wheel
+#define WHEEL_PERIMETER         130     // (in mm)
+#define MOVE_TIMEOUT_MARGIN     500     // Added to the expected duration of an exact move (in ms)
+
 static int angle_const = 1;
-static float straight_const = 15.3;
+static float straight_const = (float) MOTOR_STEPS_PER_TURN / WHEEL_PERIMETER;
+
+// Last speed asked by the modules and correction of the safety layer
+static wheelSpeed_t commandedSpeed = {0, 0};
+static float safetySpeedFactor = 1;
+static float safetyRotation = 0;
+
+MUTEX_DECL(motors_lock);
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Apply the commanded speed to the motors with the safety correction, called with the lock
+ */
+void applyCommandedSpeed(void);
+
+/***************/
+
+
+void applyCommandedSpeed(void){
+    float forward = (commandedSpeed.left + commandedSpeed.right)/2;
+    float left = commandedSpeed.left;
+    float right = commandedSpeed.right;
+
+    // Only the forward motion is corrected, rotations in place and backward moves are free
+    if(forward > 0){
+        float correction = forward*(safetySpeedFactor - 1);
+        left += correction - safetyRotation*forward*ROBOT_RADIUS;
+        right += correction + safetyRotation*forward*ROBOT_RADIUS;
+    }
+    left_motor_set_speed((int) (left*straight_const));
+    right_motor_set_speed((int) (right*straight_const));
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
 
 void mod_motors_init(void){
     motors_init();
+    motors_set_profile(MOTORS_ACCELERATION, MOTORS_JERK);
 }
 
 wheelSpeed_t mod_motors_convertRobotSpeedToWheelspeed(robotSpeed_t robotSpeedTemp){
@@ -63,9 +112,15 @@ void mod_motor_distanceCalibration(int distanceWithWall, const wheelSpeed_t disp
 
     
 
+float mod_motors_getStepsPerMm(void){
+    return straight_const;
+}
+
 void mod_motors_changeStateWheelSpeedType(wheelSpeed_t wheelSpeed){
-    left_motor_set_speed((int) (wheelSpeed.left*straight_const));
-    right_motor_set_speed((int) (wheelSpeed.right*straight_const));
+    chMtxLock(&motors_lock);
+    commandedSpeed = wheelSpeed;
+    applyCommandedSpeed();
+    chMtxUnlock(&motors_lock);
 }
 
 void mod_motors_changeStateRobotSpeedType(robotSpeed_t robotSpeed){
@@ -73,6 +128,54 @@ void mod_motors_changeStateRobotSpeedType(robotSpeed_t robotSpeed){
 }
 
 
+int32_t mod_motors_convertDistanceToSteps(float distance){
+    return lroundf(distance*straight_const);
+}
+
+bool mod_motors_moveAndWait(float distance, float angle, float speed){
+    int32_t left = mod_motors_convertDistanceToSteps(distance - angle*ROBOT_RADIUS);
+    int32_t right = mod_motors_convertDistanceToSteps(distance + angle*ROBOT_RADIUS);
+    int stepSpeed = (int) (fabsf(speed)*straight_const);
+    if(stepSpeed < 1) stepSpeed = 1;
+
+    // Cruise at the speed of the longest wheel, plus the acceleration and the braking of the profile
+    int32_t longest = (labs(left) > labs(right)) ? labs(left) : labs(right);
+    systime_t timeout = MS2ST(1000*longest/stepSpeed + 2000*stepSpeed/MOTORS_ACCELERATION + MOVE_TIMEOUT_MARGIN);
+
+    event_listener_t listener;
+    chEvtRegisterMask(&motors_event, &listener, EVENT_MASK(0));
+    (void)chEvtGetAndClearFlags(&listener);
+
+    chMtxLock(&motors_lock);
+    commandedSpeed = (wheelSpeed_t) {0, 0};
+    motors_move_steps(left, right, stepSpeed);
+    chMtxUnlock(&motors_lock);
+
+    systime_t start = chVTGetSystemTime();
+    eventflags_t flags = 0;
+    while(!(flags & (MOTORS_EVENT_MOVE_DONE | MOTORS_EVENT_MOVE_CANCELLED))){
+        systime_t elapsed = chVTTimeElapsedSinceX(start);
+        if(elapsed >= timeout) break;
+        (void)chEvtWaitAnyTimeout(EVENT_MASK(0), timeout - elapsed);
+        flags |= chEvtGetAndClearFlags(&listener);
+    }
+    chEvtUnregister(&motors_event, &listener);
+
+    if(flags & MOTORS_EVENT_MOVE_DONE) return true;
+    // Stuck wheels, the move must not go on after the return
+    if(!(flags & MOTORS_EVENT_MOVE_CANCELLED)) mod_motors_stop();
+    return false;
+}
+
+void mod_motors_setSafetyCorrection(float speedFactor, float rotation){
+    chMtxLock(&motors_lock);
+    safetySpeedFactor = speedFactor;
+    safetyRotation = rotation;
+    // An exact move is not interrupted, it would never signal its end
+    if(!motors_is_moving()) applyCommandedSpeed();
+    chMtxUnlock(&motors_lock);
+}
+
 void mod_motors_stop(void){
     mod_motors_changeStateWheelSpeedType((wheelSpeed_t){0,0});
 }
@@ -0,0 +1,239 @@
+/*
+ * File : mod_objects.c
+ * Project : e_puck_project
+ * Description : Module that stores detected objects in a spatial hash index
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_objects.h"
+
+// Standard headers
+#include <stdint.h>
+#include <stddef.h>
+
+// Our headers
+#include "mod_check.h"
+
+#define HASH_PRIME_X        73856093
+#define HASH_PRIME_Y        19349663
+
+
+typedef struct {
+    object_t object;
+    int bucketX;            // Bucket coordinates of the object location
+    int bucketY;
+    int16_t next;           // Next object in the same bucket
+} objectSlot_t;
+
+// Fixed size pool, objects are never removed so ids stay valid
+static objectSlot_t pool[OBJECTS_MAX_NUMBER];
+static int poolSize = 0;
+
+// First object of each bucket
+static int16_t buckets[OBJECTS_BUCKETS_NUMBER];
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Convert a coordinate to a bucket coordinate (floor division)
+ *
+ * @param[in] coordinate    The coordinate in mm
+ *
+ * @param[out] The bucket coordinate
+ */
+int toBucketCoordinate(int coordinate);
+
+/**
+ * @brief Returns the index in the hash table of bucket coordinates
+ *
+ * @param[in] bucketX       The x bucket coordinate
+ * @param[in] bucketY       The y bucket coordinate
+ *
+ * @param[out] The index in the table
+ */
+int hashBucket(int bucketX, int bucketY);
+
+/**
+ * @brief Add a slot at the head of the bucket that contains its location
+ *
+ * @param[in] id            The id of the slot
+ */
+void linkSlot(int id);
+
+/**
+ * @brief Remove a slot from its bucket
+ *
+ * @param[in] id            The id of the slot
+ */
+void unlinkSlot(int id);
+
+/**
+ * @brief Go through all objects in a circle
+ *
+ * @param[in] center        The center of the circle
+ * @param[in] radius        The radius of the circle (in mm)
+ * @param[in] ids           A table where to store ids of found objects (can be NULL)
+ * @param[in] maxIds        The size of the table
+ * @param[in] nearest       Where to store the id of the closest object (can be NULL)
+ *
+ * @param[out] The number of found objects
+ */
+int scanRadius(point_t center, int radius, int * ids, int maxIds, int * nearest);
+
+/**
+ * @brief Returns the squared distance between two points
+ *
+ * @param[in] point1        The first point
+ * @param[in] point2        The second point
+ *
+ * @param[out] The squared distance
+ */
+int squaredDistance(point_t point1, point_t point2);
+
+/***************/
+
+
+int toBucketCoordinate(int coordinate){
+    if(coordinate >= 0) return coordinate/OBJECTS_BUCKET_SIZE;
+    return -((-coordinate + OBJECTS_BUCKET_SIZE - 1)/OBJECTS_BUCKET_SIZE);
+}
+
+
+int hashBucket(int bucketX, int bucketY){
+    return (int)(((uint32_t)bucketX*HASH_PRIME_X ^ (uint32_t)bucketY*HASH_PRIME_Y) & (OBJECTS_BUCKETS_NUMBER-1));
+}
+
+
+void linkSlot(int id){
+    pool[id].bucketX = toBucketCoordinate(pool[id].object.location.x);
+    pool[id].bucketY = toBucketCoordinate(pool[id].object.location.y);
+    int bucket = hashBucket(pool[id].bucketX, pool[id].bucketY);
+    pool[id].next = buckets[bucket];
+    buckets[bucket] = id;
+}
+
+
+void unlinkSlot(int id){
+    int16_t * link = &buckets[hashBucket(pool[id].bucketX, pool[id].bucketY)];
+    while(*link != OBJECT_NONE){
+        if(*link == id){
+            *link = pool[id].next;
+            return;
+        }
+        link = &pool[*link].next;
+    }
+}
+
+
+int scanRadius(point_t center, int radius, int * ids, int maxIds, int * nearest){
+    int number = 0;
+    int nearestDistance = radius*radius;
+    if(nearest != NULL) *nearest = OBJECT_NONE;
+
+    int minX = toBucketCoordinate(center.x - radius);
+    int maxX = toBucketCoordinate(center.x + radius);
+    int minY = toBucketCoordinate(center.y - radius);
+    int maxY = toBucketCoordinate(center.y + radius);
+
+    for(int bucketX = minX; bucketX <= maxX; bucketX++){
+        for(int bucketY = minY; bucketY <= maxY; bucketY++){
+            int id = buckets[hashBucket(bucketX, bucketY)];
+            while(id != OBJECT_NONE){
+                // Several buckets can share the same hash, only keep objects of this one
+                int distance = squaredDistance(center, pool[id].object.location);
+                if(pool[id].bucketX == bucketX && pool[id].bucketY == bucketY && distance < radius*radius){
+                    if(nearest != NULL && distance < nearestDistance){
+                        *nearest = id;
+                        nearestDistance = distance;
+                    }
+                    if(ids != NULL && number < maxIds) ids[number] = id;
+                    number++;
+                }
+                id = pool[id].next;
+            }
+        }
+    }
+    return (ids != NULL && number > maxIds) ? maxIds : number;
+}
+
+
+int squaredDistance(point_t point1, point_t point2){
+    return (point1.x-point2.x)*(point1.x-point2.x) + (point1.y-point2.y)*(point1.y-point2.y);
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_objects_init(void){
+    mod_objects_reset();
+}
+
+
+void mod_objects_reset(void){
+    poolSize = 0;
+    for(int i = 0; i < OBJECTS_BUCKETS_NUMBER; i++) buckets[i] = OBJECT_NONE;
+}
+
+
+int mod_objects_insert(point_t location){
+    if(poolSize >= OBJECTS_MAX_NUMBER) return OBJECT_NONE;
+
+    int id = poolSize;
+    pool[id].object = (object_t) {location, 1};
+    linkSlot(id);
+    poolSize++;
+    return id;
+}
+
+
+int mod_objects_findNearest(point_t center, int radius){
+    int nearest;
+    scanRadius(center, radius, NULL, 0, &nearest);
+    return nearest;
+}
+
+
+int mod_objects_queryRadius(point_t center, int radius, int * ids, int maxIds){
+    return scanRadius(center, radius, ids, maxIds, NULL);
+}
+
+
+int mod_objects_merge(point_t location, int radius, bool * isNew){
+    int id = mod_objects_findNearest(location, radius);
+
+    if(id == OBJECT_NONE){
+        *isNew = true;
+        return mod_objects_insert(location);
+    }
+
+    // Running mean of the detections, the object may move to another bucket
+    *isNew = false;
+    object_t * object = &pool[id].object;
+    object->location.x = (object->location.x*object->detections + location.x)/(object->detections+1);
+    object->location.y = (object->location.y*object->detections + location.y)/(object->detections+1);
+    object->detections++;
+
+    if(toBucketCoordinate(object->location.x) != pool[id].bucketX ||
+       toBucketCoordinate(object->location.y) != pool[id].bucketY){
+        unlinkSlot(id);
+        linkSlot(id);
+    }
+    return id;
+}
+
+
+int mod_objects_getNumber(void){
+    return poolSize;
+}
+
+
+object_t mod_objects_get(int id){
+    assert(id >= 0 && id < poolSize);
+    return pool[id].object;
+}
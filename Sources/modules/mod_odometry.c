@@ -0,0 +1,198 @@
+/*
+ * File : mod_odometry.c
+ * Project : e_puck_project
+ * Description : Module that integrates wheel displacements in fixed point (Q16.16 position, Q31 heading)
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_odometry.h"
+
+// Epuck/ChibiOS headers
+#include "motors.h"
+#include "msgbus/messagebus.h"
+#include <main.h>
+
+// Our headers
+#include "mod_motors.h"
+
+#define Q31_HALF_TURN           2147483648.0f   // PI in Q31 angle
+#define FULL_TURN               4294967296.0f   // 2PI in Q31 angle (wraps)
+
+// Heading change (Q31) for 1 mm (Q16.16) of difference between wheels, divided by 2^16
+#define HEADING_GAIN            ((int64_t)(Q31_HALF_TURN/(PI*2*ROBOT_RADIUS) + 0.5f))
+
+// The right motor counter decreases when the wheel goes forward (see motors.c)
+#define LEFT_MOTOR_DIRECTION    1
+#define RIGHT_MOTOR_DIRECTION   -1
+
+
+static odometryPose_t currentPose;
+static int32_t leftWheelDistance = 0;      // Total distances since the start (in mm, Q16.16, wraps)
+static int32_t rightWheelDistance = 0;
+
+MUTEX_DECL(pose_lock);
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Add two Q31 angles, the result wraps around PI
+ *
+ * @param[in] angle1    The first angle
+ * @param[in] angle2    The second angle
+ *
+ * @param[out] The sum
+ */
+q31_t addAngleQ31(q31_t angle1, q31_t angle2);
+
+/**
+ * @brief Convert motors steps to a distance
+ *
+ * @param[in] steps     The number of steps
+ *
+ * @param[out] The distance (in mm, Q16.16)
+ */
+int32_t stepsToDistance(int32_t steps);
+
+/***************/
+
+
+int32_t stepsToDistance(int32_t steps){
+    return ODOMETRY_MM_TO_FIXED(steps/mod_motors_getStepsPerMm());
+}
+
+
+/**
+ * @brief Thread that reads motors steps at a fixed rate, integrates them and publishes the pose
+ */
+static THD_WORKING_AREA(odometryThread_wa, 512);
+static THD_FUNCTION(odometryThread, arg){
+    (void) arg;
+    
+    odometry_msg_t message;
+    messagebus_topic_t odometry_topic;
+    MUTEX_DECL(odometry_topic_lock);
+    CONDVAR_DECL(odometry_topic_condvar);
+    messagebus_topic_init(&odometry_topic, &odometry_topic_lock, &odometry_topic_condvar, &message, sizeof(message));
+    messagebus_advertise_topic(&bus, &odometry_topic, "/odometry");
+    
+    int32_t lastLeft = (int32_t) left_motor_get_pos();
+    int32_t lastRight = (int32_t) right_motor_get_pos();
+    systime_t time = chVTGetSystemTime();
+    
+    while(1){
+        time += MS2ST(1000/ODOMETRY_FREQUENCY);
+        chThdSleepUntil(time);
+        
+        int32_t left = (int32_t) left_motor_get_pos();
+        int32_t right = (int32_t) right_motor_get_pos();
+        
+        int32_t leftDistance = stepsToDistance(LEFT_MOTOR_DIRECTION*(left - lastLeft));
+        int32_t rightDistance = stepsToDistance(RIGHT_MOTOR_DIRECTION*(right - lastRight));
+        
+        chMtxLock(&pose_lock);
+        mod_odometry_integrate(&currentPose, leftDistance, rightDistance);
+        leftWheelDistance = (int32_t)((uint32_t)leftWheelDistance + (uint32_t)leftDistance);
+        rightWheelDistance = (int32_t)((uint32_t)rightWheelDistance + (uint32_t)rightDistance);
+        message.pose = currentPose;
+        chMtxUnlock(&pose_lock);
+        
+        lastLeft = left;
+        lastRight = right;
+        
+        message.position = mod_odometry_toRobotPosition(&message.pose);
+        message.timestamp = time;
+        messagebus_topic_publish(&odometry_topic, &message, sizeof(message));
+    }
+}
+
+
+q31_t addAngleQ31(q31_t angle1, q31_t angle2){
+    return (q31_t)((uint32_t)angle1 + (uint32_t)angle2);
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_odometry_start(void){
+    chThdCreateStatic(odometryThread_wa, sizeof(odometryThread_wa), NORMALPRIO+9, odometryThread, NULL);
+}
+
+
+void mod_odometry_setPosition(robotPosition_t position){
+    chMtxLock(&pose_lock);
+    currentPose = mod_odometry_fromRobotPosition(position);
+    chMtxUnlock(&pose_lock);
+}
+
+
+odometryPose_t mod_odometry_getPose(void){
+    chMtxLock(&pose_lock);
+    odometryPose_t pose = currentPose;
+    chMtxUnlock(&pose_lock);
+    return pose;
+}
+
+
+robotPosition_t mod_odometry_getPosition(void){
+    odometryPose_t pose = mod_odometry_getPose();
+    return mod_odometry_toRobotPosition(&pose);
+}
+
+
+void mod_odometry_getWheelDistances(int32_t * left, int32_t * right){
+    chMtxLock(&pose_lock);
+    *left = leftWheelDistance;
+    *right = rightWheelDistance;
+    chMtxUnlock(&pose_lock);
+}
+
+
+odometryPose_t mod_odometry_fromRobotPosition(robotPosition_t position){
+    odometryPose_t pose;
+    pose.x = ODOMETRY_MM_TO_FIXED(position.x);
+    pose.y = ODOMETRY_MM_TO_FIXED(position.y);
+
+    // Fraction of turn in -0.5 -> 0.5 to stay in the Q31 range
+    float turns = position.theta/(2*PI);
+    turns -= floorf(turns + 0.5f);
+    pose.theta = (q31_t)(int64_t)(turns*FULL_TURN);
+    return pose;
+}
+
+
+robotPosition_t mod_odometry_toRobotPosition(const odometryPose_t * pose){
+    robotPosition_t position;
+    position.x = (pose->x + (1 << (ODOMETRY_FRACTION_BITS-1))) >> ODOMETRY_FRACTION_BITS;
+    position.y = (pose->y + (1 << (ODOMETRY_FRACTION_BITS-1))) >> ODOMETRY_FRACTION_BITS;
+    position.theta = pose->theta*(PI/Q31_HALF_TURN);
+    if(position.theta < 0) position.theta += 2*PI;
+    return position;
+}
+
+
+void mod_odometry_integrate(odometryPose_t * pose, int32_t leftDistance, int32_t rightDistance){
+    int32_t distance = (int32_t)(((int64_t)leftDistance + rightDistance)/2);
+    q31_t deltaTheta = (q31_t)((((int64_t)rightDistance - leftDistance)*HEADING_GAIN + (1 << (ODOMETRY_FRACTION_BITS-1)))
+                               >> ODOMETRY_FRACTION_BITS);
+
+    // Midpoint : the direction is taken at half of the rotation
+    q31_t sinus, cosinus;
+    arm_sin_cos_q31(addAngleQ31(pose->theta, deltaTheta/2), &sinus, &cosinus);
+
+    // Theta = 0 is the y axis, so x moves with -sin and y with cos
+    pose->x -= (int32_t)(((int64_t)distance*sinus) >> 31);
+    pose->y += (int32_t)(((int64_t)distance*cosinus) >> 31);
+    pose->theta = addAngleQ31(pose->theta, deltaTheta);
+}
+
+
+void mod_odometry_integrateWheelSpeed(odometryPose_t * pose, const wheelSpeed_t * wheelSpeed, int time){
+    mod_odometry_integrate(pose, ODOMETRY_MM_TO_FIXED(wheelSpeed->left*time/(float)MS_TO_S),
+                                 ODOMETRY_MM_TO_FIXED(wheelSpeed->right*time/(float)MS_TO_S));
+}
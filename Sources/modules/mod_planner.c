@@ -0,0 +1,570 @@
+/*
+ * File : mod_planner.c
+ * Project : e_puck_project
+ * Description : Module that plans paths on the occupancy grid, A* for a first path and D* Lite to search again
+ *               only around the changes
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_planner.h"
+
+// Standard headers
+#include <stdint.h>
+#include <string.h>
+
+// Our headers
+#include "mod_grid.h"
+
+#define PLANNER_MAX_CELLS           (PLANNER_MAX_COLUMNS*PLANNER_MAX_ROWS)
+#define COST_STRAIGHT               10
+#define COST_DIAGONAL               14
+#define COST_INFINITE               0xFFFF
+#define PLANNER_MAX_PATH_CELLS      512     // Longest path that can be returned (in cells)
+#define UPDATE_SIZE                 (GRID_BLOCK_CELLS + 2*PLANNER_ROBOT_CELLS)  // Cells that a changed block can block
+
+/**
+ * @brief Element of the open list, keys are compared in lexicographic order
+ */
+typedef struct {
+    uint32_t key1;
+    uint16_t key2;
+    uint16_t cell;
+} heapEntry_t;
+
+static const int neighbourColumn[8] = {1, -1, 0, 0, 1, 1, -1, -1};
+static const int neighbourRow[8] = {0, 0, 1, -1, 1, -1, 1, -1};
+
+// Everything is static, planning never allocates
+static uint16_t g[PLANNER_MAX_CELLS];
+static uint16_t rhs[PLANNER_MAX_CELLS];
+static uint8_t blocked[(PLANNER_MAX_CELLS + 7)/8];
+static bool updateBlocked[UPDATE_SIZE][UPDATE_SIZE];
+static heapEntry_t heap[PLANNER_HEAP_SIZE];
+static int heapSize = 0;
+static bool isHeapFull = false;
+static uint16_t pathCells[PLANNER_MAX_PATH_CELLS];
+
+// Planning window in the grid
+static int originColumn = 0, originRow = 0;
+static int columns = PLANNER_MAX_COLUMNS, rows = PLANNER_MAX_ROWS;
+
+// D* Lite state
+static int startCell = 0, lastStartCell = 0, goalCell = 0;
+static point_t goalPoint;
+static uint32_t km = 0;
+static bool isReplanningValid = false;
+static uint32_t lastStamp = 0;      // Stamp of the grid when the blocked cells were last checked
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Convert a point to a cell of the window
+ *
+ * @param[in] point     The point
+ * @param[in] cell      Where to store the cell
+ *
+ * @param[out] False if the point is outside of the window
+ */
+bool pointToPlannerCell(point_t point, int * cell);
+
+/**
+ * @brief Returns the neighbour of a cell in a direction
+ *
+ * @param[in] cell          The cell
+ * @param[in] direction     The direction (0 to 7, the 4 first ones are straight)
+ *
+ * @param[out] The neighbour, -1 outside of the window
+ */
+int getNeighbour(int cell, int direction);
+
+/**
+ * @brief Check if the center of the robot can not be in a cell, the goal is never blocked
+ *
+ * @param[in] cell      The cell
+ *
+ * @param[out] True if blocked
+ */
+bool isBlocked(int cell);
+
+/**
+ * @brief Returns the cost to move from a cell to its neighbour, diagonals can not cut a blocked corner
+ *
+ * @param[in] cell          The cell
+ * @param[in] direction     The direction of the neighbour
+ *
+ * @param[out] The cost, COST_INFINITE if not possible
+ */
+uint16_t getCost(int cell, int direction);
+
+/**
+ * @brief Octile distance between two cells, it never overestimates the cost
+ *
+ * @param[in] first, second     The cells
+ *
+ * @param[out] The distance
+ */
+uint16_t computeHeuristic(int first, int second);
+
+/**
+ * @brief Add two costs, the result saturates at COST_INFINITE
+ *
+ * @param[in] first, second     The costs
+ *
+ * @param[out] The sum
+ */
+uint16_t addCosts(uint16_t first, uint16_t second);
+
+/**
+ * @brief Mark the cells too close to an occupied cell of the grid
+ *
+ * @param[in] bitmap    Where to store the blocked cells, one bit per cell
+ */
+void computeBlockedCells(uint8_t * bitmap);
+
+/**
+ * @brief Check again the blocked cells around a region of the grid and give the changes to D* Lite
+ *
+ * @param[in] region    The region that changed, in cells of the grid
+ *
+ * @param[out]      True if a cell changed
+ */
+bool updateBlockedCells(const gridRegion_t * region);
+
+/**
+ * @brief Binary heap operations
+ */
+void heapPush(uint32_t key1, uint16_t key2, int cell);
+heapEntry_t heapPop(void);
+bool isKeyLess(uint32_t firstKey1, uint16_t firstKey2, uint32_t secondKey1, uint16_t secondKey2);
+
+/**
+ * @brief D* Lite : key of a cell, recompute rhs and insert a cell in the open list, expand until the start is consistent
+ */
+void calculateKey(int cell, uint32_t * key1, uint16_t * key2);
+void updateVertex(int cell);
+bool computeShortestPath(void);
+
+/**
+ * @brief Convert a list of cells to points, only the cells where the direction changes are kept
+ *
+ * @param[in] cells         The cells of the path, without the start
+ * @param[in] number        The number of cells
+ * @param[in] goal          The exact end of the path
+ * @param[in] path          Where to store the points
+ * @param[in] maxPoints     The size of path
+ *
+ * @param[out] The number of points
+ */
+int simplifyPath(const uint16_t * cells, int number, point_t goal, point_t * path, int maxPoints);
+
+/***************/
+
+
+bool pointToPlannerCell(point_t point, int * cell){
+    int column, row;
+    mod_grid_pointToCell(point, &column, &row);
+    column -= originColumn;
+    row -= originRow;
+    if(column < 0 || column >= columns || row < 0 || row >= rows) return false;
+    *cell = row*columns + column;
+    return true;
+}
+
+
+int getNeighbour(int cell, int direction){
+    int column = cell % columns + neighbourColumn[direction];
+    int row = cell / columns + neighbourRow[direction];
+    if(column < 0 || column >= columns || row < 0 || row >= rows) return -1;
+    return row*columns + column;
+}
+
+
+bool isBlocked(int cell){
+    return cell != goalCell && (blocked[cell >> 3] & (1 << (cell & 7)));
+}
+
+
+uint16_t getCost(int cell, int direction){
+    int neighbour = getNeighbour(cell, direction);
+    if(neighbour < 0 || isBlocked(neighbour)) return COST_INFINITE;
+    if(direction < 4) return COST_STRAIGHT;
+
+    // Both cells next to the diagonal must be free
+    int column = cell % columns;
+    int row = cell / columns;
+    if(isBlocked(row*columns + column + neighbourColumn[direction]) ||
+       isBlocked((row + neighbourRow[direction])*columns + column)) return COST_INFINITE;
+    return COST_DIAGONAL;
+}
+
+
+uint16_t computeHeuristic(int first, int second){
+    int deltaColumn = first % columns - second % columns;
+    int deltaRow = first / columns - second / columns;
+    if(deltaColumn < 0) deltaColumn = -deltaColumn;
+    if(deltaRow < 0) deltaRow = -deltaRow;
+    int longest = (deltaColumn > deltaRow) ? deltaColumn : deltaRow;
+    int shortest = (deltaColumn > deltaRow) ? deltaRow : deltaColumn;
+    return COST_STRAIGHT*longest + (COST_DIAGONAL - COST_STRAIGHT)*shortest;
+}
+
+
+uint16_t addCosts(uint16_t first, uint16_t second){
+    uint32_t sum = (uint32_t) first + second;
+    return (sum >= COST_INFINITE) ? COST_INFINITE : (uint16_t) sum;
+}
+
+
+void computeBlockedCells(uint8_t * bitmap){
+    memset(bitmap, 0, (columns*rows + 7)/8);
+
+    // Obstacles just outside of the window also block its border
+    for(int row = -PLANNER_ROBOT_CELLS; row < rows + PLANNER_ROBOT_CELLS; row++){
+        for(int column = -PLANNER_ROBOT_CELLS; column < columns + PLANNER_ROBOT_CELLS; column++){
+            if(mod_grid_getCellState(originColumn + column, originRow + row) != CELL_OCCUPIED) continue;
+
+            for(int deltaRow = -PLANNER_ROBOT_CELLS; deltaRow <= PLANNER_ROBOT_CELLS; deltaRow++){
+                for(int deltaColumn = -PLANNER_ROBOT_CELLS; deltaColumn <= PLANNER_ROBOT_CELLS; deltaColumn++){
+                    if(deltaColumn*deltaColumn + deltaRow*deltaRow > PLANNER_ROBOT_CELLS*PLANNER_ROBOT_CELLS) continue;
+                    int blockedColumn = column + deltaColumn;
+                    int blockedRow = row + deltaRow;
+                    if(blockedColumn < 0 || blockedColumn >= columns || blockedRow < 0 || blockedRow >= rows) continue;
+                    int cell = blockedRow*columns + blockedColumn;
+                    bitmap[cell >> 3] |= 1 << (cell & 7);
+                }
+            }
+        }
+    }
+}
+
+
+bool isKeyLess(uint32_t firstKey1, uint16_t firstKey2, uint32_t secondKey1, uint16_t secondKey2){
+    return firstKey1 < secondKey1 || (firstKey1 == secondKey1 && firstKey2 < secondKey2);
+}
+
+
+void heapPush(uint32_t key1, uint16_t key2, int cell){
+    if(heapSize >= PLANNER_HEAP_SIZE){
+        isHeapFull = true;
+        return;
+    }
+
+    int index = heapSize++;
+    while(index > 0){
+        int parent = (index - 1)/2;
+        if(!isKeyLess(key1, key2, heap[parent].key1, heap[parent].key2)) break;
+        heap[index] = heap[parent];
+        index = parent;
+    }
+    heap[index] = (heapEntry_t) {key1, key2, (uint16_t) cell};
+}
+
+
+heapEntry_t heapPop(void){
+    heapEntry_t top = heap[0];
+    heapEntry_t last = heap[--heapSize];
+
+    int index = 0;
+    while(1){
+        int child = 2*index + 1;
+        if(child >= heapSize) break;
+        if(child + 1 < heapSize && isKeyLess(heap[child + 1].key1, heap[child + 1].key2, heap[child].key1, heap[child].key2)){
+            child++;
+        }
+        if(!isKeyLess(heap[child].key1, heap[child].key2, last.key1, last.key2)) break;
+        heap[index] = heap[child];
+        index = child;
+    }
+    if(heapSize > 0) heap[index] = last;
+    return top;
+}
+
+
+void calculateKey(int cell, uint32_t * key1, uint16_t * key2){
+    uint16_t best = (g[cell] < rhs[cell]) ? g[cell] : rhs[cell];
+    *key1 = (best == COST_INFINITE) ? UINT32_MAX : best + computeHeuristic(startCell, cell) + km;
+    *key2 = best;
+}
+
+
+void updateVertex(int cell){
+    if(cell != goalCell){
+        // The search goes backward, rhs is the best cost through a successor
+        uint16_t best = COST_INFINITE;
+        for(int direction = 0; direction < 8; direction++){
+            uint16_t cost = getCost(cell, direction);
+            if(cost == COST_INFINITE) continue;
+            uint16_t total = addCosts(cost, g[getNeighbour(cell, direction)]);
+            if(total < best) best = total;
+        }
+        rhs[cell] = best;
+    }
+
+    // Entries of consistent cells stay in the heap, they are skipped when popped
+    if(g[cell] != rhs[cell]){
+        uint32_t key1;
+        uint16_t key2;
+        calculateKey(cell, &key1, &key2);
+        heapPush(key1, key2, cell);
+    }
+}
+
+
+bool updateBlockedCells(const gridRegion_t * region){
+    // Only the cells of the window closer than the robot size to the region can change
+    int firstColumn = region->minColumn - originColumn - PLANNER_ROBOT_CELLS;
+    int lastColumn = region->maxColumn - originColumn + PLANNER_ROBOT_CELLS;
+    int firstRow = region->minRow - originRow - PLANNER_ROBOT_CELLS;
+    int lastRow = region->maxRow - originRow + PLANNER_ROBOT_CELLS;
+    if(firstColumn < 0) firstColumn = 0;
+    if(firstRow < 0) firstRow = 0;
+    if(lastColumn >= columns) lastColumn = columns - 1;
+    if(lastRow >= rows) lastRow = rows - 1;
+    if(firstColumn > lastColumn || firstRow > lastRow) return false;
+
+    // Obstacles up to the robot size further are inflated again, as in computeBlockedCells
+    memset(updateBlocked, 0, sizeof(updateBlocked));
+    for(int row = firstRow - PLANNER_ROBOT_CELLS; row <= lastRow + PLANNER_ROBOT_CELLS; row++){
+        for(int column = firstColumn - PLANNER_ROBOT_CELLS; column <= lastColumn + PLANNER_ROBOT_CELLS; column++){
+            if(mod_grid_getCellState(originColumn + column, originRow + row) != CELL_OCCUPIED) continue;
+
+            for(int deltaRow = -PLANNER_ROBOT_CELLS; deltaRow <= PLANNER_ROBOT_CELLS; deltaRow++){
+                for(int deltaColumn = -PLANNER_ROBOT_CELLS; deltaColumn <= PLANNER_ROBOT_CELLS; deltaColumn++){
+                    if(deltaColumn*deltaColumn + deltaRow*deltaRow > PLANNER_ROBOT_CELLS*PLANNER_ROBOT_CELLS) continue;
+                    int blockedColumn = column + deltaColumn;
+                    int blockedRow = row + deltaRow;
+                    if(blockedColumn < firstColumn || blockedColumn > lastColumn || blockedRow < firstRow || blockedRow > lastRow) continue;
+                    updateBlocked[blockedRow - firstRow][blockedColumn - firstColumn] = true;
+                }
+            }
+        }
+    }
+
+    bool isChanged = false;
+    for(int row = firstRow; row <= lastRow; row++){
+        for(int column = firstColumn; column <= lastColumn; column++){
+            int cell = row*columns + column;
+            uint8_t mask = 1 << (cell & 7);
+            if(updateBlocked[row - firstRow][column - firstColumn] == ((blocked[cell >> 3] & mask) != 0)) continue;
+
+            // Only the moves into the cell and the diagonals along it change
+            blocked[cell >> 3] ^= mask;
+            isChanged = true;
+            for(int direction = 0; direction < 8; direction++){
+                int neighbour = getNeighbour(cell, direction);
+                if(neighbour >= 0) updateVertex(neighbour);
+            }
+        }
+    }
+    return isChanged;
+}
+
+
+bool computeShortestPath(void){
+    uint32_t startKey1;
+    uint16_t startKey2;
+    calculateKey(startCell, &startKey1, &startKey2);
+
+    while(heapSize > 0 && !isHeapFull &&
+          (isKeyLess(heap[0].key1, heap[0].key2, startKey1, startKey2) || rhs[startCell] != g[startCell])){
+        heapEntry_t entry = heapPop();
+        int cell = entry.cell;
+        if(g[cell] == rhs[cell]) continue;
+
+        uint32_t key1;
+        uint16_t key2;
+        calculateKey(cell, &key1, &key2);
+        if(entry.key1 != key1 || entry.key2 != key2){
+            // Key changed since the insertion (robot moved, cell updated)
+            heapPush(key1, key2, cell);
+            continue;
+        }
+
+        if(g[cell] > rhs[cell]){
+            g[cell] = rhs[cell];
+        }
+        else{
+            g[cell] = COST_INFINITE;
+            updateVertex(cell);
+        }
+        for(int direction = 0; direction < 8; direction++){
+            int neighbour = getNeighbour(cell, direction);
+            if(neighbour >= 0) updateVertex(neighbour);
+        }
+        calculateKey(startCell, &startKey1, &startKey2);
+    }
+    return !isHeapFull;
+}
+
+
+int simplifyPath(const uint16_t * cells, int number, point_t goal, point_t * path, int maxPoints){
+    int numberOfPoints = 0;
+    for(int i = 0; i < number - 1 && numberOfPoints < maxPoints - 1; i++){
+        int previous = (i == 0) ? -1 : cells[i-1];
+        int directionIn = (previous < 0) ? 0 : cells[i] - previous;
+        int directionOut = cells[i+1] - cells[i];
+        if(previous >= 0 && directionIn == directionOut) continue;
+        path[numberOfPoints++] = mod_grid_cellToPoint(originColumn + cells[i] % columns, originRow + cells[i] / columns);
+    }
+    path[numberOfPoints++] = goal;
+    return numberOfPoints;
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_planner_setArea(point_t min, point_t max){
+    int maxColumn, maxRow;
+    mod_grid_pointToCell(min, &originColumn, &originRow);
+    mod_grid_pointToCell(max, &maxColumn, &maxRow);
+
+    columns = maxColumn - originColumn + 1;
+    rows = maxRow - originRow + 1;
+    if(columns > PLANNER_MAX_COLUMNS) columns = PLANNER_MAX_COLUMNS;
+    if(rows > PLANNER_MAX_ROWS) rows = PLANNER_MAX_ROWS;
+    if(columns < 1) columns = 1;
+    if(rows < 1) rows = 1;
+    isReplanningValid = false;
+}
+
+
+int mod_planner_findPath(point_t start, point_t goal, point_t * path, int maxPoints){
+    int from, to;
+    isReplanningValid = false;
+    if(!pointToPlannerCell(start, &from) || !pointToPlannerCell(goal, &to)) return 0;
+
+    goalCell = to;
+    computeBlockedCells(blocked);
+    memset(g, 0xFF, columns*rows*sizeof(uint16_t));
+    heapSize = 0;
+    isHeapFull = false;
+
+    // A* forward, an entry is outdated if the cell was reached again with a lower cost
+    g[from] = 0;
+    heapPush(computeHeuristic(from, to), 0, from);
+    while(heapSize > 0){
+        heapEntry_t entry = heapPop();
+        int cell = entry.cell;
+        if(entry.key2 != g[cell]) continue;
+        if(cell == to) break;
+
+        for(int direction = 0; direction < 8; direction++){
+            uint16_t cost = getCost(cell, direction);
+            if(cost == COST_INFINITE) continue;
+            int neighbour = getNeighbour(cell, direction);
+            uint16_t total = addCosts(g[cell], cost);
+            if(total < g[neighbour]){
+                g[neighbour] = total;
+                heapPush(total + computeHeuristic(neighbour, to), total, neighbour);
+            }
+        }
+        if(isHeapFull) return 0;
+    }
+    if(g[to] == COST_INFINITE) return 0;
+
+    // Walk back from the goal on the cells where the cost decreases by the move cost, cells are stored reversed
+    int number = 0;
+    int cell = to;
+    while(cell != from){
+        if(number >= PLANNER_MAX_PATH_CELLS) return 0;
+        pathCells[number++] = cell;
+        int previous = -1;
+        for(int direction = 0; direction < 8 && previous < 0; direction++){
+            int neighbour = getNeighbour(cell, direction);
+            if(neighbour < 0 || g[neighbour] == COST_INFINITE) continue;
+            // The move from the neighbour to the cell is in the opposite direction
+            int back = (direction < 4) ? (direction ^ 1) : (11 - direction);
+            if(addCosts(g[neighbour], getCost(neighbour, back)) == g[cell]) previous = neighbour;
+        }
+        if(previous < 0) return 0;
+        cell = previous;
+    }
+
+    for(int i = 0; i < number/2; i++){
+        uint16_t temp = pathCells[i];
+        pathCells[i] = pathCells[number - 1 - i];
+        pathCells[number - 1 - i] = temp;
+    }
+    return simplifyPath(pathCells, number, goal, path, maxPoints);
+}
+
+
+bool mod_planner_startReplanning(point_t start, point_t goal){
+    isReplanningValid = false;
+    if(!pointToPlannerCell(start, &startCell) || !pointToPlannerCell(goal, &goalCell)) return false;
+    goalPoint = goal;
+
+    lastStamp = mod_grid_getStamp();
+    computeBlockedCells(blocked);
+    memset(g, 0xFF, columns*rows*sizeof(uint16_t));
+    memset(rhs, 0xFF, columns*rows*sizeof(uint16_t));
+    heapSize = 0;
+    isHeapFull = false;
+    km = 0;
+    lastStartCell = startCell;
+
+    rhs[goalCell] = 0;
+    heapPush(computeHeuristic(startCell, goalCell), 0, goalCell);
+    isReplanningValid = true;
+    return true;
+}
+
+
+bool mod_planner_updateObstacles(void){
+    if(!isReplanningValid) return false;
+
+    uint32_t stamp = mod_grid_getStamp();
+    if(stamp == lastStamp) return false;
+
+    // The obstacles are inflated again only around the blocks of the grid that changed
+    bool isChanged = false;
+    for(int block = 0; block < GRID_BLOCKS; block++){
+        gridRegion_t region;
+        if(mod_grid_getChangedBlock(block, lastStamp, &region)) isChanged |= updateBlockedCells(&region);
+    }
+    lastStamp = stamp;
+    return isChanged;
+}
+
+
+int mod_planner_replan(point_t start, point_t * path, int maxPoints){
+    if(!isReplanningValid || !pointToPlannerCell(start, &startCell)) return 0;
+
+    km += computeHeuristic(lastStartCell, startCell);
+    lastStartCell = startCell;
+    if(!computeShortestPath()){
+        // The open list is full of outdated entries, a new search from the robot only holds the useful ones
+        if(!mod_planner_startReplanning(start, goalPoint) || !computeShortestPath()){
+            isReplanningValid = false;
+            return 0;
+        }
+    }
+    if(g[startCell] == COST_INFINITE) return 0;
+
+    // Greedy descent on the costs to the goal
+    int number = 0;
+    int cell = startCell;
+    while(cell != goalCell){
+        uint16_t best = COST_INFINITE;
+        int next = -1;
+        for(int direction = 0; direction < 8; direction++){
+            uint16_t cost = getCost(cell, direction);
+            if(cost == COST_INFINITE) continue;
+            uint16_t total = addCosts(cost, g[getNeighbour(cell, direction)]);
+            if(total < best){
+                best = total;
+                next = getNeighbour(cell, direction);
+            }
+        }
+        if(next < 0 || number >= PLANNER_MAX_PATH_CELLS) return 0;
+        pathCells[number++] = next;
+        cell = next;
+    }
+    return simplifyPath(pathCells, number, goalPoint, path, maxPoints);
+}
@@ -0,0 +1,134 @@
+/*
+ * File : mod_pursuit.c
+ * Project : e_puck_project
+ * Description : Closed loop pure pursuit controller on a path of points, run by the planner thread of mod_motion
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_pursuit.h"
+
+// Standard headers
+#include <math.h>
+
+// Our headers
+#include "mod_motors.h"
+
+#define PURSUIT_SPEED               40.0f   // Cruise speed of the center of the robot (in mm/s)
+#define PURSUIT_MIN_SPEED           8.0f    // Speed at the end of the path (in mm/s)
+#define PURSUIT_SLOWDOWN_GAIN       1.0f    // Speed for each mm to the end of the path (in 1/s)
+#define PURSUIT_ROTATION_SPEED      0.8f    // Rotation in place when the goal is behind (in rad/s)
+#define PURSUIT_MAX_HEADING_ERROR   (M_PI/6) // Above this error the robot turns in place before moving
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Returns the distance between two points
+ *
+ * @param[in] x1, y1    The first point
+ * @param[in] x2, y2    The second point
+ *
+ * @param[out] The distance
+ */
+float distanceBetween(float x1, float y1, float x2, float y2);
+
+/**
+ * @brief Find the point of a segment at the lookahead distance of the robot
+ *
+ * @param[in] position  The pose of the robot
+ * @param[in] start     The start of the segment
+ * @param[in] end       The end of the segment
+ * @param[in] goalX     Where to store the x coordinate of the point
+ * @param[in] goalY     Where to store the y coordinate of the point
+ *
+ * @param[out] False if the circle of the lookahead distance does not cut the segment
+ */
+bool findLookaheadPoint(robotPosition_t position, point_t start, point_t end, float * goalX, float * goalY);
+
+/***************/
+
+
+float distanceBetween(float x1, float y1, float x2, float y2){
+    return sqrtf((x2-x1)*(x2-x1) + (y2-y1)*(y2-y1));
+}
+
+
+bool findLookaheadPoint(robotPosition_t position, point_t start, point_t end, float * goalX, float * goalY){
+    // Points of the segment are start + t*(end - start), the furthest solution of |point - robot| = lookahead is kept
+    float directionX = end.x - start.x;
+    float directionY = end.y - start.y;
+    float offsetX = start.x - position.x;
+    float offsetY = start.y - position.y;
+
+    float a = directionX*directionX + directionY*directionY;
+    float b = 2*(offsetX*directionX + offsetY*directionY);
+    float c = offsetX*offsetX + offsetY*offsetY - PURSUIT_LOOKAHEAD*PURSUIT_LOOKAHEAD;
+    float discriminant = b*b - 4*a*c;
+    if(a == 0 || discriminant < 0) return false;
+
+    float t = (-b + sqrtf(discriminant))/(2*a);
+    if(t < 0 || t > 1) return false;
+
+    *goalX = start.x + t*directionX;
+    *goalY = start.y + t*directionY;
+    return true;
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+bool mod_pursuit_computeWheelSpeed(robotPosition_t position, const point_t * points, int number,
+                                   int * segment, wheelSpeed_t * wheelSpeed){
+    *wheelSpeed = (wheelSpeed_t) {0, 0};
+    if(number < 1) return true;
+
+    point_t end = points[number-1];
+    float distanceToEnd = distanceBetween(position.x, position.y, end.x, end.y);
+    if(distanceToEnd < PURSUIT_ARRIVAL_DISTANCE) return true;
+
+    // Points closer than the lookahead distance are considered as reached
+    while(*segment < number-1 &&
+          distanceBetween(position.x, position.y, points[*segment].x, points[*segment].y) < PURSUIT_LOOKAHEAD){
+        (*segment)++;
+    }
+
+    float goalX = points[*segment].x;
+    float goalY = points[*segment].y;
+    if(*segment > 0 && distanceToEnd >= PURSUIT_LOOKAHEAD){
+        findLookaheadPoint(position, points[*segment-1], points[*segment], &goalX, &goalY);
+    }
+
+    // Goal in the robot frame, theta = 0 is the y axis so forward is (-sin, cos)
+    float sinus = sinf(position.theta);
+    float cosinus = cosf(position.theta);
+    float deltaX = goalX - position.x;
+    float deltaY = goalY - position.y;
+    float forward = -deltaX*sinus + deltaY*cosinus;
+    float lateral = -deltaX*cosinus - deltaY*sinus;     // Positive on the left
+    float headingError = atan2f(lateral, forward);
+
+    if(fabsf(headingError) > PURSUIT_MAX_HEADING_ERROR){
+        float rotation = (headingError > 0 ? 1 : -1)*PURSUIT_ROTATION_SPEED;
+        *wheelSpeed = (wheelSpeed_t) {-rotation*ROBOT_RADIUS, rotation*ROBOT_RADIUS};
+        return false;
+    }
+
+    // Pure pursuit : the arc that goes through the goal has a curvature of 2*lateral/distance²
+    float curvature = 2*lateral/(forward*forward + lateral*lateral);
+    float speed = fmaxf(PURSUIT_MIN_SPEED, fminf(PURSUIT_SPEED, PURSUIT_SLOWDOWN_GAIN*distanceToEnd));
+    wheelSpeed->left = speed*(1 - curvature*ROBOT_RADIUS);
+    wheelSpeed->right = speed*(1 + curvature*ROBOT_RADIUS);
+
+    // The fastest wheel stays under the cruise speed in tight curves
+    float fastest = fmaxf(fabsf(wheelSpeed->left), fabsf(wheelSpeed->right));
+    if(fastest > PURSUIT_SPEED){
+        wheelSpeed->left *= PURSUIT_SPEED/fastest;
+        wheelSpeed->right *= PURSUIT_SPEED/fastest;
+    }
+    return false;
+}
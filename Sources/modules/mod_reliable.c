@@ -0,0 +1,100 @@
+/*
+ * File : mod_reliable.c
+ * Project : e_puck_project
+ * Description : Sliding window of a reliable transfer in chunks, acknowledged by the receiver
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_reliable.h"
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_reliable_start(reliableSender_t * sender, uint16_t transfer, size_t size, size_t chunkSize, uint32_t now){
+    sender->transfer = transfer;
+    sender->numberOfChunks = (size + chunkSize - 1)/chunkSize;
+    sender->base = 0;
+    sender->next = 0;
+    sender->recovery = 0;
+    sender->window = RELIABLE_FIRST_WINDOW;
+    sender->credit = 0;
+    sender->timeouts = 0;
+    sender->failed = false;
+    sender->resend = 0;
+    sender->lastProgress = now;
+    sender->retransmitted = 0;
+}
+
+
+int mod_reliable_nextChunk(reliableSender_t * sender, uint32_t now){
+    if(mod_reliable_isFinished(sender)) return -1;
+
+    // Nothing acknowledged for too long, the first chunk or its acknowledgement was lost
+    if(sender->next > sender->base && now - sender->lastProgress >= RELIABLE_ACK_TIMEOUT){
+        if(++sender->timeouts >= RELIABLE_MAX_TIMEOUTS){
+            sender->failed = true;
+            return -1;
+        }
+        sender->window = 1;
+        sender->credit = 0;
+        sender->recovery = sender->next;
+        sender->resend |= 1;
+        sender->lastProgress = now;
+    }
+
+    if(sender->resend){
+        int offset = __builtin_ctz(sender->resend);
+        sender->resend &= ~(1u << offset);
+        sender->retransmitted++;
+        return sender->base + offset;
+    }
+    if(sender->next < sender->numberOfChunks && sender->next < sender->base + sender->window){
+        return sender->next++;
+    }
+    return -1;
+}
+
+
+void mod_reliable_acknowledge(reliableSender_t * sender, uint16_t transfer, uint16_t received, uint32_t now){
+    if(transfer != sender->transfer || received <= sender->base || received > sender->next) return;
+
+    uint16_t acknowledged = received - sender->base;
+    sender->base = received;
+    sender->resend = (acknowledged < 32) ? sender->resend >> acknowledged : 0;
+    sender->timeouts = 0;
+    sender->lastProgress = now;
+
+    // One more chunk each time a full window is acknowledged
+    sender->credit += acknowledged;
+    while(sender->credit >= sender->window && sender->window < RELIABLE_MAX_WINDOW){
+        sender->credit -= sender->window;
+        sender->window++;
+    }
+}
+
+
+void mod_reliable_lost(reliableSender_t * sender, uint16_t transfer, uint16_t chunk){
+    if(transfer != sender->transfer || chunk < sender->base || chunk >= sender->next) return;
+
+    sender->resend |= 1u << (chunk - sender->base);
+    // Chunks sent with the same window are lost by the same congestion
+    if(chunk >= sender->recovery){
+        sender->window = (sender->window > 1) ? sender->window/2 : 1;
+        sender->credit = 0;
+        sender->recovery = sender->next;
+    }
+}
+
+
+bool mod_reliable_isFinished(const reliableSender_t * sender){
+    return sender->failed || sender->base >= sender->numberOfChunks;
+}
+
+
+uint32_t mod_reliable_timeUntilTimeout(const reliableSender_t * sender, uint32_t now){
+    uint32_t elapsed = now - sender->lastProgress;
+    return (elapsed >= RELIABLE_ACK_TIMEOUT) ? 0 : RELIABLE_ACK_TIMEOUT - elapsed;
+}
@@ -0,0 +1,134 @@
+/*
+ * File : mod_safety.c
+ * Project : e_puck_project
+ * Description : Module that slows down, steers or stops the robot in front of unmapped obstacles
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_safety.h"
+
+// Standard headers
+#include <math.h>
+
+// Epuck/ChibiOS headers
+#include <ch.h>
+#include "msgbus/messagebus.h"
+#include "sensors/proximity.h"
+#include <main.h>
+
+// Our headers
+#include "mod_motors.h"
+#include "mod_sensors.h"
+#include "mod_log.h"
+
+#define SAFETY_ROTATION_GAIN    0.02f   // Rotation away from the obstacles (in rad/mm at full repulsion)
+
+// Direction of each IR sensor from the front of the robot (in rad, positive to the left)
+static const float sensorAngle[PROXIMITY_NB_CHANNELS] = {-0.30, -0.80, -M_PI/2, -2.62, 2.62, M_PI/2, 0.80, 0.30};
+
+static bool isEmergency = false;
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Returns how much an IR value repulses the robot
+ *
+ * @param[in] value     The value of the sensor, without ambient light
+ *
+ * @param[out] 0 without obstacle to 1 for an obstacle that stops the robot
+ */
+float computeIRRepulsion(int value);
+
+/**
+ * @brief Compute the correction of the speed from the sensors
+ *
+ * @param[in] proximity     The last proximity measurement
+ * @param[in] tofDistance   The last TOF distance (in mm)
+ * @param[in] speedFactor   Where to store the factor of the forward speed
+ * @param[in] rotation      Where to store the rotation away from the obstacles
+ */
+void computeCorrection(const proximity_msg_t * proximity, int tofDistance, float * speedFactor, float * rotation);
+
+/***************/
+
+
+float computeIRRepulsion(int value){
+    if(value <= SAFETY_IR_INFLUENCE) return 0;
+    if(value >= SAFETY_IR_STOP) return 1;
+    return (float)(value - SAFETY_IR_INFLUENCE)/(SAFETY_IR_STOP - SAFETY_IR_INFLUENCE);
+}
+
+
+void computeCorrection(const proximity_msg_t * proximity, int tofDistance, float * speedFactor, float * rotation){
+    *speedFactor = 1;
+    *rotation = 0;
+
+    // Only the sensors in front of the wheels axis can see an obstacle on the way
+    for(int i = 0; i < PROXIMITY_NB_CHANNELS; i++){
+        float alignment = cosf(sensorAngle[i]);
+        if(alignment <= 0) continue;
+
+        float repulsion = computeIRRepulsion((int)proximity->delta[i] - (int)proximity->initValue[i]);
+        *speedFactor = fminf(*speedFactor, 1 - repulsion*alignment);
+        *rotation -= SAFETY_ROTATION_GAIN*repulsion*sinf(sensorAngle[i]);
+    }
+
+    if(tofDistance < SAFETY_TOF_INFLUENCE_DISTANCE){
+        float factor = (float)(tofDistance - SAFETY_TOF_STOP_DISTANCE)/(SAFETY_TOF_INFLUENCE_DISTANCE - SAFETY_TOF_STOP_DISTANCE);
+        *speedFactor = fminf(*speedFactor, fmaxf(factor, 0));
+    }
+    if(*speedFactor < 0) *speedFactor = 0;
+}
+
+
+/**
+ * @brief Thread that corrects the motors at each new proximity measurement (100 Hz)
+ *
+ * @note    Waiting on the topic gives a reaction within one sensor period,
+ *          the TOF value is the last one measured
+ */
+static THD_WORKING_AREA(safetyThread_wa, 512);
+static THD_FUNCTION(safetyThread, arg){
+    (void) arg;
+
+    messagebus_topic_t *proximityTopic = messagebus_find_topic_blocking(&bus, "/proximity");
+    proximity_msg_t proximity;
+    float lastSpeedFactor = 1;
+    float lastRotation = 0;
+
+    while(1){
+        messagebus_topic_wait(proximityTopic, &proximity, sizeof(proximity));
+
+        float speedFactor, rotation;
+        computeCorrection(&proximity, mod_sensors_getValueTOF(), &speedFactor, &rotation);
+
+        bool emergency = (speedFactor == 0);
+        if(emergency && !isEmergency) LOG_INFO(FMT_EMERGENCY_STOP);
+        isEmergency = emergency;
+
+        // The motors are only updated when the correction changes
+        if(speedFactor != lastSpeedFactor || rotation != lastRotation){
+            mod_motors_setSafetyCorrection(speedFactor, rotation);
+            lastSpeedFactor = speedFactor;
+            lastRotation = rotation;
+        }
+    }
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_safety_start(void){
+    chThdCreateStatic(safetyThread_wa, sizeof(safetyThread_wa), NORMALPRIO+10, safetyThread, NULL);
+}
+
+
+bool mod_safety_isEmergency(void){
+    return isEmergency;
+}
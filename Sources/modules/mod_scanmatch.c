@@ -0,0 +1,173 @@
+/*
+ * File : mod_scanmatch.c
+ * Project : e_puck_project
+ * Description : Module that corrects the robot pose by matching TOF sweeps against the walls (point to line ICP)
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_scanmatch.h"
+
+// Standard headers
+#include <math.h>
+
+#define INLIER_DISTANCE_START       60.0f   // Max distance to associate a point to a wall at the first iteration (in mm)
+#define INLIER_DISTANCE_END         20.0f   // The gate is tightened at each iteration down to this value (in mm)
+#define CONVERGED_TRANSLATION       0.5f    // Under these steps the matching is finished (in mm and rad)
+#define CONVERGED_ROTATION          0.001f
+#define MAX_CORRECTION_ROTATION     (M_PI/8) // A bigger correction means a wrong association
+
+
+// Preallocated ring buffer, a sweep never needs memory from the heap
+static point_t points[SCANMATCH_MAX_POINTS];
+static int numberOfPoints = 0;
+static int nextPoint = 0;
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Solve a 3x3 linear system by Gaussian elimination
+ *
+ * @param[in] matrix    The matrix (changed)
+ * @param[in] vector    The right side, contains the solution at the end
+ *
+ * @param[out] False if the system is singular
+ */
+bool solve3(float matrix[3][3], float vector[3]);
+
+/**
+ * @brief Move a point with the current correction
+ *
+ * @param[in] point     The point
+ * @param[in] center    The center of the rotation
+ * @param[in] match     The correction
+ * @param[in] x         Where to store the moved x coordinate
+ * @param[in] y         Where to store the moved y coordinate
+ */
+void movePoint(point_t point, robotPosition_t center, const scanMatch_t * match, float * x, float * y);
+
+/***************/
+
+
+bool solve3(float matrix[3][3], float vector[3]){
+    for(int column = 0; column < 3; column++){
+        int pivot = column;
+        for(int row = column+1; row < 3; row++){
+            if(fabsf(matrix[row][column]) > fabsf(matrix[pivot][column])) pivot = row;
+        }
+        if(fabsf(matrix[pivot][column]) < 1e-9f) return false;
+
+        for(int k = 0; k < 3; k++){
+            float temp = matrix[column][k];
+            matrix[column][k] = matrix[pivot][k];
+            matrix[pivot][k] = temp;
+        }
+        float temp = vector[column];
+        vector[column] = vector[pivot];
+        vector[pivot] = temp;
+
+        for(int row = column+1; row < 3; row++){
+            float factor = matrix[row][column]/matrix[column][column];
+            for(int k = column; k < 3; k++) matrix[row][k] -= factor*matrix[column][k];
+            vector[row] -= factor*vector[column];
+        }
+    }
+    for(int row = 2; row >= 0; row--){
+        for(int k = row+1; k < 3; k++) vector[row] -= matrix[row][k]*vector[k];
+        vector[row] /= matrix[row][row];
+    }
+    return true;
+}
+
+
+void movePoint(point_t point, robotPosition_t center, const scanMatch_t * match, float * x, float * y){
+    float relativeX = point.x - center.x;
+    float relativeY = point.y - center.y;
+    float cosinus = cosf(match->theta);
+    float sinus = sinf(match->theta);
+    *x = center.x + cosinus*relativeX - sinus*relativeY + match->x;
+    *y = center.y + sinus*relativeX + cosinus*relativeY + match->y;
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_scanmatch_reset(void){
+    numberOfPoints = 0;
+    nextPoint = 0;
+}
+
+
+void mod_scanmatch_addPoint(point_t point){
+    points[nextPoint] = point;
+    nextPoint = (nextPoint + 1) % SCANMATCH_MAX_POINTS;
+    if(numberOfPoints < SCANMATCH_MAX_POINTS) numberOfPoints++;
+}
+
+
+int mod_scanmatch_getNumberOfPoints(void){
+    return numberOfPoints;
+}
+
+
+scanMatch_t mod_scanmatch_match(const line_t * lines, int numberOfLines, robotPosition_t position){
+    scanMatch_t match = {0, 0, 0, 0, 0, 0, false};
+
+    for(int iteration = 0; iteration < SCANMATCH_MAX_ITERATIONS; iteration++){
+        float gate = INLIER_DISTANCE_START - (INLIER_DISTANCE_START - INLIER_DISTANCE_END)*iteration/(SCANMATCH_MAX_ITERATIONS-1);
+        float hessian[3][3] = {{0}};
+        float gradient[3] = {0};
+        float sumError = 0;
+        int inliers = 0;
+
+        for(int i = 0; i < numberOfPoints; i++){
+            float x, y;
+            movePoint(points[i], position, &match, &x, &y);
+
+            // Association with the closest wall
+            int best = -1;
+            float bestResidual = gate;
+            for(int j = 0; j < numberOfLines; j++){
+                float residual = x*cosf(lines[j].angle) + y*sinf(lines[j].angle) - lines[j].distance;
+                if(fabsf(residual) < fabsf(bestResidual)){
+                    best = j;
+                    bestResidual = residual;
+                }
+            }
+            if(best < 0) continue;
+
+            // Derivatives of the residual with respect to (x, y, theta)
+            float normalX = cosf(lines[best].angle);
+            float normalY = sinf(lines[best].angle);
+            float jacobian[3] = {normalX, normalY, -normalX*(y - position.y - match.y) + normalY*(x - position.x - match.x)};
+            for(int k = 0; k < 3; k++){
+                for(int l = 0; l < 3; l++) hessian[k][l] += jacobian[k]*jacobian[l];
+                gradient[k] -= jacobian[k]*bestResidual;
+            }
+            sumError += fabsf(bestResidual);
+            inliers++;
+        }
+
+        match.iterations = iteration+1;
+        match.inliers = inliers;
+        match.error = inliers ? sumError/inliers : 0;
+        if(inliers < 3 || !solve3(hessian, gradient)) break;
+
+        match.x += gradient[0];
+        match.y += gradient[1];
+        match.theta += gradient[2];
+        if(fabsf(gradient[0]) < CONVERGED_TRANSLATION && fabsf(gradient[1]) < CONVERGED_TRANSLATION &&
+           fabsf(gradient[2]) < CONVERGED_ROTATION){
+            match.converged = true;
+            break;
+        }
+    }
+
+    if(fabsf(match.theta) > MAX_CORRECTION_ROTATION) match.converged = false;
+    return match;
+}
@@ -17,9 +17,10 @@
 #include "msgbus/messagebus.h"
 #include "sensors/proximity.h"
 #include "sensors/VL53L0X/VL53L0X.h"
+#include "sensors/imu.h"
 
 // Our headers
-#include "mod_communication.h"
+#include "mod_log.h"
 
 #define OBJECT_DECTECTION_FREQUENCY         130
 #define OBSTACLE_DISTANCE                   90
@@ -53,8 +54,8 @@ static THD_WORKING_AREA(objectDetectionSensor_wa, 1024);
 static THD_FUNCTION(objectDetectionSensor, arg){
     (void) arg;
     while(1){
-        if(!mod_sensors_need_objectDetection) return;
-        else if(mod_sensors_getValueTOF() < OBSTACLE_DISTANCE){
+        // The thread stays alive, it only signals while someone waits for an obstacle
+        if(mod_sensors_need_objectDetection && mod_sensors_getValueTOF() < OBSTACLE_DISTANCE){
             chBSemSignal(&isObstacle_sem);
         }
         chThdSleepMilliseconds(OBJECT_DECTECTION_FREQUENCY);
@@ -75,7 +76,11 @@ void mod_sensors_initSensors(void){
     // Proximity sensors
     messagebus_init(&bus, &bus_lock, &bus_condvar);
     proximity_start();
+    
+    // Inertial unit, the robot must not move during the gyroscope calibration
+    imu_start();
     chThdSleepMilliseconds(500);
+    calibrate_gyro();
 }
 
 void mod_sensors_initCalibration(void){
@@ -144,13 +149,13 @@ void mod_sensors_calibrateIRSensors(void){
 void printSemState(msg_t message){
     switch(message){
         case MSG_OK :
-            mod_com_writeMessage("MSG_OK", 3);
+            LOG_INFO(FMT_SEM_OK);
             break;
         case MSG_RESET :
-            mod_com_writeMessage("MSG_RESET", 3);
+            LOG_INFO(FMT_SEM_RESET);
             break;
         case MSG_TIMEOUT :
-            mod_com_writeMessage("MSG_TIMEOUT", 3);
+            LOG_INFO(FMT_SEM_TIMEOUT);
             break;
         default :
             break;
@@ -0,0 +1,112 @@
+/*
+ * File : mod_stft.c
+ * Project : e_puck_project
+ * Description : Module that computes the spectrum of overlapping frames of a real signal (short time Fourier transform)
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_stft.h"
+
+// Epuck/ChibiOS headers
+#include <arm_math.h>
+
+#define Q15_FFT_SCALE               STFT_SIZE   // arm_rfft_q15 downscales by 2 at each stage
+
+
+// Last samples, the oldest one is at nextSample
+static int16_t ring[STFT_SIZE];
+static int nextSample = 0;
+static int samplesSinceHop = 0;
+static float powers[STFT_SIZE/2];
+
+#if STFT_USE_Q15
+static q15_t window[STFT_SIZE];
+static q15_t frame[STFT_SIZE];
+static q15_t spectrum[2*STFT_SIZE];
+static arm_rfft_instance_q15 fftInstance;
+#else
+static float window[STFT_SIZE];
+static float frame[STFT_SIZE];
+static float spectrum[STFT_SIZE];
+static arm_rfft_fast_instance_f32 fftInstance;
+#endif
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Window the frame from the ring buffer and compute the power of each bin
+ */
+void computeSpectrum(void);
+
+/***************/
+
+
+void computeSpectrum(void){
+#if STFT_USE_Q15
+    for(int i = 0; i < STFT_SIZE; i++){
+        frame[i] = ring[(nextSample + i) % STFT_SIZE];
+    }
+    arm_mult_q15(frame, window, frame, STFT_SIZE);
+    arm_rfft_q15(&fftInstance, frame, spectrum);
+
+    for(int i = 0; i < STFT_SIZE/2; i++){
+        float real = (float) spectrum[2*i]*Q15_FFT_SCALE;
+        float imaginary = (float) spectrum[2*i + 1]*Q15_FFT_SCALE;
+        powers[i] = real*real + imaginary*imaginary;
+    }
+#else
+    for(int i = 0; i < STFT_SIZE; i++){
+        frame[i] = ring[(nextSample + i) % STFT_SIZE]*window[i];
+    }
+    arm_rfft_fast_f32(&fftInstance, frame, spectrum, 0);
+
+    // The real parts of DC and Nyquist are packed in the first two values
+    powers[0] = spectrum[0]*spectrum[0];
+    arm_cmplx_mag_squared_f32(&spectrum[2], &powers[1], STFT_SIZE/2 - 1);
+#endif
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_stft_init(void){
+    for(int i = 0; i < STFT_SIZE; i++){
+        float hann = 0.5f - 0.5f*arm_cos_f32(2*PI*i/STFT_SIZE);
+#if STFT_USE_Q15
+        window[i] = (q15_t) (hann*32767);
+#else
+        window[i] = hann;
+#endif
+        ring[i] = 0;
+    }
+    nextSample = 0;
+    samplesSinceHop = 0;
+
+#if STFT_USE_Q15
+    arm_rfft_init_q15(&fftInstance, STFT_SIZE, 0, 1);
+#else
+    arm_rfft_fast_init_f32(&fftInstance, STFT_SIZE);
+#endif
+}
+
+
+bool mod_stft_addSample(int16_t sample){
+    ring[nextSample] = sample;
+    nextSample = (nextSample + 1) % STFT_SIZE;
+
+    if(++samplesSinceHop < STFT_HOP_SIZE) return false;
+    samplesSinceHop = 0;
+    computeSpectrum();
+    return true;
+}
+
+
+const float * mod_stft_getPowers(void){
+    return powers;
+}
@@ -0,0 +1,133 @@
+/*
+ * File : mod_tofscan.c
+ * Project : e_puck_project
+ * Description : Module that records timestamped TOF samples with the pose of the robot while it rotates
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_tofscan.h"
+
+// Standard headers
+#include <math.h>
+
+// Epuck/ChibiOS headers
+#include "sensors/VL53L0X/VL53L0X.h"
+
+// Our headers
+#include "mod_localization.h"
+#include "mod_sensors.h"
+
+
+// Ring buffer of the current sweep
+static tofSample_t samples[TOFSCAN_BUFFER_SIZE];
+static int numberOfSamples = 0;
+static int nextSample = 0;
+static bool isRecording = false;
+
+MUTEX_DECL(samples_lock);
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Returns the position of the robot at a time between two estimates
+ *
+ * @param[in] previous      The estimate before the time
+ * @param[in] current       The estimate after the time
+ * @param[in] time          The time of the wanted position
+ *
+ * @param[out] The position, linearly interpolated
+ */
+robotPosition_t interpolatePosition(const robotPoseEstimate_t * previous, const robotPoseEstimate_t * current, systime_t time);
+
+/***************/
+
+
+robotPosition_t interpolatePosition(const robotPoseEstimate_t * previous, const robotPoseEstimate_t * current, systime_t time){
+    systime_t interval = current->timestamp - previous->timestamp;
+    if(interval == 0) return current->position;
+
+    float ratio = (float)(systime_t)(time - previous->timestamp)/interval;
+    if(ratio < 0 || ratio > 1) return current->position;
+
+    // The rotation is the shortest one, theta wraps at 2PI
+    float rotation = current->position.theta - previous->position.theta;
+    if(rotation > M_PI) rotation -= 2*M_PI;
+    if(rotation < -M_PI) rotation += 2*M_PI;
+
+    robotPosition_t position;
+    position.x = previous->position.x + lroundf(ratio*(current->position.x - previous->position.x));
+    position.y = previous->position.y + lroundf(ratio*(current->position.y - previous->position.y));
+    position.theta = previous->position.theta + ratio*rotation;
+    if(position.theta >= 2*M_PI) position.theta -= 2*M_PI;
+    if(position.theta < 0) position.theta += 2*M_PI;
+    return position;
+}
+
+
+/**
+ * @brief Thread that stores each new TOF data with the pose of the robot during the ranging
+ */
+static THD_WORKING_AREA(tofscanThread_wa, 512);
+static THD_FUNCTION(tofscanThread, arg){
+    (void) arg;
+
+    robotPoseEstimate_t previous = mod_localization_getEstimate();
+
+    while(1){
+        chBSemWait(&tofNewDatas);
+        robotPoseEstimate_t current = mod_localization_getEstimate();
+
+        if(isRecording){
+            tofSample_t sample;
+            sample.timestamp = chVTGetSystemTime() - MS2ST(TOFSCAN_RANGING_DELAY);
+            sample.measurement.position = interpolatePosition(&previous, &current, sample.timestamp);
+            sample.measurement.value = mod_sensors_getValueTOF();
+
+            chMtxLock(&samples_lock);
+            samples[nextSample] = sample;
+            nextSample = (nextSample + 1) % TOFSCAN_BUFFER_SIZE;
+            if(numberOfSamples < TOFSCAN_BUFFER_SIZE) numberOfSamples++;
+            chMtxUnlock(&samples_lock);
+        }
+        previous = current;
+    }
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_tofscan_start(void){
+    chThdCreateStatic(tofscanThread_wa, sizeof(tofscanThread_wa), NORMALPRIO+7, tofscanThread, NULL);
+}
+
+
+void mod_tofscan_startRecording(void){
+    chMtxLock(&samples_lock);
+    numberOfSamples = 0;
+    nextSample = 0;
+    isRecording = true;
+    chMtxUnlock(&samples_lock);
+}
+
+
+void mod_tofscan_stopRecording(void){
+    isRecording = false;
+}
+
+
+int mod_tofscan_getMeasurements(measurement_t * measurements, int maxMeasurements){
+    chMtxLock(&samples_lock);
+    int number = (numberOfSamples < maxMeasurements) ? numberOfSamples : maxMeasurements;
+    int first = (nextSample - numberOfSamples + TOFSCAN_BUFFER_SIZE) % TOFSCAN_BUFFER_SIZE;
+    for(int i = 0; i < number; i++){
+        measurements[i] = samples[(first + i) % TOFSCAN_BUFFER_SIZE].measurement;
+    }
+    chMtxUnlock(&samples_lock);
+    return number;
+}
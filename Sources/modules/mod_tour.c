@@ -0,0 +1,154 @@
+/*
+ * File : mod_tour.c
+ * Project : e_puck_project
+ * Description : Module that orders the picture positions of the detected objects in one short tour
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_tour.h"
+
+// Standard headers
+#include <math.h>
+
+
+static pictureStop_t stops[TOUR_MAX_STOPS];
+static int numberOfStops = 0;
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Returns the distance between two points
+ *
+ * @param[in] first     The first point
+ * @param[in] second    The second point
+ *
+ * @param[out] The distance (in mm)
+ */
+float computeStopDistance(point_t first, point_t second);
+
+/**
+ * @brief Reverse the order of the stops between two indexes (included)
+ *
+ * @param[in] tour      The tour
+ * @param[in] first     The first index
+ * @param[in] last      The last index
+ */
+void reverseStops(pictureStop_t * tour, int first, int last);
+
+/**
+ * @brief Improve an open tour with 2-opt moves until no move shortens it or the budget is spent
+ *
+ * @param[in] start     The position before the first stop, it stays fixed
+ * @param[in] tour      The tour to improve
+ * @param[in] number    The number of stops
+ */
+void improveOrder(point_t start, pictureStop_t * tour, int number);
+
+/***************/
+
+
+float computeStopDistance(point_t first, point_t second){
+    float deltaX = second.x - first.x;
+    float deltaY = second.y - first.y;
+    return sqrtf(deltaX*deltaX + deltaY*deltaY);
+}
+
+
+void reverseStops(pictureStop_t * tour, int first, int last){
+    while(first < last){
+        pictureStop_t temp = tour[first];
+        tour[first] = tour[last];
+        tour[last] = temp;
+        first++;
+        last--;
+    }
+}
+
+
+void improveOrder(point_t start, pictureStop_t * tour, int number){
+    int improvements = 0;
+    bool improved = true;
+    while(improved && improvements < TOUR_MAX_IMPROVEMENTS){
+        improved = false;
+        for(int i = 0; i < number - 1 && !improved; i++){
+            point_t before = (i == 0) ? start : tour[i-1].position;
+            for(int j = i + 1; j < number && !improved; j++){
+                // Reversing i..j changes only the edges before i and after j, the tour does not come back
+                float gain = computeStopDistance(before, tour[i].position)
+                           - computeStopDistance(before, tour[j].position);
+                if(j < number - 1){
+                    gain += computeStopDistance(tour[j].position, tour[j+1].position)
+                          - computeStopDistance(tour[i].position, tour[j+1].position);
+                }
+                if(gain > 0.5f){
+                    reverseStops(tour, i, j);
+                    improvements++;
+                    improved = true;
+                }
+            }
+        }
+    }
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_tour_reset(void){
+    numberOfStops = 0;
+}
+
+
+bool mod_tour_addObject(point_t object){
+    if(numberOfStops >= TOUR_MAX_STOPS) return false;
+    for(int i = 0; i < numberOfStops; i++){
+        if(computeStopDistance(stops[i].object, object) < TOUR_SAME_OBJECT_DISTANCE) return false;
+    }
+
+    // The picture is taken at the end of the path that mapping computes from here
+    robotPosition_t robot = mod_mapping_getActualPosition();
+    robotDistance_t toDo = mod_mapping_computeDistanceForPicture(object);
+    float direction = robot.theta + M_PI/2 + toDo.rotation;
+
+    stops[numberOfStops].object = object;
+    stops[numberOfStops].position = (point_t) {robot.x + lroundf(toDo.translation*cosf(direction)),
+                                               robot.y + lroundf(toDo.translation*sinf(direction))};
+    numberOfStops++;
+    return true;
+}
+
+
+int mod_tour_getNumberOfStops(void){
+    return numberOfStops;
+}
+
+
+int mod_tour_computeOrder(point_t start, pictureStop_t * tour){
+    bool isVisited[TOUR_MAX_STOPS] = {false};
+    point_t current = start;
+
+    // Nearest neighbour gives the first order
+    for(int n = 0; n < numberOfStops; n++){
+        int best = -1;
+        float bestDistance = 0;
+        for(int i = 0; i < numberOfStops; i++){
+            if(isVisited[i]) continue;
+            float distance = computeStopDistance(current, stops[i].position);
+            if(best < 0 || distance < bestDistance){
+                best = i;
+                bestDistance = distance;
+            }
+        }
+        isVisited[best] = true;
+        tour[n] = stops[best];
+        current = stops[best].position;
+    }
+
+    improveOrder(start, tour, numberOfStops);
+    return numberOfStops;
+}
@@ -0,0 +1,188 @@
+/*
+ * File : mod_transport.c
+ * Project : e_puck_project
+ * Description : Module that carries the bytes of mod_communication over the UART or the USB
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_transport.h"
+
+// Epuck/ChibiOS headers
+#include <ch.h>
+#include <hal.h>
+#include "usbcfg.h"
+
+#define SERIAL_BIT_RATE             115200
+#define FLUSH_POLL_PERIOD           2       // (in ms)
+#define USB_POLL_PERIOD             50      // (in ms)
+
+
+static const transportBackend_t * backend = NULL;
+static transportStats_t stats;
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Wait until an output queue is empty
+ *
+ * @param[in] queue         The queue
+ * @param[in] isAttached    Stops waiting if the link is detached, NULL if always attached
+ */
+void waitQueueEmpty(output_queue_t * queue, bool (*isAttached)(void));
+
+void uartStart(void);
+size_t uartWrite(const uint8_t * bytes, size_t size, uint32_t timeout);
+size_t uartRead(uint8_t * bytes, size_t size, uint32_t timeout);
+void uartFlush(void);
+
+void usbStartLink(void);
+bool usbIsAttached(void);
+size_t usbWrite(const uint8_t * bytes, size_t size, uint32_t timeout);
+size_t usbRead(uint8_t * bytes, size_t size, uint32_t timeout);
+void usbFlush(void);
+
+/***************/
+
+static const transportBackend_t uartBackend = {"UART", uartStart, NULL, uartWrite, uartRead, uartFlush};
+static const transportBackend_t usbBackend = {"USB", usbStartLink, usbIsAttached, usbWrite, usbRead, usbFlush};
+
+
+void waitQueueEmpty(output_queue_t * queue, bool (*isAttached)(void)){
+    while(isAttached == NULL || isAttached()){
+        chSysLock();
+        bool empty = oqIsEmptyI(queue);
+        chSysUnlock();
+        if(empty) return;
+        chThdSleepMilliseconds(FLUSH_POLL_PERIOD);
+    }
+}
+
+
+void uartStart(void){
+    static SerialConfig ser_cfg = {
+        SERIAL_BIT_RATE,
+        0,
+        0,
+        0,
+    };
+
+    sdStart(&SD3, &ser_cfg); // UART3. Connected to the second com port of the programmer
+}
+
+
+size_t uartWrite(const uint8_t * bytes, size_t size, uint32_t timeout){
+    return chnWriteTimeout(&SD3, bytes, size, MS2ST(timeout));
+}
+
+
+size_t uartRead(uint8_t * bytes, size_t size, uint32_t timeout){
+    return chnReadTimeout(&SD3, bytes, size, MS2ST(timeout));
+}
+
+
+void uartFlush(void){
+    waitQueueEmpty(&SD3.oqueue, NULL);
+}
+
+
+void usbStartLink(void){
+    usb_start();
+}
+
+
+bool usbIsAttached(void){
+    return SDU1.config->usbp->state == USB_ACTIVE;
+}
+
+
+size_t usbWrite(const uint8_t * bytes, size_t size, uint32_t timeout){
+    return chnWriteTimeout(&SDU1, bytes, size, MS2ST(timeout));
+}
+
+
+size_t usbRead(uint8_t * bytes, size_t size, uint32_t timeout){
+    return chnReadTimeout(&SDU1, bytes, size, MS2ST(timeout));
+}
+
+
+void usbFlush(void){
+    waitQueueEmpty(&SDU1.oqueue, usbIsAttached);
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_transport_init(transportLink_t link){
+    if(link == TRANSPORT_UART){
+        mod_transport_initBackend(&uartBackend);
+        return;
+    }
+
+    usbBackend.start();
+    if(link == TRANSPORT_USB){
+        backend = &usbBackend;
+        return;
+    }
+
+    // The computer configures the USB a short time after the pull-up is connected
+    for(int waited = 0; waited < TRANSPORT_USB_WAIT && !usbIsAttached(); waited += USB_POLL_PERIOD){
+        chThdSleepMilliseconds(USB_POLL_PERIOD);
+    }
+    if(usbIsAttached()) backend = &usbBackend;
+    else mod_transport_initBackend(&uartBackend);
+}
+
+
+void mod_transport_initBackend(const transportBackend_t * newBackend){
+    newBackend->start();
+    backend = newBackend;
+}
+
+
+size_t mod_transport_write(const void * bytes, size_t size){
+    if(backend == NULL || size == 0) return 0;
+
+    // Nobody reads a detached link, the bytes are dropped at once
+    size_t written = 0;
+    if(backend->isAttached == NULL || backend->isAttached()){
+        written = backend->write((const uint8_t *) bytes, size, TRANSPORT_WRITE_TIMEOUT);
+    }
+    stats.written += written;
+    stats.dropped += size - written;
+    return written;
+}
+
+
+size_t mod_transport_read(uint8_t * bytes, size_t size, uint32_t timeout){
+    if(backend == NULL || (backend->isAttached != NULL && !backend->isAttached())){
+        chThdSleepMilliseconds(timeout);
+        return 0;
+    }
+    size_t read = backend->read(bytes, size, timeout);
+    stats.read += read;
+    return read;
+}
+
+
+void mod_transport_flush(void){
+    if(backend != NULL) backend->flush();
+}
+
+
+const char * mod_transport_getName(void){
+    return (backend != NULL) ? backend->name : NULL;
+}
+
+
+transportStats_t mod_transport_getStats(void){
+    chSysLock();
+    transportStats_t copy = stats;
+    chSysUnlock();
+    return copy;
+}
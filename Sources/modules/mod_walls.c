@@ -0,0 +1,297 @@
+/*
+ * File : mod_walls.c
+ * Project : e_puck_project
+ * Description : Module that estimates walls as straight lines from measured points, in one pass (total least squares)
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "mod_walls.h"
+
+// Standard headers
+#include <math.h>
+
+#define INLIER_DISTANCE             15      // Max distance between a point and its line (in mm)
+#define MIN_INLIERS                 4       // Under this number a line is not considered as a wall
+#define MIN_POINTS_DISTANCE         20      // Two points closer than this can't define a line (in mm)
+#define SEED_INLIERS                3       // Aligned pending points needed to start a line
+#define SEED_DEVIATION              (INLIER_DISTANCE/3)     // Max standard deviation of the points that start a line (in mm)
+#define MERGE_ANGLE                 (M_PI/12)   // Lines closer than this are the same wall
+#define MERGE_DISTANCE              (2*INLIER_DISTANCE)
+
+
+// Running sums and current line of each followed line, no point is stored except the pending ones
+typedef struct {
+    lineFit_t fit;
+    line_t line;
+} candidate_t;
+
+static candidate_t candidates[WALLS_MAX_CANDIDATES];
+static int numberOfCandidates = 0;
+static point_t pending[WALLS_PENDING_POINTS];
+static int numberOfPending = 0;
+static int numberOfPoints = 0;
+
+
+/********************
+ *  Private functions
+ */
+
+/**
+ * @brief Returns the distance between a point and a line
+ *
+ * @param[in] line      The line
+ * @param[in] point     The point
+ *
+ * @param[out] The distance (in mm)
+ */
+float distanceToLine(const line_t * line, point_t point);
+
+/**
+ * @brief Put a line in the form with a positive distance and an angle in 0 -> 2PI
+ *
+ * @param[in] line      The line to change
+ */
+void normalizeLine(line_t * line);
+
+/**
+ * @brief Returns the standard deviation of points around their total least squares line
+ *
+ * @param[in] fit       The running sums of the points
+ *
+ * @param[out] The deviation (in mm)
+ */
+float fitDeviation(const lineFit_t * fit);
+
+/**
+ * @brief Start a line with the pending points aligned with the last one, if there are enough of them
+ */
+void seedCandidate(void);
+
+/**
+ * @brief Returns true if two lines are the same wall
+ *
+ * @param[in] first     The first line
+ * @param[in] second    The second line
+ */
+bool isSameLine(const line_t * first, const line_t * second);
+
+/***************/
+
+
+float distanceToLine(const line_t * line, point_t point){
+    return fabsf(point.x*cosf(line->angle) + point.y*sinf(line->angle) - line->distance);
+}
+
+
+void normalizeLine(line_t * line){
+    if(line->distance < 0){
+        line->distance = -line->distance;
+        line->angle += M_PI;
+    }
+    while(line->angle >= 2*M_PI) line->angle -= 2*M_PI;
+    while(line->angle < 0) line->angle += 2*M_PI;
+}
+
+
+float fitDeviation(const lineFit_t * fit){
+    float meanX = fit->sumX/fit->number;
+    float meanY = fit->sumY/fit->number;
+    float covXX = fit->sumXX/fit->number - meanX*meanX;
+    float covYY = fit->sumYY/fit->number - meanY*meanY;
+    float covXY = fit->sumXY/fit->number - meanX*meanY;
+
+    // Smallest eigenvalue of the covariance, the variance across the line
+    float half = (covXX - covYY)/2;
+    float variance = (covXX + covYY)/2 - sqrtf(half*half + covXY*covXY);
+    return (variance > 0) ? sqrtf(variance) : 0;
+}
+
+
+void seedCandidate(void){
+    point_t last = pending[numberOfPending-1];
+    line_t best = {0, 0, 0};
+    line_t bestHypothesis;
+    lineFit_t bestFit;
+    float bestDeviation = SEED_DEVIATION;
+
+    // Hypotheses through the last point and each older pending one, the one with most pending inliers wins
+    for(int i = 0; i < numberOfPending-1; i++){
+        int deltaX = last.x - pending[i].x;
+        int deltaY = last.y - pending[i].y;
+        if(deltaX*deltaX + deltaY*deltaY < MIN_POINTS_DISTANCE*MIN_POINTS_DISTANCE) continue;
+
+        line_t hypothesis;
+        hypothesis.angle = atan2f(deltaX, -deltaY);
+        hypothesis.distance = last.x*cosf(hypothesis.angle) + last.y*sinf(hypothesis.angle);
+        lineFit_t fit;
+        mod_walls_fitReset(&fit);
+        for(int j = 0; j < numberOfPending; j++){
+            if(distanceToLine(&hypothesis, pending[j]) < INLIER_DISTANCE) mod_walls_fitAdd(&fit, pending[j]);
+        }
+        if(fit.number < SEED_INLIERS || fit.number < best.inliers) continue;
+
+        // Points of two walls around a corner can be close to a line, not aligned on it
+        float deviation = fitDeviation(&fit);
+        if(fit.number == best.inliers && deviation >= bestDeviation) continue;
+        if(deviation >= SEED_DEVIATION) continue;
+        best = mod_walls_fitLine(&fit);
+        bestHypothesis = hypothesis;
+        bestFit = fit;
+        bestDeviation = deviation;
+    }
+    if(best.inliers < SEED_INLIERS) return;
+
+    // A full table only gives the place of a line that is not a wall yet
+    int slot = numberOfCandidates;
+    if(slot == WALLS_MAX_CANDIDATES){
+        for(int i = 0; i < numberOfCandidates; i++){
+            if(candidates[i].fit.number < MIN_INLIERS && (slot == WALLS_MAX_CANDIDATES
+                    || candidates[i].fit.number < candidates[slot].fit.number)) slot = i;
+        }
+        if(slot == WALLS_MAX_CANDIDATES) return;
+    }
+    else numberOfCandidates++;
+    candidates[slot].fit = bestFit;
+    candidates[slot].line = best;
+
+    // The inliers leave the pending points
+    int kept = 0;
+    for(int i = 0; i < numberOfPending; i++){
+        if(distanceToLine(&bestHypothesis, pending[i]) >= INLIER_DISTANCE) pending[kept++] = pending[i];
+    }
+    numberOfPending = kept;
+}
+
+
+bool isSameLine(const line_t * first, const line_t * second){
+    float angle = fabsf(first->angle - second->angle);
+    if(angle > M_PI) angle = 2*M_PI - angle;
+    return angle < MERGE_ANGLE && fabsf(first->distance - second->distance) < MERGE_DISTANCE;
+}
+
+
+/**************
+ * Public  functions (informations in the header)
+ */
+
+void mod_walls_reset(void){
+    numberOfCandidates = 0;
+    numberOfPending = 0;
+    numberOfPoints = 0;
+}
+
+
+void mod_walls_addPoint(point_t point){
+    numberOfPoints++;
+
+    int closest = -1;
+    float closestDistance = INLIER_DISTANCE;
+    for(int i = 0; i < numberOfCandidates; i++){
+        float distance = distanceToLine(&candidates[i].line, point);
+        if(distance < closestDistance){
+            closest = i;
+            closestDistance = distance;
+        }
+    }
+    if(closest >= 0){
+        mod_walls_fitAdd(&candidates[closest].fit, point);
+        candidates[closest].line = mod_walls_fitLine(&candidates[closest].fit);
+        return;
+    }
+
+    // The oldest pending point is forgotten, it was an outlier
+    if(numberOfPending == WALLS_PENDING_POINTS){
+        for(int i = 1; i < WALLS_PENDING_POINTS; i++) pending[i-1] = pending[i];
+        numberOfPending--;
+    }
+    pending[numberOfPending++] = point;
+    if(numberOfPending >= SEED_INLIERS) seedCandidate();
+}
+
+
+int mod_walls_getNumberOfPoints(void){
+    return numberOfPoints;
+}
+
+
+int mod_walls_findLines(line_t * lines, int maxLines){
+    for(int i = 0; i < numberOfCandidates; i++){
+        for(int j = i+1; j < numberOfCandidates; j++){
+            if(!isSameLine(&candidates[i].line, &candidates[j].line)) continue;
+            mod_walls_fitMerge(&candidates[i].fit, &candidates[j].fit);
+            candidates[i].line = mod_walls_fitLine(&candidates[i].fit);
+            candidates[j] = candidates[--numberOfCandidates];
+            j = i;
+        }
+    }
+
+    // Insertion by number of inliers
+    int numberOfLines = 0;
+    for(int i = 0; i < numberOfCandidates; i++){
+        if(candidates[i].fit.number < MIN_INLIERS) continue;
+        int position = numberOfLines;
+        while(position > 0 && lines[position-1].inliers < candidates[i].fit.number){
+            if(position < maxLines) lines[position] = lines[position-1];
+            position--;
+        }
+        if(position < maxLines) lines[position] = candidates[i].line;
+        if(numberOfLines < maxLines) numberOfLines++;
+    }
+    return numberOfLines;
+}
+
+
+void mod_walls_fitReset(lineFit_t * fit){
+    *fit = (lineFit_t) {0, {0,0}, .0, .0, .0, .0, .0};
+}
+
+
+void mod_walls_fitAdd(lineFit_t * fit, point_t point){
+    if(fit->number == 0) fit->reference = point;
+
+    float x = point.x - fit->reference.x;
+    float y = point.y - fit->reference.y;
+    fit->number++;
+    fit->sumX += x;
+    fit->sumY += y;
+    fit->sumXX += x*x;
+    fit->sumYY += y*y;
+    fit->sumXY += x*y;
+}
+
+
+line_t mod_walls_fitLine(const lineFit_t * fit){
+    line_t line;
+    float meanX = fit->sumX/fit->number;
+    float meanY = fit->sumY/fit->number;
+    float covXX = fit->sumXX/fit->number - meanX*meanX;
+    float covYY = fit->sumYY/fit->number - meanY*meanY;
+    float covXY = fit->sumXY/fit->number - meanX*meanY;
+
+    // The normal is the direction of the smallest variance
+    line.angle = 0.5f*atan2f(2*covXY, covXX - covYY) + M_PI/2;
+    line.distance = (meanX + fit->reference.x)*cosf(line.angle) + (meanY + fit->reference.y)*sinf(line.angle);
+    line.inliers = fit->number;
+    normalizeLine(&line);
+    return line;
+}
+
+
+void mod_walls_fitMerge(lineFit_t * fit, const lineFit_t * other){
+    if(other->number == 0) return;
+    if(fit->number == 0){
+        *fit = *other;
+        return;
+    }
+
+    // The other sums are moved to the reference of the first ones
+    float deltaX = other->reference.x - fit->reference.x;
+    float deltaY = other->reference.y - fit->reference.y;
+    fit->sumXX += other->sumXX + 2*deltaX*other->sumX + other->number*deltaX*deltaX;
+    fit->sumYY += other->sumYY + 2*deltaY*other->sumY + other->number*deltaY*deltaY;
+    fit->sumXY += other->sumXY + deltaX*other->sumY + deltaY*other->sumX + other->number*deltaX*deltaY;
+    fit->sumX += other->sumX + other->number*deltaX;
+    fit->sumY += other->sumY + other->number*deltaY;
+    fit->number += other->number;
+}
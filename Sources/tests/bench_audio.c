@@ -0,0 +1,356 @@
+/*
+ * File : bench_audio.c
+ * Project : e_puck_project
+ * Description : Host harness of the command detection of mod_audio on PCM of the four microphones,
+ *               detection latency and false triggers (built once with the STFT, once with the Goertzel bank)
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "host.h"
+#include "mod_audio.h"
+#include "mod_beamforming.h"
+#include "audio/play_melody.h"
+#include "audio/microphone.h"
+
+#include <math.h>
+#include <stdbool.h>
+
+// As in mod_audio, the Goertzel bank is built for the comparison
+#ifndef USE_STFT
+#define USE_STFT                1
+#endif
+
+#if USE_STFT
+#define DETECTION_NAME          "stft"
+#else
+#define DETECTION_NAME          "goertzel"
+#endif
+
+#define SAMPLING_FREQUENCY      16000
+#define BUFFER_SIZE             160     // Samples of each microphone given by the driver at once (10 ms)
+#define SOUND_SPEED             343000.0    // (in mm/s)
+#define BIN_FREQUENCY           (SAMPLING_FREQUENCY/1024.0)     // Bins of the commands in mod_audio (in Hz)
+
+#define BACKGROUND_NOISE        40      // Noise of each microphone, robot stopped (rms, in LSB)
+#define MIN_AMPLITUDE           400     // Tones of the operator, the detection threshold is near 300 LSB
+#define MAX_AMPLITUDE           4000
+#define MAX_DETUNING            5.0     // The generator of the operator is not exactly on the bins (in Hz)
+#define NUMBER_OF_TRIALS        500
+#define SILENCE_DURATION        1.0     // Background before each tone (in s)
+#define TONE_DURATION           1.0     // A tone not detected after this time is missed (in s)
+
+#define INTERFERENCE_DURATION   180.0   // Of each kind of interference (in s)
+#define MIN_OFF_COMMAND         (3*BIN_FREQUENCY)   // Off command tones are at least this far from a command (in Hz)
+#define MAX_SOURCES             4
+
+#define FAST_SWEEP              2000.0  // Sweeps faster than this cross the bins of a command in less than 25 ms (in Hz/s)
+#define MAX_SWEEP               3000.0
+#define MIN_SWEEP               500.0
+
+#define MIN_DETECTION_RATE      0.99f
+#define MAX_MEAN_LATENCY        0.15    // (in s)
+// A slower sweep stays on the bins of a command as long as a short command, it can't be rejected without
+// rejecting the commands too, this only bounds its rate
+#define MAX_SLOW_SWEEP_TRIGGERS 200.0f  // (per minute)
+
+typedef enum {
+    SOURCE_TONE = 0,
+    SOURCE_NOISE
+} sourceType_t;
+
+/**
+ * @brief A sound heard by the robot, tones can sweep
+ */
+typedef struct {
+    sourceType_t type;
+    double start;           // (in s)
+    double end;
+    double frequency;       // At the start (in Hz)
+    double sweep;           // (in Hz/s)
+    double amplitude;       // Peak for a tone, rms for a noise (in LSB)
+    double angle;           // Direction, positive to the left of the front (in rad)
+} source_t;
+
+typedef struct {
+    int detections;
+    int wrong;
+    double latency;         // Sum (in s)
+    double maxLatency;
+} latency_t;
+
+// Approximative positions of the microphones as in mod_beamforming, interleaved as right, left, back, front
+static const double micForward[BEAM_NUMBER_OF_MICS] = {0, 0, -25, 25};
+static const double micLeft[BEAM_NUMBER_OF_MICS] = {-30, 30, 0, 0};
+
+static const command_t commands[] = {CMD_DISCOVERING, CMD_EXPLORATION, CMD_MAPSEND, CMD_SING, CMD_CALIBRATION};
+static const int commandBins[] = {33, 39, 46, 52, 59};
+#define NUMBER_OF_COMMANDS      ((int)(sizeof(commands)/sizeof(commands[0])))
+
+static mp45dt02FullBufferCb callback = NULL;
+static int16_t buffer[BEAM_NUMBER_OF_MICS*BUFFER_SIZE];
+static long sampleCount = 0;       // Samples of each microphone given to mod_audio
+static double processingTime = 0;
+
+
+void play_melody_start(void){
+}
+
+
+void play_melody(song_selection_t choice){
+}
+
+
+void stop_current_melody(void){
+}
+
+
+void wait_until_melody_end(void){
+}
+
+
+void mic_start(mp45dt02FullBufferCb customFullbufferCb){
+    callback = customFullbufferCb;
+}
+
+
+static double gaussian(void){
+    double first = 1.0 - host_random();
+    double second = host_random();
+    return sqrt(-2*log(first))*cos(2*M_PI*second);
+}
+
+
+static double randomBetween(double min, double max){
+    return min + (max - min)*host_random();
+}
+
+
+static int16_t saturate(double value){
+    if(value > INT16_MAX) return INT16_MAX;
+    if(value < INT16_MIN) return INT16_MIN;
+    return (int16_t) lround(value);
+}
+
+
+/**
+ * @brief Give one buffer of the microphones to mod_audio, as the driver does
+ *
+ * @param[out]      True if a command was detected in this buffer
+ */
+static bool processBuffer(const source_t * sources, int numberOfSources){
+    for(int i = 0; i < BUFFER_SIZE; i++){
+        double time = (double)(sampleCount + i)/SAMPLING_FREQUENCY;
+        double noise[MAX_SOURCES];
+        for(int source = 0; source < numberOfSources; source++){
+            noise[source] = sources[source].amplitude*gaussian();
+        }
+
+        for(int mic = 0; mic < BEAM_NUMBER_OF_MICS; mic++){
+            double value = BACKGROUND_NOISE*gaussian();
+            for(int source = 0; source < numberOfSources; source++){
+                const source_t * sound = &sources[source];
+                if(time < sound->start || time >= sound->end) continue;
+                if(sound->type == SOURCE_NOISE){
+                    value += noise[source];
+                    continue;
+                }
+                // The phase of a sweep is the integral of its frequency, each microphone hears it with its delay
+                double delay = -(micForward[mic]*cos(sound->angle) + micLeft[mic]*sin(sound->angle))/SOUND_SPEED;
+                double elapsed = time - delay - sound->start;
+                value += sound->amplitude*sin(2*M_PI*(sound->frequency + sound->sweep*elapsed/2)*elapsed);
+            }
+            buffer[BEAM_NUMBER_OF_MICS*i + mic] = saturate(value);
+        }
+    }
+    sampleCount += BUFFER_SIZE;
+
+    bool wasListening = needAudio;
+    double start = host_now();
+    callback(buffer, BEAM_NUMBER_OF_MICS*BUFFER_SIZE);
+    processingTime += host_now() - start;
+    return wasListening && !needAudio;
+}
+
+
+static double now(void){
+    return (double) sampleCount/SAMPLING_FREQUENCY;
+}
+
+
+/**
+ * @brief Returns a frequency between two, at least MIN_OFF_COMMAND from the commands
+ */
+static double offCommandFrequency(double min, double max){
+    while(1){
+        double frequency = randomBetween(min, max);
+        bool isFar = true;
+        for(int command = 0; command < NUMBER_OF_COMMANDS; command++){
+            if(fabs(frequency - commandBins[command]*BIN_FREQUENCY) < MIN_OFF_COMMAND) isFar = false;
+        }
+        if(isFar) return frequency;
+    }
+}
+
+
+/**
+ * @brief Tones of the operator from any direction, after a silence, the latency is counted to the end of
+ *        the buffer where the command is given
+ */
+static void testLatency(void){
+    latency_t result = {0, 0, 0, 0};
+    int falseTriggers = 0;
+    int missed = 0;
+
+    for(int trial = 0; trial < NUMBER_OF_TRIALS; trial++){
+        int command = trial % NUMBER_OF_COMMANDS;
+        source_t tone = {SOURCE_TONE, 0, 0, 0, 0, 0, 0};
+        tone.frequency = commandBins[command]*BIN_FREQUENCY + randomBetween(-MAX_DETUNING, MAX_DETUNING);
+        tone.amplitude = MIN_AMPLITUDE*exp(log((double) MAX_AMPLITUDE/MIN_AMPLITUDE)*host_random());
+        tone.angle = randomBetween(-M_PI, M_PI);
+
+        needAudio = true;
+        double silenceEnd = now() + SILENCE_DURATION + randomBetween(0, 0.01);
+        while(now() < silenceEnd){
+            if(processBuffer(NULL, 0)){
+                falseTriggers++;
+                needAudio = true;
+            }
+        }
+
+        // The tone starts anywhere in a buffer
+        tone.start = silenceEnd - randomBetween(0, (double) BUFFER_SIZE/SAMPLING_FREQUENCY);
+        tone.end = tone.start + TONE_DURATION;
+        bool isDetected = false;
+        while(now() < tone.end && !isDetected){
+            isDetected = processBuffer(&tone, 1);
+        }
+        if(!isDetected){
+            missed++;
+            continue;
+        }
+
+        double latency = now() - tone.start;
+        result.detections++;
+        result.wrong += mod_audio_processedCommand != commands[command];
+        result.latency += latency;
+        if(latency > result.maxLatency) result.maxLatency = latency;
+    }
+    needAudio = false;
+
+    float rate = (float) result.detections/NUMBER_OF_TRIALS;
+    double meanLatency = result.detections ? result.latency/result.detections : 0;
+    printf("%d tones of %d to %d LSB: %.1f %% detected, %d wrong, latency %.0f ms (mean) %.0f ms (max), "
+           "%d false triggers in the silences\n", NUMBER_OF_TRIALS, MIN_AMPLITUDE, MAX_AMPLITUDE, 100*rate,
+           result.wrong, 1e3*meanLatency, 1e3*result.maxLatency, falseTriggers);
+    CHECK(rate >= MIN_DETECTION_RATE, "%d tones missed", missed);
+    CHECK(result.wrong == 0, "%d tones detected as another command", result.wrong);
+    CHECK(meanLatency < MAX_MEAN_LATENCY, "mean latency %.0f ms", 1e3*meanLatency);
+    CHECK(falseTriggers == 0, "%d false triggers in the background noise", falseTriggers);
+}
+
+
+/**
+ * @brief Listen to sounds that are not commands and count the detections
+ *
+ * @param[in] type      The kind of sounds: 0 claps and voices (noise bursts), 1 whistles and music (tones
+ *                      off the commands), 2 slow sweeps crossing the commands, 3 fast sweeps
+ *
+ * @param[out]      The number of detections per minute
+ */
+static float countFalseTriggers(int type){
+    int triggers = 0;
+    double end = now() + INTERFERENCE_DURATION;
+    needAudio = true;
+
+    while(now() < end){
+        source_t sound = {SOURCE_TONE, now(), 0, 0, 0, 0, randomBetween(-M_PI, M_PI)};
+        double gap = randomBetween(0.05, 0.5);
+        switch(type){
+            case 0:
+                sound.type = SOURCE_NOISE;
+                sound.end = sound.start + randomBetween(0.05, 0.4);
+                sound.amplitude = randomBetween(200, 3000);
+                break;
+            case 1:
+                sound.end = sound.start + randomBetween(0.1, 1.0);
+                sound.frequency = offCommandFrequency(300, 1000);
+                sound.amplitude = randomBetween(MIN_AMPLITUDE, MAX_AMPLITUDE);
+                break;
+            default:
+                sound.end = sound.start + randomBetween(0.2, 1.0);
+                sound.sweep = (type == 2) ? randomBetween(MIN_SWEEP, FAST_SWEEP) : randomBetween(FAST_SWEEP, MAX_SWEEP);
+                sound.sweep *= (host_random() < 0.5) ? -1 : 1;
+                sound.frequency = (sound.sweep > 0) ? randomBetween(300, 500) : randomBetween(800, 1000);
+                sound.amplitude = randomBetween(MIN_AMPLITUDE, MAX_AMPLITUDE);
+                break;
+        }
+        while(now() < sound.end + gap){
+            if(processBuffer(&sound, 1)){
+                triggers++;
+                needAudio = true;
+            }
+        }
+    }
+    needAudio = false;
+    return triggers*60/INTERFERENCE_DURATION;
+}
+
+
+static void testFalseTriggers(void){
+    float bursts = countFalseTriggers(0);
+    float tones = countFalseTriggers(1);
+    float slowSweeps = countFalseTriggers(2);
+    float fastSweeps = countFalseTriggers(3);
+    printf("False triggers per minute: noise bursts %.2f, tones off the commands %.2f, "
+           "sweeps from %.0f to %.0f Hz/s %.2f, from %.0f to %.0f Hz/s %.2f\n", bursts, tones,
+           MIN_SWEEP, FAST_SWEEP, slowSweeps, FAST_SWEEP, MAX_SWEEP, fastSweeps);
+    CHECK(bursts == 0, "%.2f false triggers per minute with noise bursts", bursts);
+    CHECK(tones == 0, "%.2f false triggers per minute with tones off the commands", tones);
+    CHECK(fastSweeps == 0, "%.2f false triggers per minute with fast sweeps", fastSweeps);
+    CHECK(slowSweeps <= MAX_SLOW_SWEEP_TRIGGERS, "%.2f false triggers per minute with slow sweeps", slowSweeps);
+}
+
+
+/**
+ * @brief Print the commands found in a recording: raw 16 bits PCM at 16 kHz, four microphones interleaved
+ *        as the driver gives them (right, left, back, front)
+ */
+static void replayRecording(const char * name){
+    FILE * file = fopen(name, "rb");
+    CHECK(file != NULL, "cannot open %s", name);
+    if(file == NULL) return;
+
+    long samples = 0;
+    needAudio = true;
+    while(fread(buffer, sizeof(int16_t), BEAM_NUMBER_OF_MICS*BUFFER_SIZE, file) == BEAM_NUMBER_OF_MICS*BUFFER_SIZE){
+        samples += BUFFER_SIZE;
+        callback(buffer, BEAM_NUMBER_OF_MICS*BUFFER_SIZE);
+        if(!needAudio){
+            printf("  %8.2f s: command %d\n", (double) samples/SAMPLING_FREQUENCY, mod_audio_processedCommand);
+            needAudio = true;
+        }
+    }
+    needAudio = false;
+    fclose(file);
+}
+
+
+int main(int argc, char * argv[]){
+    mod_audio_initModule();
+    mod_audio_listenForSound();
+    CHECK(callback != NULL, "no callback given to the microphones");
+    if(callback == NULL) return host_result("bench_audio_" DETECTION_NAME);
+
+    if(argc > 1){
+        printf("Commands in %s (" DETECTION_NAME "):\n", argv[1]);
+        replayRecording(argv[1]);
+        return host_result("bench_audio_" DETECTION_NAME);
+    }
+
+    printf("Detection with the " DETECTION_NAME ":\n");
+    testLatency();
+    testFalseTriggers();
+    printf("Processing: %.1f us per 10 ms buffer (host)\n", 1e6*processingTime/(sampleCount/BUFFER_SIZE));
+    return host_result("bench_audio_" DETECTION_NAME);
+}
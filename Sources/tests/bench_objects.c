@@ -0,0 +1,93 @@
+/*
+ * File : bench_objects.c
+ * Project : e_puck_project
+ * Description : Host benchmark of mod_objects against the linear search it replaced
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "host.h"
+#include "mod_objects.h"
+
+#define AREA_SIZE           20000   // Side of the square where the objects are (in mm)
+#define MERGE_RADIUS        60      // TOLERANCE_OBJECT of mod_mapping (in mm)
+#define NUMBER_OF_QUERIES   100000
+
+static point_t objects[OBJECTS_MAX_NUMBER];
+static point_t queries[NUMBER_OF_QUERIES];
+
+
+/**
+ * @brief The search of mod_mapping before the index, through all the objects
+ */
+static int linearNearest(int number, point_t center, int radius){
+    int nearest = OBJECT_NONE;
+    int nearestDistance = radius*radius;
+    for(int i = 0; i < number; i++){
+        int distance = (objects[i].x-center.x)*(objects[i].x-center.x) + (objects[i].y-center.y)*(objects[i].y-center.y);
+        if(distance < nearestDistance){
+            nearest = i;
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+
+
+static point_t randomPoint(void){
+    return (point_t) {(int)(host_random()*AREA_SIZE), (int)(host_random()*AREA_SIZE)};
+}
+
+
+static void benchmark(int number){
+    mod_objects_reset();
+    for(int i = 0; i < number; i++){
+        objects[i] = randomPoint();
+        CHECK(mod_objects_insert(objects[i]) == i, "insert %d", i);
+    }
+    // Half of the queries fall close to an object
+    for(int i = 0; i < NUMBER_OF_QUERIES; i++){
+        queries[i] = randomPoint();
+        if(i % 2){
+            point_t object = objects[(int)(host_random()*number)];
+            queries[i] = (point_t) {object.x + (int)(host_random()*80) - 40, object.y + (int)(host_random()*80) - 40};
+        }
+    }
+
+    int mismatches = 0;
+    double start = host_now();
+    for(int i = 0; i < NUMBER_OF_QUERIES; i++){
+        int id = mod_objects_findNearest(queries[i], MERGE_RADIUS);
+        mismatches += (id == OBJECT_NONE) != (linearNearest(number, queries[i], MERGE_RADIUS) == OBJECT_NONE);
+    }
+    double both = host_now() - start;
+
+    start = host_now();
+    volatile int found = 0;
+    for(int i = 0; i < NUMBER_OF_QUERIES; i++) found += mod_objects_findNearest(queries[i], MERGE_RADIUS) != OBJECT_NONE;
+    double indexed = host_now() - start;
+    double linear = both - indexed;
+    CHECK(mismatches == 0, "%d objects: %d queries differ from the linear search", number, mismatches);
+
+    // Detections of known objects are merged, not added
+    start = host_now();
+    int added = 0;
+    for(int i = 0; i < number; i++){
+        bool isNew;
+        point_t detection = {objects[i].x + 5, objects[i].y - 5};
+        if(mod_objects_merge(detection, MERGE_RADIUS, &isNew) != OBJECT_NONE && isNew) added++;
+    }
+    double merge = host_now() - start;
+    CHECK(added == 0, "%d objects: %d detections of known objects were added", number, added);
+
+    printf("%5d objects: nearest %.3f us (linear %.3f us), merge %.3f us\n", number,
+           1e6*indexed/NUMBER_OF_QUERIES, 1e6*linear/NUMBER_OF_QUERIES, 1e6*merge/number);
+}
+
+
+int main(void){
+    for(int number = 500; number <= OBJECTS_MAX_NUMBER; number *= 2){
+        benchmark(number);
+    }
+    return host_result("bench_objects");
+}
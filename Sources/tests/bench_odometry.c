@@ -0,0 +1,166 @@
+/*
+ * File : bench_odometry.c
+ * Project : e_puck_project
+ * Description : Host benchmark of mod_odometry against the float odometry it replaced
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "host.h"
+#include "mod_odometry.h"
+#include "mod_motors.h"
+
+#include <main.h>
+
+#define NUMBER_OF_RUNS      50
+#define RUN_DURATION        60000   // Duration of a random trajectory (in ms)
+#define MAX_SPEED           130     // Speed of the wheels (in mm/s)
+#define MAX_MAX_ERROR       2.0     // Max position error allowed after a run of about 4 m (in mm)
+#define NUMBER_OF_UPDATES   2000000
+#define FIXED_ONE           ((double)(1 << ODOMETRY_FRACTION_BITS))
+
+messagebus_t bus;
+
+typedef struct {
+    double x;
+    double y;
+    double theta;
+} exactPose_t;
+
+typedef struct {
+    double meanError;
+    double maxError;
+} error_t;
+
+
+float mod_motors_getStepsPerMm(void){
+    return 1000/(M_PI*41);
+}
+
+
+/**
+ * @brief The odometry of mod_mapping before mod_odometry, double trigonometry and int mm
+ */
+static robotPosition_t floatIntegrate(robotPosition_t* lastPosition, const wheelSpeed_t *wheelSpeed, int time){
+    robotPosition_t newPosition;
+    newPosition.x = lastPosition->x +   time*(wheelSpeed->right+wheelSpeed->left)*cos(lastPosition->theta+M_PI/2)/(2*1000);
+    newPosition.y = lastPosition->y +   time*(wheelSpeed->right+wheelSpeed->left)*sin(lastPosition->theta+M_PI/2)/(2*1000);
+    newPosition.theta = lastPosition->theta +   (wheelSpeed->right-wheelSpeed->left)*time/(ROBOT_RADIUS*2*1000);
+    while(newPosition.theta >= 2*M_PI) newPosition.theta -= 2*M_PI;
+    while(newPosition.theta < 0) newPosition.theta += 2*M_PI;
+    return newPosition;
+}
+
+
+/**
+ * @brief Exact displacement of wheels at a constant speed, an arc of circle
+ */
+static void exactIntegrate(exactPose_t * pose, const wheelSpeed_t * wheelSpeed, int time){
+    double duration = time/1000.0;
+    double speed = (wheelSpeed->left + wheelSpeed->right)/2.0;
+    double rotationSpeed = (wheelSpeed->right - wheelSpeed->left)/(2.0*ROBOT_RADIUS);
+    double theta = pose->theta + rotationSpeed*duration;
+    if(fabs(rotationSpeed) < 1e-9){
+        pose->x -= speed*duration*sin(pose->theta);
+        pose->y += speed*duration*cos(pose->theta);
+    }
+    else{
+        pose->x += speed/rotationSpeed*(cos(theta) - cos(pose->theta));
+        pose->y += speed/rotationSpeed*(sin(theta) - sin(pose->theta));
+    }
+    pose->theta = theta;
+}
+
+
+static double distance(double x1, double y1, double x2, double y2){
+    return sqrt((x1-x2)*(x1-x2) + (y1-y2)*(y1-y2));
+}
+
+
+static void addError(error_t * error, double value){
+    error->meanError += value/NUMBER_OF_RUNS;
+    if(value > error->maxError) error->maxError = value;
+}
+
+
+/**
+ * @brief Random trajectories of constant speed segments, integrated by all the methods
+ */
+static void benchmarkAccuracy(void){
+    error_t floatError = {0, 0};
+    error_t fixedError = {0, 0};
+    error_t fastError = {0, 0};
+    int periodFast = 1000/(5*ODOMETRY_FREQUENCY);   // The kHz rate of the request
+
+    for(int run = 0; run < NUMBER_OF_RUNS; run++){
+        robotPosition_t start = {300, 400, 0};
+        exactPose_t exact = {start.x, start.y, start.theta};
+        robotPosition_t floatPosition = start;
+        odometryPose_t fixed = mod_odometry_fromRobotPosition(start);
+        odometryPose_t fast = fixed;
+
+        for(int time = 0; time < RUN_DURATION;){
+            wheelSpeed_t speed = {(2*host_random() - 1)*MAX_SPEED, (2*host_random() - 1)*MAX_SPEED};
+            int segment = 200 + (int)(host_random()*1800);
+            segment -= segment % (1000/ODOMETRY_FREQUENCY);
+            exactIntegrate(&exact, &speed, segment);
+            for(int step = 0; step < segment; step += 1000/ODOMETRY_FREQUENCY){
+                floatPosition = floatIntegrate(&floatPosition, &speed, 1000/ODOMETRY_FREQUENCY);
+                mod_odometry_integrateWheelSpeed(&fixed, &speed, 1000/ODOMETRY_FREQUENCY);
+            }
+            for(int step = 0; step < segment; step += periodFast){
+                mod_odometry_integrateWheelSpeed(&fast, &speed, periodFast);
+            }
+            time += segment;
+        }
+
+        robotPosition_t fixedPosition = mod_odometry_toRobotPosition(&fixed);
+        addError(&floatError, distance(floatPosition.x, floatPosition.y, exact.x, exact.y));
+        addError(&fixedError, distance(fixed.x/FIXED_ONE, fixed.y/FIXED_ONE, exact.x, exact.y));
+        addError(&fastError, distance(fast.x/FIXED_ONE, fast.y/FIXED_ONE, exact.x, exact.y));
+
+        double headingError = remainder(fixedPosition.theta - exact.theta, 2*M_PI);
+        CHECK(fabs(headingError) < 1e-3, "run %d: heading error %f rad", run, headingError);
+    }
+
+    printf("Position error after %d s (mean / max over %d runs):\n", RUN_DURATION/1000, NUMBER_OF_RUNS);
+    printf("  float, int mm, %3d Hz : %8.2f / %8.2f mm\n", ODOMETRY_FREQUENCY, floatError.meanError, floatError.maxError);
+    printf("  fixed point,   %3d Hz : %8.3f / %8.3f mm\n", ODOMETRY_FREQUENCY, fixedError.meanError, fixedError.maxError);
+    printf("  fixed point,  %4d Hz : %8.3f / %8.3f mm\n", 1000/periodFast, fastError.meanError, fastError.maxError);
+    CHECK(fixedError.maxError < MAX_MAX_ERROR, "fixed point error %.3f mm", fixedError.maxError);
+    CHECK(fastError.maxError < MAX_MAX_ERROR, "fixed point error at 1 kHz %.3f mm", fastError.maxError);
+    CHECK(fixedError.maxError < floatError.meanError, "fixed point is not better than float");
+}
+
+
+/**
+ * @brief Time of one update, the host has a double FPU, the Cortex-M4 only a single one
+ */
+static void benchmarkThroughput(void){
+    wheelSpeed_t speed = {80, 95};
+    robotPosition_t floatPosition = {300, 400, 0};
+    odometryPose_t fixed = mod_odometry_fromRobotPosition(floatPosition);
+
+    double start = host_now();
+    for(int i = 0; i < NUMBER_OF_UPDATES; i++) floatPosition = floatIntegrate(&floatPosition, &speed, 5);
+    double floatTime = host_now() - start;
+
+    int32_t left = ODOMETRY_MM_TO_FIXED(speed.left*5/1000.0f);
+    int32_t right = ODOMETRY_MM_TO_FIXED(speed.right*5/1000.0f);
+    start = host_now();
+    for(int i = 0; i < NUMBER_OF_UPDATES; i++) mod_odometry_integrate(&fixed, left, right);
+    double fixedTime = host_now() - start;
+
+    // Keeps the loops from being removed
+    volatile int sink = floatPosition.x + fixed.x;
+    (void) sink;
+    printf("Update: float %.1f ns, fixed point %.1f ns (host)\n",
+           1e9*floatTime/NUMBER_OF_UPDATES, 1e9*fixedTime/NUMBER_OF_UPDATES);
+}
+
+
+int main(void){
+    benchmarkAccuracy();
+    benchmarkThroughput();
+    return host_result("bench_odometry");
+}
@@ -0,0 +1,244 @@
+/*
+ * File : bench_planner.c
+ * Project : e_puck_project
+ * Description : Host benchmark of mod_planner, first search (A* and D* Lite) and replanning after new obstacles
+ *               against a full search
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "host.h"
+#include "mod_planner.h"
+#include "mod_grid.h"
+#include "mod_pursuit.h"
+
+#define ARENA_WIDTH         600     // Arena from (0, 0) (in mm)
+#define ARENA_HEIGHT        800
+#define WALL_Y              400     // Inner wall from the left, the path goes through the gap on its right
+#define WALL_END_X          420
+#define OBJECT_RADIUS       15      // Obstacles seen on the way (in mm)
+#define MIN_OBJECT_DISTANCE 80      // Obstacles are not put on the robot nor on the goal (in mm)
+#define NUMBER_OF_TRIALS    300
+#define NUMBER_OF_SEARCHES  200     // Repetitions of the first search for the timing
+#define LENGTH_TOLERANCE    1.0     // Paths of the same cost can take other cells, their length is the same (in mm)
+#define SAMPLE_STEP         2       // Step of the check of the cells under a path (in mm)
+
+static const point_t start = {100, 100};
+static const point_t goal = {100, 700};
+
+
+static void markOccupied(int x, int y){
+    mod_grid_updateRay((point_t) {x, y}, (point_t) {x, y}, true);
+}
+
+
+/**
+ * @brief Walls of the arena and the inner wall, as the TOF hits them
+ */
+static void drawArena(void){
+    mod_grid_reset();
+    for(int x = 0; x <= ARENA_WIDTH; x += GRID_CELL_SIZE/2){
+        markOccupied(x, 0);
+        markOccupied(x, ARENA_HEIGHT);
+        if(x <= WALL_END_X) markOccupied(x, WALL_Y);
+    }
+    for(int y = 0; y <= ARENA_HEIGHT; y += GRID_CELL_SIZE/2){
+        markOccupied(0, y);
+        markOccupied(ARENA_WIDTH, y);
+    }
+}
+
+
+static void drawObject(point_t center, int radius){
+    for(int y = -radius; y <= radius; y += GRID_CELL_SIZE/2){
+        for(int x = -radius; x <= radius; x += GRID_CELL_SIZE/2){
+            if(x*x + y*y <= radius*radius) markOccupied(center.x + x, center.y + y);
+        }
+    }
+}
+
+
+static double pathLength(point_t from, const point_t * path, int number){
+    double length = 0;
+    for(int i = 0; i < number; i++){
+        point_t previous = (i == 0) ? from : path[i-1];
+        length += hypot(path[i].x - previous.x, path[i].y - previous.y);
+    }
+    return length;
+}
+
+
+/**
+ * @brief Returns the length of a path on the moves of the grid, the cost of the planners
+ * @note Paths of the same cost can turn at other cells, their euclidean length is not the same
+ */
+static double gridLength(point_t from, const point_t * path, int number){
+    double length = 0;
+    for(int i = 0; i < number; i++){
+        point_t previous = (i == 0) ? from : path[i-1];
+        double deltaX = fabs(path[i].x - previous.x);
+        double deltaY = fabs(path[i].y - previous.y);
+        length += fmax(deltaX, deltaY) + (M_SQRT2 - 1)*fmin(deltaX, deltaY);
+    }
+    return length;
+}
+
+
+/**
+ * @brief Returns a point of a path at a distance from its start
+ */
+static point_t pointAlong(point_t from, const point_t * path, int number, double distance){
+    for(int i = 0; i < number; i++){
+        point_t previous = (i == 0) ? from : path[i-1];
+        double length = hypot(path[i].x - previous.x, path[i].y - previous.y);
+        if(distance <= length && length > 0){
+            return (point_t) {lround(previous.x + (path[i].x - previous.x)*distance/length),
+                              lround(previous.y + (path[i].y - previous.y)*distance/length)};
+        }
+        distance -= length;
+    }
+    return path[number-1];
+}
+
+
+/**
+ * @brief Check that the center of the robot stays out of the obstacles grown by the robot size
+ */
+static bool isPathClear(point_t from, const point_t * path, int number){
+    double length = pathLength(from, path, number);
+    for(double distance = 0; distance <= length; distance += SAMPLE_STEP){
+        int column, row;
+        mod_grid_pointToCell(pointAlong(from, path, number, distance), &column, &row);
+        for(int deltaRow = -PLANNER_ROBOT_CELLS; deltaRow <= PLANNER_ROBOT_CELLS; deltaRow++){
+            for(int deltaColumn = -PLANNER_ROBOT_CELLS; deltaColumn <= PLANNER_ROBOT_CELLS; deltaColumn++){
+                if(deltaColumn*deltaColumn + deltaRow*deltaRow > PLANNER_ROBOT_CELLS*PLANNER_ROBOT_CELLS) continue;
+                if(mod_grid_getCellState(column + deltaColumn, row + deltaRow) == CELL_OCCUPIED) return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Time of the first search of goTo with A*, against the first search of D* Lite
+ */
+static void benchmarkFirstSearch(void){
+    point_t path[PURSUIT_MAX_POINTS], replanningPath[PURSUIT_MAX_POINTS];
+    int number = 0, replanningNumber = 0;
+    drawArena();
+
+    double begin = host_now();
+    for(int i = 0; i < NUMBER_OF_SEARCHES; i++){
+        number = mod_planner_findPath(start, goal, path, PURSUIT_MAX_POINTS);
+    }
+    double time = (host_now() - begin)/NUMBER_OF_SEARCHES;
+
+    begin = host_now();
+    for(int i = 0; i < NUMBER_OF_SEARCHES; i++){
+        mod_planner_startReplanning(start, goal);
+        replanningNumber = mod_planner_replan(start, replanningPath, PURSUIT_MAX_POINTS);
+    }
+    double replanningTime = (host_now() - begin)/NUMBER_OF_SEARCHES;
+
+    double length = pathLength(start, path, number);
+    printf("First search: %.1f mm in %d points, A* %.2f ms, D* Lite %.2f ms (host)\n", length, number,
+           1e3*time, 1e3*replanningTime);
+    CHECK(number > 0, "no path in the empty arena");
+    CHECK(number > 0 && isPathClear(start, path, number), "the first path hits an obstacle");
+    // The start and the goal are not at the centers of their cells, the cost of the first and last moves can change
+    double replanningLength = gridLength(start, replanningPath, replanningNumber);
+    CHECK(fabs(gridLength(start, path, number) - replanningLength) < GRID_CELL_SIZE,
+          "A* and D* Lite give paths of different costs: %.1f and %.1f mm", gridLength(start, path, number),
+          replanningLength);
+}
+
+
+/**
+ * @brief An obstacle appears on the path while the robot follows it, as in goTo
+ */
+static void benchmarkReplanning(void){
+    double obstaclesTime = 0, updateTime = 0, fullTime = 0;
+    int trials = 0, blockedTrials = 0, sameLength = 0, clear = 0;
+    int updates = 0;
+
+    while(trials < NUMBER_OF_TRIALS){
+        point_t path[PURSUIT_MAX_POINTS], fullPath[PURSUIT_MAX_POINTS];
+        drawArena();
+        mod_planner_startReplanning(start, goal);
+        int number = mod_planner_replan(start, path, PURSUIT_MAX_POINTS);
+        double length = pathLength(start, path, number);
+
+        // The robot did a part of the path and sees an obstacle further on it
+        point_t robot = pointAlong(start, path, number, host_random()*0.2*length);
+        point_t object = pointAlong(start, path, number, (0.3 + 0.6*host_random())*length);
+        object.x += (2*host_random() - 1)*OBJECT_RADIUS;
+        object.y += (2*host_random() - 1)*OBJECT_RADIUS;
+        if(hypot(object.x - robot.x, object.y - robot.y) < MIN_OBJECT_DISTANCE ||
+           hypot(object.x - goal.x, object.y - goal.y) < MIN_OBJECT_DISTANCE) continue;
+        drawObject(object, OBJECT_RADIUS);
+        trials++;
+
+        double begin = host_now();
+        bool isChanged = mod_planner_updateObstacles();
+        obstaclesTime += host_now() - begin;
+        number = mod_planner_replan(robot, path, PURSUIT_MAX_POINTS);
+        updateTime += host_now() - begin;
+        updates += isChanged;
+
+        begin = host_now();
+        mod_planner_startReplanning(robot, goal);
+        int fullNumber = mod_planner_replan(robot, fullPath, PURSUIT_MAX_POINTS);
+        fullTime += host_now() - begin;
+
+        if(fullNumber == 0){
+            blockedTrials++;
+            CHECK(number == 0, "trial %d: a path is found through the obstacle at (%d, %d)", trials, object.x, object.y);
+            continue;
+        }
+        double replannedLength = pathLength(robot, path, number);
+        double fullLength = pathLength(robot, fullPath, fullNumber);
+        sameLength += number > 0 && fabs(replannedLength - fullLength) < LENGTH_TOLERANCE;
+        clear += number > 0 && isPathClear(robot, path, number);
+    }
+
+    int found = trials - blockedTrials;
+    printf("%d obstacles on the path, %d changed the blocked cells, %d closed the gap:\n", trials, updates, blockedTrials);
+    printf("  update of the obstacles: %.3f ms, with the replanning: %.2f ms, full search: %.2f ms (host)\n",
+           1e3*obstaclesTime/trials, 1e3*updateTime/trials, 1e3*fullTime/trials);
+    printf("  %d/%d paths as short as the full search, %d/%d clear\n", sameLength, found, clear, found);
+    CHECK(updates == trials, "%d obstacles not seen by the update", trials - updates);
+    CHECK(sameLength == found, "%d replanned paths longer than the full search", found - sameLength);
+    CHECK(clear == found, "%d replanned paths hit an obstacle", found - clear);
+    CHECK(updateTime < fullTime, "replanning is not faster than a full search");
+}
+
+
+/**
+ * @brief The obstacles close every way to the goal, goTo must be told that there is no path
+ */
+static void testNoPath(void){
+    point_t path[PURSUIT_MAX_POINTS];
+    drawArena();
+    mod_planner_startReplanning(start, goal);
+    int number = mod_planner_replan(start, path, PURSUIT_MAX_POINTS);
+    CHECK(number > 0, "no path before closing the gap");
+
+    for(int x = WALL_END_X; x <= ARENA_WIDTH; x += GRID_CELL_SIZE/2) markOccupied(x, WALL_Y);
+    CHECK(mod_planner_updateObstacles(), "the closed gap is not seen");
+    number = mod_planner_replan(start, path, PURSUIT_MAX_POINTS);
+    CHECK(number == 0, "a path of %d points is found through the closed gap", number);
+
+    // Nothing changed, the planner does not search again
+    CHECK(!mod_planner_updateObstacles(), "an update without changes of the grid");
+}
+
+
+int main(void){
+    mod_grid_init();
+    mod_planner_setArea((point_t) {0, 0}, (point_t) {ARENA_WIDTH, ARENA_HEIGHT});
+    benchmarkFirstSearch();
+    benchmarkReplanning();
+    testNoPath();
+    return host_result("bench_planner");
+}
@@ -0,0 +1,172 @@
+/*
+ * File : bench_scanmatch.c
+ * Project : e_puck_project
+ * Description : Host replay of 360 deg sweeps through mod_scanmatch, compared with the expected pose corrections
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "host.h"
+#include "mod_scanmatch.h"
+#include "mod_grid.h"
+
+#include <string.h>
+
+#define SWEEPS_FILE             "data/sweeps.txt"
+#define TOF_RADIUS              33      // As in mod_mapping (in mm)
+#define NUMBER_OF_WALLS         4
+#define NUMBER_OF_REPLAYS       200     // Replays of the file for the timing
+#define MIN_CORRECTED_RATE      0.9f    // Sweeps that must be corrected (converged with enough inliers)
+#define MAX_POSITION_ERROR      10.0    // Max position error after a correction (in mm)
+#define MAX_ANGLE_ERROR         0.045   // Max heading error after a correction, a rigid correction cannot remove
+                                        // the 1 % scale error of the simulated rotation, 0.03 rad (in rad)
+#define MAX_LINE                128
+
+typedef struct {
+    int x0;
+    int x2;
+    int y1;
+    int y3;
+} walls_t;
+
+typedef struct {
+    double position;
+    double angle;
+} poseError_t;
+
+
+/**
+ * @brief The conversion of mod_mapping, from the pose of the odometry and the TOF value to a point
+ */
+static point_t measurementToPoint(const measurement_t * measurement){
+    point_t point;
+    point.x = -(measurement->value+TOF_RADIUS)*sin(measurement->position.theta)+measurement->position.x;
+    point.y = (measurement->value+TOF_RADIUS)*cos(measurement->position.theta)+measurement->position.y;
+    return point;
+}
+
+
+/**
+ * @brief Error between a pose and the true one
+ */
+static poseError_t poseError(double x, double y, double theta, const robotPosition_t * truth){
+    poseError_t error;
+    error.position = hypot(x - truth->x, y - truth->y);
+    error.angle = fabs(remainder(theta - truth->theta, 2*M_PI));
+    return error;
+}
+
+
+/**
+ * @brief Read the next sweep of the file and give its points to mod_scanmatch
+ *
+ * @param[out]      False at the end of the file
+ */
+static bool readSweep(FILE * file, walls_t * walls, robotPosition_t * truth, robotPosition_t * odometry){
+    char line[MAX_LINE];
+    bool inSweep = false;
+    mod_scanmatch_reset();
+    while(fgets(line, sizeof(line), file) != NULL){
+        if(line[0] == '#' || line[0] == '\n') continue;
+        float x, y, theta;
+        measurement_t measurement;
+        if(sscanf(line, "walls %d %d %d %d", &walls->x0, &walls->x2, &walls->y1, &walls->y3) == 4) continue;
+        if(sscanf(line, "sweep %f %f %f", &x, &y, &theta) == 3){
+            *truth = (robotPosition_t) {lroundf(x), lroundf(y), theta};
+            inSweep = true;
+            continue;
+        }
+        if(strncmp(line, "end", 3) == 0 && inSweep) return true;
+        if(sscanf(line, "%d %d %f %d", &measurement.position.x, &measurement.position.y,
+                  &measurement.position.theta, &measurement.value) != 4) continue;
+
+        // The pose of the sweep is the one of the odometry, as for mod_mapping_relocalize
+        *odometry = measurement.position;
+        if(measurement.value < 1 || measurement.value > GRID_MAX_RANGE) continue;
+        mod_scanmatch_addPoint(measurementToPoint(&measurement));
+    }
+    return false;
+}
+
+
+static scanMatch_t matchWalls(const walls_t * walls, robotPosition_t position){
+    line_t lines[NUMBER_OF_WALLS] = {{M_PI, -walls->x0, 0}, {0, walls->x2, 0}, {3*M_PI/2, -walls->y1, 0}, {M_PI/2, walls->y3, 0}};
+    return mod_scanmatch_match(lines, NUMBER_OF_WALLS, position);
+}
+
+
+static void replay(FILE * file){
+    int sweeps = 0;
+    int corrected = 0;
+    int iterations = 0;
+    poseError_t before = {0, 0};
+    poseError_t after = {0, 0};
+    poseError_t worst = {0, 0};
+    walls_t walls = {0, 0, 0, 0};
+    robotPosition_t truth, odometry;
+
+    while(readSweep(file, &walls, &truth, &odometry)){
+        sweeps++;
+        scanMatch_t match = matchWalls(&walls, odometry);
+        poseError_t error = poseError(odometry.x, odometry.y, odometry.theta, &truth);
+        before.position += error.position;
+        before.angle += error.angle;
+        if(!match.converged || match.inliers < SCANMATCH_MIN_INLIERS) continue;
+
+        corrected++;
+        iterations += match.iterations;
+        error = poseError(odometry.x + match.x, odometry.y + match.y, odometry.theta + match.theta, &truth);
+        after.position += error.position;
+        after.angle += error.angle;
+        if(error.position > worst.position) worst.position = error.position;
+        if(error.angle > worst.angle) worst.angle = error.angle;
+        CHECK(error.position < MAX_POSITION_ERROR && error.angle < MAX_ANGLE_ERROR,
+              "sweep %d: corrected pose is %.1f mm and %.3f rad away", sweeps, error.position, error.angle);
+    }
+    CHECK(sweeps > 0, "no sweep in " SWEEPS_FILE);
+    if(sweeps == 0 || corrected == 0) return;
+
+    float rate = (float) corrected/sweeps;
+    printf("%d sweeps, %.1f %% corrected in %.1f iterations\n", sweeps, 100*rate, (float) iterations/corrected);
+    printf("  odometry : %6.1f mm %6.3f rad (mean)\n", before.position/sweeps, before.angle/sweeps);
+    printf("  corrected: %6.1f mm %6.3f rad (mean), %.1f mm %.3f rad (max)\n",
+           after.position/corrected, after.angle/corrected, worst.position, worst.angle);
+    CHECK(rate >= MIN_CORRECTED_RATE, "%.1f %% of the sweeps corrected", 100*rate);
+    CHECK(after.position/corrected < before.position/(2*sweeps) && after.angle/corrected < before.angle/(2*sweeps),
+          "the corrections do not halve the error of the odometry");
+}
+
+
+/**
+ * @brief Time of one matching, the points are read again at each replay
+ */
+static void benchmark(FILE * file){
+    double time = 0;
+    int matches = 0;
+    walls_t walls;
+    robotPosition_t truth, odometry;
+
+    for(int i = 0; i < NUMBER_OF_REPLAYS; i++){
+        rewind(file);
+        while(readSweep(file, &walls, &truth, &odometry)){
+            double start = host_now();
+            volatile scanMatch_t match = matchWalls(&walls, odometry);
+            time += host_now() - start;
+            (void) match;
+            matches++;
+        }
+    }
+    if(matches) printf("Matching: %.1f us per sweep (host)\n", 1e6*time/matches);
+}
+
+
+int main(void){
+    FILE * file = fopen(SWEEPS_FILE, "r");
+    CHECK(file != NULL, "cannot open " SWEEPS_FILE);
+    if(file != NULL){
+        replay(file);
+        benchmark(file);
+        fclose(file);
+    }
+    return host_result("bench_scanmatch");
+}
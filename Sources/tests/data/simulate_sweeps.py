@@ -0,0 +1,85 @@
+# Python programm e-puck explorateur project
+# MICRO-315 | École Polytechnique Fédérale de Lausanne
+
+#writes the simulated sweeps replayed by bench_scanmatch, "python3 simulate_sweeps.py > sweeps.txt"
+#sweeps recorded on the robot use the same format:
+#   walls x0 x2 y1 y3               the walls known by the mapping (in mm)
+#   sweep x y theta                 the true pose of the robot at the end of the sweep, the expected result
+#                                   of the correction of the last pose given by the odometry
+#   x y theta value                 one measurement_t, the pose given by the odometry and the TOF value
+#   end
+
+import math
+import random
+
+#this script only needs Python 3
+
+NUMBER_OF_SWEEPS    = 60
+SAMPLES             = 110       #samples of one 360 deg sweep, the continuous rotation gives about this number
+TOF_RADIUS          = 33
+TOF_MAX             = 2000      #the TOF returns 0 after this distance
+NOISE               = 4         #standard deviation of the TOF noise (in mm)
+OUTLIERS            = 0.03      #probability of a wrong value
+MAX_OBJECTS         = 4
+OBJECT_RADIUS       = 20
+MAX_DRIFT           = 40        #max error of the odometry position (in mm)
+MAX_DRIFT_ANGLE     = 0.15      #max error of the odometry heading (in rad)
+MAX_SCALE_ERROR     = 0.01      #error of the odometry on the rotation of the sweep
+
+#distance along a ray to the first wall or object it hits
+def castRay(walls, objects, x, y, theta):
+    directionX = -math.sin(theta)
+    directionY = math.cos(theta)
+    nearest = 1e9
+    for (wall, start, direction) in ((walls[0], x, directionX), (walls[1], x, directionX),
+                                     (walls[2], y, directionY), (walls[3], y, directionY)):
+        if(abs(direction) > 1e-9):
+            distance = (wall - start) / direction
+            if(distance > 0):
+                nearest = min(nearest, distance)
+    for (objectX, objectY) in objects:
+        toX = objectX - x
+        toY = objectY - y
+        along = toX * directionX + toY * directionY
+        across = toX * directionY - toY * directionX
+        if(along > 0 and abs(across) < OBJECT_RADIUS):
+            nearest = min(nearest, along - math.sqrt(OBJECT_RADIUS**2 - across**2))
+    return nearest
+
+def main():
+    random.seed(2018)
+    print('# Simulated sweeps (simulate_sweeps.py), not recorded on the robot')
+    for i in range(NUMBER_OF_SWEEPS):
+        width = random.uniform(600, 1000)
+        height = random.uniform(600, 1200)
+        walls = (0, round(width), 0, round(height))
+        x = random.uniform(150, width - 150)
+        y = random.uniform(150, height - 150)
+        theta = random.uniform(0, 2 * math.pi)
+        objects = []
+        for j in range(random.randint(0, MAX_OBJECTS)):
+            objectX = random.uniform(60, width - 60)
+            objectY = random.uniform(60, height - 60)
+            if(math.hypot(objectX - x, objectY - y) > 100):
+                objects.append((objectX, objectY))
+
+        #the odometry drifted before the sweep, and its rotation is not exact during it
+        odometryX = round(x + random.uniform(-MAX_DRIFT, MAX_DRIFT))
+        odometryY = round(y + random.uniform(-MAX_DRIFT, MAX_DRIFT))
+        odometryTheta = theta + random.uniform(-MAX_DRIFT_ANGLE, MAX_DRIFT_ANGLE)
+        scale = 1 + random.uniform(-MAX_SCALE_ERROR, MAX_SCALE_ERROR)
+
+        lastRotation = 2 * math.pi * (SAMPLES - 1) / SAMPLES
+        print('walls %d %d %d %d' % walls)
+        print('sweep %.1f %.1f %.4f' % (x, y, theta + lastRotation))
+        for k in range(SAMPLES):
+            rotation = 2 * math.pi * k / SAMPLES
+            value = castRay(walls, objects, x, y, theta + rotation) - TOF_RADIUS + random.gauss(0, NOISE)
+            if(random.random() < OUTLIERS):
+                value = random.uniform(30, value)
+            if(value > TOF_MAX):
+                value = 0
+            print('%d %d %.4f %d' % (odometryX, odometryY, odometryTheta + scale * rotation, round(value)))
+        print('end')
+
+main()
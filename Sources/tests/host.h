@@ -0,0 +1,54 @@
+/*
+ * File : host.h
+ * Project : e_puck_project
+ * Description : Helpers of the host tests and benchmarks
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _HOST_
+#define _HOST_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/**
+ * @brief Returns a monotonic time (in s)
+ */
+static inline double host_now(void){
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec*1e-9;
+}
+
+/**
+ * @brief Returns a pseudo random number in [0, 1[, the same sequence at each run
+ */
+static inline float host_random(void){
+    static unsigned int state = 12345;
+    state = state*1103515245u + 12345u;
+    return (state >> 8)/16777216.0f;
+}
+
+/**
+ * @brief Count a check, print it if it fails
+ */
+#define CHECK(condition, ...)   do{ \
+        host_checks++; \
+        if(!(condition)){ host_failures++; printf("FAILED: " __VA_ARGS__); printf("\n"); } \
+    }while(0)
+
+static int host_checks = 0;
+static int host_failures = 0;
+
+/**
+ * @brief Print the result of the checks, returns the exit code of the test
+ */
+static inline int host_result(const char * name){
+    printf("%s: %d/%d checks passed\n", name, host_checks - host_failures, host_checks);
+    return host_failures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,26 @@
+/*
+ * File : arm_bitreversal.c
+ * Project : e_puck_project
+ * Description : Host version of the bit reversal of the CMSIS-DSP complex FFT, the library one is in Cortex-M assembly
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "arm_math.h"
+
+
+/**
+ * @brief Swap the complex values given by pairs of the table, as arm_bitreversal2.S does
+ */
+void arm_bitreversal_32(uint32_t * pSrc, const uint16_t bitRevLen, const uint16_t * pBitRevTab){
+    for(uint16_t i = 0; i < bitRevLen; i += 2){
+        uint32_t first = pBitRevTab[i] >> 2;
+        uint32_t second = pBitRevTab[i + 1] >> 2;
+        uint32_t temp = pSrc[first];
+        pSrc[first] = pSrc[second];
+        pSrc[second] = temp;
+        temp = pSrc[first + 1];
+        pSrc[first + 1] = pSrc[second + 1];
+        pSrc[second + 1] = temp;
+    }
+}
@@ -0,0 +1,72 @@
+/*
+ * File : arm_math.h
+ * Project : e_puck_project
+ * Description : Host version of the parts of CMSIS-DSP used by the tested modules, the Cortex-M
+ *               one needs the core intrinsics. The sources of the library are built as they are
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _HOST_ARM_MATH_
+#define _HOST_ARM_MATH_
+
+#include <stdint.h>
+#include <math.h>
+
+#define PI                      3.14159265358979f
+#define FAST_MATH_TABLE_SIZE    512
+#define CONTROLLER_Q31_SHIFT    (32 - 9)
+#define ALIGN4                  __attribute__((aligned(4)))
+
+typedef int8_t q7_t;
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+typedef int64_t q63_t;
+typedef float float32_t;
+
+static inline q31_t clip_q63_to_q31(q63_t x){
+    return ((q31_t)(x >> 32) != ((q31_t)x >> 31)) ? ((0x7FFFFFFF ^ ((q31_t)(x >> 63)))) : (q31_t)x;
+}
+
+typedef enum {
+    ARM_MATH_SUCCESS = 0,
+    ARM_MATH_ARGUMENT_ERROR = -1,
+    ARM_MATH_LENGTH_ERROR = -2
+} arm_status;
+
+typedef struct {
+    uint16_t fftLen;
+    const float32_t * pTwiddle;
+    const uint16_t * pBitRevTable;
+    uint16_t bitRevLength;
+} arm_cfft_instance_f32;
+
+typedef struct {
+    arm_cfft_instance_f32 Sint;
+    uint16_t fftLenRFFT;
+    float32_t * pTwiddleRFFT;
+} arm_rfft_fast_instance_f32;
+
+static inline arm_status arm_sqrt_f32(float32_t in, float32_t * pOut){
+    *pOut = (in >= 0.0f) ? sqrtf(in) : 0.0f;
+    return (in >= 0.0f) ? ARM_MATH_SUCCESS : ARM_MATH_ARGUMENT_ERROR;
+}
+
+void arm_sin_cos_q31(q31_t theta, q31_t * pSinVal, q31_t * pCosVal);
+float32_t arm_sin_f32(float32_t x);
+float32_t arm_cos_f32(float32_t x);
+
+void arm_cmplx_mag_squared_f32(float32_t * pSrc, float32_t * pDst, uint32_t numSamples);
+void arm_cmplx_conj_f32(float32_t * pSrc, float32_t * pDst, uint32_t numSamples);
+void arm_cmplx_mag_f32(float32_t * pSrc, float32_t * pDst, uint32_t numSamples);
+void arm_cmplx_mult_cmplx_f32(float32_t * pSrcA, float32_t * pSrcB, float32_t * pDst, uint32_t numSamples);
+void arm_fill_f32(float32_t value, float32_t * pDst, uint32_t blockSize);
+void arm_max_f32(float32_t * pSrc, uint32_t blockSize, float32_t * pResult, uint32_t * pIndex);
+void arm_power_f32(float32_t * pSrc, uint32_t blockSize, float32_t * pResult);
+
+void arm_cfft_f32(const arm_cfft_instance_f32 * S, float32_t * p1, uint8_t ifftFlag, uint8_t bitReverseFlag);
+arm_status arm_rfft_fast_init_f32(arm_rfft_fast_instance_f32 * S, uint16_t fftLen);
+void arm_rfft_fast_f32(arm_rfft_fast_instance_f32 * S, float32_t * p, float32_t * pOut, uint8_t ifftFlag);
+
+#endif
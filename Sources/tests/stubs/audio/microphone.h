@@ -0,0 +1,19 @@
+/*
+ * File : microphone.h
+ * Project : e_puck_project
+ * Description : Host version of the microphones driver of the e-puck library, the test gives the buffers itself
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _HOST_MICROPHONE_
+#define _HOST_MICROPHONE_
+
+#include <stdint.h>
+
+typedef void (*mp45dt02FullBufferCb)(int16_t * data, uint16_t length);
+
+void mic_start(mp45dt02FullBufferCb customFullbufferCb);
+
+#endif
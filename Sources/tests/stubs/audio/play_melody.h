@@ -0,0 +1,26 @@
+/*
+ * File : play_melody.h
+ * Project : e_puck_project
+ * Description : Host version of the melody player of the e-puck library, the test defines the functions
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _HOST_PLAY_MELODY_
+#define _HOST_PLAY_MELODY_
+
+typedef enum{
+    MARIO = 0,
+    UNDERWORLD,
+    STARWARS,
+    ALERT,
+    NB_SONGS
+} song_selection_t;
+
+void play_melody_start(void);
+void play_melody(song_selection_t choice);
+void stop_current_melody(void);
+void wait_until_melody_end(void);
+
+#endif
@@ -0,0 +1,55 @@
+/*
+ * File : ch.h
+ * Project : e_puck_project
+ * Description : Host version of the parts of ChibiOS used by the tested modules, threads never run
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _HOST_CH_
+#define _HOST_CH_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define CH_CFG_ST_FREQUENCY     1000
+#define MS2ST(ms)               ((systime_t)(ms))
+#define ST2MS(ticks)            ((uint32_t)(ticks))
+#define NORMALPRIO              64
+#define TRUE                    true
+#define FALSE                   false
+
+typedef uint32_t systime_t;
+typedef int32_t msg_t;
+typedef int tprio_t;
+typedef struct { int locked; } mutex_t;
+typedef struct { int waiting; } condition_variable_t;
+typedef struct { int count; } binary_semaphore_t;
+typedef struct { int unused; } thread_t;
+
+#define THD_WORKING_AREA(name, size)    char name[size]
+#define THD_FUNCTION(name, arg)         void name(void * arg)
+#define MUTEX_DECL(name)                mutex_t name = {0}
+#define CONDVAR_DECL(name)              condition_variable_t name = {0}
+#define BSEMAPHORE_DECL(name, taken)    binary_semaphore_t name = {taken}
+
+static inline thread_t * chThdCreateStatic(void * workingArea, size_t size, tprio_t priority,
+                                           void (*function)(void *), void * arg){
+    (void) workingArea; (void) size; (void) priority; (void) function; (void) arg;
+    return NULL;
+}
+
+static inline systime_t chVTGetSystemTime(void){ return 0; }
+static inline void chThdSleepUntil(systime_t time){ (void) time; }
+static inline void chThdSleepMilliseconds(uint32_t time){ (void) time; }
+static inline void chMtxLock(mutex_t * mutex){ mutex->locked = 1; }
+static inline void chMtxUnlock(mutex_t * mutex){ mutex->locked = 0; }
+static inline void chBSemSignal(binary_semaphore_t * semaphore){ semaphore->count = 0; }
+static inline void chBSemReset(binary_semaphore_t * semaphore, bool taken){ semaphore->count = taken; }
+static inline msg_t chBSemWait(binary_semaphore_t * semaphore){ semaphore->count = 1; return 0; }
+static inline void chSysLock(void){}
+static inline void chSysUnlock(void){}
+
+#endif
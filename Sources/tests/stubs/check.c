@@ -0,0 +1,19 @@
+/*
+ * File : check.c
+ * Project : e_puck_project
+ * Description : Host version of mod_check, a failed assert stops the test
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mod_check.h"
+
+void assert(_Bool condition){
+    if(!condition){
+        fprintf(stderr, "assert failed\n");
+        exit(1);
+    }
+}
@@ -0,0 +1,17 @@
+/*
+ * File : main.h
+ * Project : e_puck_project
+ * Description : Host version of main.h, the test defines the bus
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _HOST_MAIN_
+#define _HOST_MAIN_
+
+#include "msgbus/messagebus.h"
+
+extern messagebus_t bus;
+
+#endif
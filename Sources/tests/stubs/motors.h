@@ -0,0 +1,18 @@
+/*
+ * File : motors.h
+ * Project : e_puck_project
+ * Description : Host version of the motors driver of the e-puck library, the wheels never move
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _HOST_MOTORS_
+#define _HOST_MOTORS_
+
+#include <stdint.h>
+
+static inline int32_t left_motor_get_pos(void){ return 0; }
+static inline int32_t right_motor_get_pos(void){ return 0; }
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * File : messagebus.h
+ * Project : e_puck_project
+ * Description : Host version of the message bus of the e-puck library, nothing is published
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+
+#ifndef _HOST_MESSAGEBUS_
+#define _HOST_MESSAGEBUS_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <ch.h>
+
+typedef struct { int unused; } messagebus_t;
+typedef struct { void * buffer; } messagebus_topic_t;
+
+static inline void messagebus_topic_init(messagebus_topic_t * topic, mutex_t * lock, condition_variable_t * condvar,
+                                         void * buffer, size_t size){
+    (void) lock; (void) condvar; (void) size;
+    topic->buffer = buffer;
+}
+static inline void messagebus_advertise_topic(messagebus_t * bus, messagebus_topic_t * topic, const char * name){
+    (void) bus; (void) topic; (void) name;
+}
+static inline void messagebus_topic_publish(messagebus_topic_t * topic, void * message, size_t size){
+    (void) topic; (void) message; (void) size;
+}
+
+#endif
@@ -0,0 +1,380 @@
+/*
+ * File : test_compression.c
+ * Project : e_puck_project
+ * Description : Host test of mod_compression on synthetic pictures, decoded as pythonReception.py does
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "host.h"
+#include "mod_compression.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define NUMBER_OF_PIXELS        (IMAGE_WIDTH*IMAGE_HEIGHT)
+#define CHROMA_WIDTH            (IMAGE_WIDTH/2)
+#define CHROMA_HEIGHT           (IMAGE_HEIGHT/2)
+#define BLOCKS_ALONG(size)      (((size) + 7)/8)
+#define GUARD_SIZE              64      // Bytes after the output that the compression must not touch
+#define GUARD_VALUE             0xA5
+#define NUMBER_OF_SCENES        20      // Random pictures of each kind
+#define NUMBER_OF_RUNS          50      // Repetitions for the timing
+
+#define MIN_PSNR                27.0    // Of the lossy codec against the picture on 8 bits, the chroma at half
+                                        // resolution blurs the edges of the saturated objects (in dB)
+#define MAX_LOSSLESS_RATIO      0.7     // Of IMAGE_SIZE, on the pictures of the camera without noise
+
+typedef enum{
+    SCENE_GRADIENT = 0,     // Smooth light on a wall
+    SCENE_OBJECTS,          // Flat colors of the arena and of the objects
+    SCENE_NOISY,            // The objects with the noise of the sensor
+    SCENE_RANDOM,           // Uniform random pixels, the worst case
+    NUMBER_OF_KINDS
+}scene_t;
+
+static const char * sceneNames[NUMBER_OF_KINDS] = {"gradient", "objects", "objects and noise", "random"};
+
+// Tables of the lossy codec, as in pythonReception.py
+static const int lumaBase[64] = {
+    16, 11, 10, 16, 24, 40, 51, 61,     12, 12, 14, 19, 26, 58, 60, 55,
+    14, 13, 16, 24, 40, 57, 69, 56,     14, 17, 22, 29, 51, 87, 80, 62,
+    18, 22, 37, 56, 68,109,103, 77,     24, 35, 55, 64, 81,104,113, 92,
+    49, 64, 78, 87,103,121,120,101,     72, 92, 95, 98,112,100,103, 99
+};
+static const int chromaBase[64] = {
+    17, 18, 24, 47, 99, 99, 99, 99,     18, 21, 26, 66, 99, 99, 99, 99,
+    24, 26, 56, 99, 99, 99, 99, 99,     47, 66, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,     99, 99, 99, 99, 99, 99, 99, 99,
+    99, 99, 99, 99, 99, 99, 99, 99,     99, 99, 99, 99, 99, 99, 99, 99
+};
+static const int zigzag[64] = {
+     0,  1,  8, 16,  9,  2,  3, 10,     17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,     27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,     29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,     53, 60, 61, 54, 47, 55, 62, 63
+};
+
+/**
+ * @brief Reads the Exp-Golomb codes, most significant bit first
+ */
+typedef struct{
+    const uint8_t * data;
+    size_t size;
+    size_t position;        // (in bits)
+    bool error;             // A code goes after the end of the data
+}bitReader_t;
+
+static uint8_t image[IMAGE_SIZE];
+static uint8_t output[IMAGE_SIZE + GUARD_SIZE];
+static uint16_t decoded[NUMBER_OF_PIXELS];
+static uint8_t decodedRGB[NUMBER_OF_PIXELS][3];
+
+
+static void setPixel(int x, int y, uint16_t pixel){
+    image[2*(y*IMAGE_WIDTH + x)] = pixel >> 8;
+    image[2*(y*IMAGE_WIDTH + x) + 1] = pixel & 0xFF;
+}
+
+
+static uint16_t getPixel(int x, int y){
+    return (uint16_t) (image[2*(y*IMAGE_WIDTH + x)] << 8 | image[2*(y*IMAGE_WIDTH + x) + 1]);
+}
+
+
+static uint16_t toRGB565(int red, int green, int blue){
+    red = (red < 0) ? 0 : (red > 31) ? 31 : red;
+    green = (green < 0) ? 0 : (green > 63) ? 63 : green;
+    blue = (blue < 0) ? 0 : (blue > 31) ? 31 : blue;
+    return (uint16_t) (red << 11 | green << 5 | blue);
+}
+
+
+/**
+ * @brief Draw a picture of a kind, the objects are at random places
+ */
+static void drawScene(scene_t kind){
+    float angle = host_random()*2*M_PI;
+    int numberOfObjects = 1 + host_random()*3;
+    int objectX[3], objectY[3], objectSize[3];
+    uint16_t objectColor[3];
+    for(int i = 0; i < numberOfObjects; i++){
+        objectX[i] = host_random()*IMAGE_WIDTH;
+        objectY[i] = host_random()*IMAGE_HEIGHT;
+        objectSize[i] = 8 + host_random()*25;
+        objectColor[i] = toRGB565(host_random()*32, host_random()*64, host_random()*32);
+    }
+
+    for(int y = 0; y < IMAGE_HEIGHT; y++){
+        for(int x = 0; x < IMAGE_WIDTH; x++){
+            if(kind == SCENE_RANDOM){
+                setPixel(x, y, host_random()*65536);
+                continue;
+            }
+            if(kind == SCENE_GRADIENT){
+                float light = 0.5f + 0.4f*sinf((x*cosf(angle) + y*sinf(angle))/40);
+                setPixel(x, y, toRGB565(light*28, light*60, 6 + light*20));
+                continue;
+            }
+
+            // The floor under the walls, the objects on top of them
+            uint16_t pixel = (y < IMAGE_HEIGHT/3) ? toRGB565(26, 54, 24) : toRGB565(12, 26, 10);
+            for(int i = 0; i < numberOfObjects; i++){
+                if(abs(x - objectX[i]) < objectSize[i]/2 && abs(y - objectY[i]) < objectSize[i]) pixel = objectColor[i];
+            }
+            if(kind == SCENE_NOISY){
+                int noise = host_random()*3 - 1;
+                pixel = toRGB565((pixel >> 11) + noise, ((pixel >> 5) & 0x3F) + 2*noise, (pixel & 0x1F) + noise);
+            }
+            setPixel(x, y, pixel);
+        }
+    }
+}
+
+
+/**
+ * @brief Decode the lossless codec as decodeLossless of pythonReception.py
+ *
+ * @param[out]      False if the data is not a complete picture
+ */
+static bool decodeLossless(const uint8_t * data, size_t size){
+    uint16_t cache[64] = {0};
+    uint16_t previous = 0;
+    int number = 0;
+    size_t i = 0;
+    while(i < size && number < NUMBER_OF_PIXELS){
+        uint8_t tag = data[i++];
+        int red = previous >> 11, green = (previous >> 5) & 0x3F, blue = previous & 0x1F;
+        uint16_t pixel;
+        if(tag == 0xFE){
+            if(i + 2 > size) return false;
+            pixel = (uint16_t) (data[i] << 8 | data[i + 1]);
+            i += 2;
+        }
+        else if(tag >= 0xC0){
+            for(int run = 0; run <= (tag & 0x3F) && number < NUMBER_OF_PIXELS; run++) decoded[number++] = previous;
+            continue;
+        }
+        else if(tag < 0x40){
+            pixel = cache[tag];
+        }
+        else if(tag < 0x80){
+            red = (red + ((tag >> 4) & 3) - 2) & 0x1F;
+            green = (green + ((tag >> 2) & 3) - 2) & 0x3F;
+            blue = (blue + (tag & 3) - 2) & 0x1F;
+            pixel = (uint16_t) (red << 11 | green << 5 | blue);
+        }
+        else{
+            if(i + 1 > size) return false;
+            int dGreen = (tag & 0x3F) - 32;
+            red = (red + dGreen + (data[i] >> 4) - 8) & 0x1F;
+            green = (green + dGreen) & 0x3F;
+            blue = (blue + dGreen + (data[i] & 0x0F) - 8) & 0x1F;
+            i++;
+            pixel = (uint16_t) (red << 11 | green << 5 | blue);
+        }
+        cache[(3*(pixel >> 11) + 5*((pixel >> 5) & 0x3F) + 7*(pixel & 0x1F)) % 64] = pixel;
+        decoded[number++] = pixel;
+        previous = pixel;
+    }
+    return number == NUMBER_OF_PIXELS && i == size;
+}
+
+
+static int readBit(bitReader_t * reader){
+    if(reader->position >= 8*reader->size){
+        reader->error = true;
+        return 1;
+    }
+    int bit = (reader->data[reader->position/8] >> (7 - reader->position%8)) & 1;
+    reader->position++;
+    return bit;
+}
+
+
+static int readUnsigned(bitReader_t * reader){
+    int zeros = 0;
+    while(!reader->error && readBit(reader) == 0) zeros++;
+    int code = 1;
+    for(int i = 0; i < zeros && !reader->error; i++) code = (code << 1) | readBit(reader);
+    return code - 1;
+}
+
+
+static int readSigned(bitReader_t * reader){
+    int value = readUnsigned(reader);
+    return (value % 2) ? (value + 1)/2 : -(value/2);
+}
+
+
+/**
+ * @brief Decode a plane of the lossy codec as decodePlane of pythonReception.py
+ */
+static bool decodePlane(bitReader_t * reader, int width, int height, const double * quant, double * plane){
+    double dct[8][8];
+    for(int u = 0; u < 8; u++){
+        for(int x = 0; x < 8; x++) dct[u][x] = ((u == 0) ? sqrt(1.0/8) : sqrt(2.0/8))*cos((2*x + 1)*u*M_PI/16);
+    }
+
+    int previousDC = 0;
+    for(int blockY = 0; blockY < BLOCKS_ALONG(height); blockY++){
+        for(int blockX = 0; blockX < BLOCKS_ALONG(width); blockX++){
+            double coefficients[64] = {0};
+            previousDC += readSigned(reader);
+            coefficients[0] = previousDC*quant[0];
+            int i = 1;
+            while(!reader->error){
+                int zeros = readUnsigned(reader);
+                int value = readSigned(reader);
+                if(value == 0) break;
+                i += zeros;
+                if(i >= 64) return false;
+                coefficients[zigzag[i]] = value*quant[zigzag[i]];
+                i++;
+            }
+            if(reader->error) return false;
+
+            // Inverse DCT, the pixels after the borders are dropped
+            for(int row = 0; row < 8; row++){
+                for(int column = 0; column < 8; column++){
+                    int x = blockX*8 + column, y = blockY*8 + row;
+                    if(x >= width || y >= height) continue;
+                    double sum = 0;
+                    for(int u = 0; u < 8; u++){
+                        for(int v = 0; v < 8; v++) sum += dct[u][row]*coefficients[u*8 + v]*dct[v][column];
+                    }
+                    plane[y*width + x] = sum;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief Decode the lossy codec as decodeLossy of pythonReception.py, in decodedRGB
+ */
+static bool decodeLossy(const uint8_t * data, size_t size){
+    static double luma[NUMBER_OF_PIXELS], cb[NUMBER_OF_PIXELS/4], cr[NUMBER_OF_PIXELS/4];
+    double lumaQuant[64], chromaQuant[64];
+    int quality = data[0];
+    int scale = (quality < 50) ? 5000/quality : 200 - 2*quality;
+    for(int i = 0; i < 64; i++){
+        lumaQuant[i] = fmin(fmax((lumaBase[i]*scale + 50)/100, 1), 255);
+        chromaQuant[i] = fmin(fmax((chromaBase[i]*scale + 50)/100, 1), 255);
+    }
+
+    bitReader_t reader = {data + 1, size - 1, 0, false};
+    if(!decodePlane(&reader, IMAGE_WIDTH, IMAGE_HEIGHT, lumaQuant, luma) ||
+       !decodePlane(&reader, CHROMA_WIDTH, CHROMA_HEIGHT, chromaQuant, cb) ||
+       !decodePlane(&reader, CHROMA_WIDTH, CHROMA_HEIGHT, chromaQuant, cr)) return false;
+
+    for(int y = 0; y < IMAGE_HEIGHT; y++){
+        for(int x = 0; x < IMAGE_WIDTH; x++){
+            double l = luma[y*IMAGE_WIDTH + x] + 128;
+            double b = cb[(y/2)*CHROMA_WIDTH + x/2], r = cr[(y/2)*CHROMA_WIDTH + x/2];
+            double channels[3] = {l + 1.402*r, l - 0.344136*b - 0.714136*r, l + 1.772*b};
+            for(int c = 0; c < 3; c++) decodedRGB[y*IMAGE_WIDTH + x][c] = fmin(fmax(round(channels[c]), 0), 255);
+        }
+    }
+    return true;
+}
+
+
+/**
+ * @brief PSNR of the decoded picture against the picture on 8 bits, as rgb565ToRGB of pythonReception.py
+ */
+static double computePSNR(void){
+    double error = 0;
+    for(int y = 0; y < IMAGE_HEIGHT; y++){
+        for(int x = 0; x < IMAGE_WIDTH; x++){
+            uint16_t pixel = getPixel(x, y);
+            int channels[3] = {(pixel >> 11)*255/31, ((pixel >> 5) & 0x3F)*255/63, (pixel & 0x1F)*255/31};
+            for(int c = 0; c < 3; c++){
+                double difference = channels[c] - decodedRGB[y*IMAGE_WIDTH + x][c];
+                error += difference*difference;
+            }
+        }
+    }
+    error /= 3*NUMBER_OF_PIXELS;
+    return (error == 0) ? 99 : 10*log10(255.0*255.0/error);
+}
+
+
+/**
+ * @brief Compress in a buffer of IMAGE_SIZE bytes as mod_image does, nothing must be written after it
+ */
+static size_t compress(imageCodec_t codec){
+    memset(output, GUARD_VALUE, sizeof(output));
+    size_t size = mod_compress_image(codec, image, output, IMAGE_SIZE);
+    bool isGuardIntact = true;
+    for(int i = IMAGE_SIZE; i < IMAGE_SIZE + GUARD_SIZE; i++) isGuardIntact &= output[i] == GUARD_VALUE;
+    CHECK(isGuardIntact, "codec %d writes after the end of the output", codec);
+    CHECK(size <= IMAGE_SIZE, "codec %d returns %zu bytes", codec, size);
+    return size;
+}
+
+
+static void testScenes(scene_t kind){
+    double losslessSize = 0, lossySize = 0, minPSNR = 99;
+    int notFitting = 0, wrong = 0;
+
+    for(int scene = 0; scene < NUMBER_OF_SCENES; scene++){
+        drawScene(kind);
+
+        size_t size = compress(CODEC_LOSSLESS);
+        if(size == 0) notFitting++;
+        else{
+            losslessSize += (double) size/NUMBER_OF_SCENES;
+            bool isExact = decodeLossless(output, size);
+            for(int i = 0; i < NUMBER_OF_PIXELS && isExact; i++){
+                isExact = decoded[i] == getPixel(i % IMAGE_WIDTH, i / IMAGE_WIDTH);
+            }
+            wrong += !isExact;
+        }
+
+        size = compress(CODEC_LOSSY);
+        if(size == 0) notFitting++;
+        else{
+            lossySize += (double) size/NUMBER_OF_SCENES;
+            if(decodeLossy(output, size)) minPSNR = fmin(minPSNR, computePSNR());
+            else wrong++;
+        }
+    }
+
+    printf("  %-18s: lossless %5.0f bytes, lossy %5.0f bytes (PSNR %.1f dB min), %d not fitting\n",
+           sceneNames[kind], losslessSize, lossySize, minPSNR, notFitting);
+    CHECK(wrong == 0, "%s: %d pictures not decoded exactly", sceneNames[kind], wrong);
+    if(kind == SCENE_RANDOM){
+        // 3 bytes per pixel for the lossless codec, the raw picture is sent
+        CHECK(notFitting >= NUMBER_OF_SCENES, "%s: the lossless codec fits in the output", sceneNames[kind]);
+        return;
+    }
+    CHECK(notFitting == 0, "%s: %d pictures do not fit in IMAGE_SIZE", sceneNames[kind], notFitting);
+    CHECK(minPSNR >= MIN_PSNR, "%s: PSNR of %.1f dB", sceneNames[kind], minPSNR);
+    if(kind != SCENE_NOISY){
+        CHECK(losslessSize < MAX_LOSSLESS_RATIO*IMAGE_SIZE, "%s: lossless picture of %.0f bytes",
+              sceneNames[kind], losslessSize);
+    }
+}
+
+
+static void benchmarkCompression(void){
+    drawScene(SCENE_NOISY);
+    for(imageCodec_t codec = CODEC_LOSSLESS; codec <= CODEC_LOSSY; codec++){
+        double begin = host_now();
+        for(int i = 0; i < NUMBER_OF_RUNS; i++) (void)mod_compress_image(codec, image, output, IMAGE_SIZE);
+        printf("  codec %d: %.2f ms per picture (host)\n", codec, 1e3*(host_now() - begin)/NUMBER_OF_RUNS);
+    }
+}
+
+
+int main(void){
+    mod_compress_init();
+    printf("Pictures of %d bytes (mean size of %d pictures):\n", IMAGE_SIZE, NUMBER_OF_SCENES);
+    for(scene_t kind = SCENE_GRADIENT; kind < NUMBER_OF_KINDS; kind++) testScenes(kind);
+    benchmarkCompression();
+    return host_result("test_compression");
+}
@@ -0,0 +1,162 @@
+/*
+ * File : test_frontier.c
+ * Project : e_puck_project
+ * Description : Host test of the frontiers updated from the changed blocks of the grid, against a full update
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "host.h"
+#include "mod_frontier.h"
+#include "mod_grid.h"
+#include "mod_planner.h"
+#include "mod_log.h"
+
+#define AREA_SIZE           800     // Side of the square arena, from (0, 0) (in mm)
+#define NUMBER_OF_OBJECTS   6
+#define OBJECT_RADIUS       25      // (in mm)
+#define NUMBER_OF_STOPS     40      // Positions of the robot
+#define BATCHES_PER_STOP    8
+#define SAMPLES_PER_BATCH   6       // TOF samples of one replanning period of goTo
+#define OLD_CHANGES_SIZE    256     // Size of the list of changed cells before the blocks
+
+static point_t objects[NUMBER_OF_OBJECTS];
+static cellState_t states[GRID_ROWS][GRID_COLUMNS];
+
+
+void mod_log_write(logFormat_t format, const uint32_t * args, int numberOfArgs, uint8_t floatArgs){
+}
+
+
+/**
+ * @brief Distance along a ray to the first wall or object it hits
+ */
+static float castRay(point_t origin, float angle){
+    float directionX = cosf(angle), directionY = sinf(angle);
+    float nearest = 1e9f;
+    float walls[4] = {0, AREA_SIZE, 0, AREA_SIZE};
+    for(int i = 0; i < 4; i++){
+        float direction = (i < 2) ? directionX : directionY;
+        float start = (i < 2) ? origin.x : origin.y;
+        if(fabsf(direction) < 1e-6f) continue;
+        float distance = (walls[i] - start)/direction;
+        if(distance > 0 && distance < nearest) nearest = distance;
+    }
+    for(int i = 0; i < NUMBER_OF_OBJECTS; i++){
+        float toX = objects[i].x - origin.x, toY = objects[i].y - origin.y;
+        float along = toX*directionX + toY*directionY;
+        float across = toX*directionY - toY*directionX;
+        if(along > 0 && fabsf(across) < OBJECT_RADIUS){
+            float distance = along - sqrtf(OBJECT_RADIUS*OBJECT_RADIUS - across*across);
+            if(distance < nearest) nearest = distance;
+        }
+    }
+    return nearest;
+}
+
+
+/**
+ * @brief Add the rays of a batch as mod_mapping_addMeasurement does
+ *
+ * @param[out]      The number of cells whose state changed
+ */
+static int addBatch(point_t origin){
+    for(int i = 0; i < SAMPLES_PER_BATCH; i++){
+        float angle = host_random()*2*M_PI;
+        float distance = castRay(origin, angle);
+        bool hit = distance <= GRID_MAX_RANGE;
+        if(!hit) distance = GRID_MAX_RANGE;
+        point_t end = {lroundf(origin.x + distance*cosf(angle)), lroundf(origin.y + distance*sinf(angle))};
+        mod_grid_updateRay(origin, end, hit);
+    }
+
+    int changes = 0;
+    for(int row = 0; row < GRID_ROWS; row++){
+        for(int column = 0; column < GRID_COLUMNS; column++){
+            cellState_t state = mod_grid_getCellState(column, row);
+            changes += state != states[row][column];
+            states[row][column] = state;
+        }
+    }
+    return changes;
+}
+
+
+static float countCoverage(int minColumn, int minRow, int maxColumn, int maxRow){
+    int known = 0;
+    for(int row = minRow; row <= maxRow; row++){
+        for(int column = minColumn; column <= maxColumn; column++){
+            known += mod_grid_getCellState(column, row) != CELL_UNKNOWN;
+        }
+    }
+    return (float) known/((maxColumn - minColumn + 1)*(maxRow - minRow + 1));
+}
+
+
+static bool isClear(point_t goal){
+    int column, row;
+    mod_grid_pointToCell(goal, &column, &row);
+    for(int deltaRow = -PLANNER_ROBOT_CELLS; deltaRow <= PLANNER_ROBOT_CELLS; deltaRow++){
+        for(int deltaColumn = -PLANNER_ROBOT_CELLS; deltaColumn <= PLANNER_ROBOT_CELLS; deltaColumn++){
+            if(mod_grid_getCellState(column + deltaColumn, row + deltaRow) == CELL_OCCUPIED) return false;
+        }
+    }
+    return true;
+}
+
+
+int main(void){
+    point_t min = {0, 0}, max = {AREA_SIZE, AREA_SIZE};
+    int minColumn, minRow, maxColumn, maxRow;
+    mod_grid_pointToCell(min, &minColumn, &minRow);
+    mod_grid_pointToCell(max, &maxColumn, &maxRow);
+
+    for(int i = 0; i < NUMBER_OF_OBJECTS; i++){
+        objects[i] = (point_t) {100 + (int)(host_random()*(AREA_SIZE - 200)), 100 + (int)(host_random()*(AREA_SIZE - 200))};
+    }
+    mod_grid_init();
+    mod_frontier_setArea(min, max);
+
+    int batches = 0, overflows = 0, maxChanges = 0, goals = 0, stopOverflows = 0;
+    double time = 0;
+    point_t robot = {AREA_SIZE/2, AREA_SIZE/2};
+    for(int stop = 0; stop < NUMBER_OF_STOPS; stop++){
+        int stopChanges = 0;
+        for(int i = 0; i < BATCHES_PER_STOP; i++){
+            int changes = addBatch(robot);
+            stopChanges += changes;
+            batches++;
+            overflows += changes > OLD_CHANGES_SIZE;
+            if(changes > maxChanges) maxChanges = changes;
+
+            double start = host_now();
+            mod_frontier_update();
+            time += host_now() - start;
+        }
+        // The list was only taken once per scan
+        stopOverflows += stopChanges > OLD_CHANGES_SIZE;
+        float coverage = mod_frontier_getCoverage();
+        float expected = countCoverage(minColumn, minRow, maxColumn, maxRow);
+        CHECK(fabsf(coverage - expected) < 1e-6f, "stop %d: coverage %f instead of %f", stop, coverage, expected);
+
+        // The goal from the updated frontiers is the one found after computing all of them again
+        point_t goal, fullGoal;
+        bool isFound = mod_frontier_selectGoal(robot, &goal);
+        mod_frontier_setArea(min, max);
+        bool isFullFound = mod_frontier_selectGoal(robot, &fullGoal);
+        mod_frontier_setArea(min, max);
+        CHECK(isFound == isFullFound && (!isFound || (goal.x == fullGoal.x && goal.y == fullGoal.y)),
+              "stop %d: goal (%d, %d) instead of (%d, %d)", stop, goal.x, goal.y, fullGoal.x, fullGoal.y);
+        if(!isFound) break;
+        CHECK(isClear(goal), "stop %d: goal (%d, %d) closer than %d cells to an obstacle",
+              stop, goal.x, goal.y, PLANNER_ROBOT_CELLS);
+        goals++;
+        robot = goal;
+    }
+
+    printf("%d batches of %d rays, %d goals: up to %d changed cells in a batch, over %d in %d batches and %d stops, "
+           "update %.1f us, coverage %.1f %%\n", batches, SAMPLES_PER_BATCH, goals, maxChanges, OLD_CHANGES_SIZE,
+           overflows, stopOverflows, 1e6*time/batches, 100*mod_frontier_getCoverage());
+    CHECK(goals > 1, "only %d goals", goals);
+    return host_result("test_frontier");
+}
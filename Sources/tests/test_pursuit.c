@@ -0,0 +1,212 @@
+/*
+ * File : test_pursuit.c
+ * Project : e_puck_project
+ * Description : Host simulation of mod_pursuit on a unicycle model, tracking of the paths and arrival
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "host.h"
+#include "mod_pursuit.h"
+#include "mod_motors.h"
+
+#define PERIOD              (1.0/PURSUIT_FREQUENCY)    // (in s)
+#define WHEEL_ACCELERATION  130.0   // Limit of the profile of mod_motors, 2000 step/s² (in mm/s²)
+#define MAX_DURATION        120     // A path not finished after this time is lost (in s)
+#define NUMBER_OF_PATHS     500
+#define MAX_TURN            (M_PI/2) // Turns of the random paths, the planner gives 45 and 90 deg ones
+#define MAX_CROSS_TRACK     25.0    // Max distance to the path, a 90 deg corner is cut by a third of the lookahead (in mm)
+#define MAX_ARRIVAL_ERROR   (PURSUIT_ARRIVAL_DISTANCE + 1.0)    // The pose given to the controller is rounded
+
+typedef struct {
+    double x;
+    double y;
+    double theta;
+    double left;        // Speed of the wheels (in mm/s)
+    double right;
+} robot_t;
+
+typedef struct {
+    double crossTrack;  // Max distance to the path (in mm)
+    double arrival;     // Distance to the end of the path when stopped (in mm)
+    double duration;    // (in s)
+    bool finished;
+} run_t;
+
+// The wheels of the model follow these orders with the acceleration of the steppers, as from mod_motion
+static wheelSpeed_t order;
+
+
+void mod_motors_changeStateWheelSpeedType(wheelSpeed_t wheelSpeed){
+    order = wheelSpeed;
+}
+
+
+void mod_motors_stop(void){
+    order = (wheelSpeed_t) {0, 0};
+}
+
+
+static double approach(double speed, double target){
+    double step = WHEEL_ACCELERATION*PERIOD;
+    if(target > speed + step) return speed + step;
+    if(target < speed - step) return speed - step;
+    return target;
+}
+
+
+/**
+ * @brief One tick of the unicycle, theta = 0 is the y axis as for the robot
+ */
+static void moveRobot(robot_t * robot){
+    robot->left = approach(robot->left, order.left);
+    robot->right = approach(robot->right, order.right);
+    double speed = (robot->left + robot->right)/2;
+    double rotation = (robot->right - robot->left)/(2*ROBOT_RADIUS);
+    double theta = robot->theta + rotation*PERIOD/2;
+    robot->x -= speed*PERIOD*sin(theta);
+    robot->y += speed*PERIOD*cos(theta);
+    robot->theta += rotation*PERIOD;
+}
+
+
+static double distanceToSegment(double x, double y, point_t start, point_t end){
+    double directionX = end.x - start.x;
+    double directionY = end.y - start.y;
+    double length = directionX*directionX + directionY*directionY;
+    double t = (length > 0) ? ((x - start.x)*directionX + (y - start.y)*directionY)/length : 0;
+    if(t < 0) t = 0;
+    if(t > 1) t = 1;
+    return hypot(x - start.x - t*directionX, y - start.y - t*directionY);
+}
+
+
+static double distanceToPath(double x, double y, point_t start, const point_t * path, int number){
+    double distance = distanceToSegment(x, y, start, path[0]);
+    for(int i = 1; i < number; i++){
+        double toSegment = distanceToSegment(x, y, path[i-1], path[i]);
+        if(toSegment < distance) distance = toSegment;
+    }
+    return distance;
+}
+
+
+/**
+ * @brief Run the controller as its thread does, the pose is the one of the model rounded to the mm
+ */
+static run_t follow(robot_t robot, const point_t * path, int number){
+    run_t run = {0, 0, 0, false};
+    point_t start = {lround(robot.x), lround(robot.y)};
+    int segment = 0;
+    order = (wheelSpeed_t) {0, 0};
+
+    for(int tick = 0; tick < MAX_DURATION*PURSUIT_FREQUENCY; tick++){
+        robotPosition_t position = {lround(robot.x), lround(robot.y), robot.theta};
+        wheelSpeed_t wheelSpeed;
+        if(mod_pursuit_computeWheelSpeed(position, path, number, &segment, &wheelSpeed)){
+            mod_motors_stop();
+            run.finished = true;
+            run.duration = tick*PERIOD;
+            break;
+        }
+        mod_motors_changeStateWheelSpeedType(wheelSpeed);
+        moveRobot(&robot);
+
+        double distance = distanceToPath(robot.x, robot.y, start, path, number);
+        if(distance > run.crossTrack) run.crossTrack = distance;
+    }
+
+    // The wheels ramp down after the stop order
+    while(robot.left != 0 || robot.right != 0) moveRobot(&robot);
+    run.arrival = hypot(robot.x - path[number-1].x, robot.y - path[number-1].y);
+    return run;
+}
+
+
+static void checkRun(const char * name, const run_t * run){
+    printf("  %-16s: %5.1f s, %4.1f mm from the path, stopped at %4.1f mm\n",
+           name, run->duration, run->crossTrack, run->arrival);
+    CHECK(run->finished, "%s: not finished", name);
+    CHECK(run->crossTrack < MAX_CROSS_TRACK, "%s: %.1f mm from the path", name, run->crossTrack);
+    CHECK(run->arrival < MAX_ARRIVAL_ERROR, "%s: stopped at %.1f mm", name, run->arrival);
+}
+
+
+static void testPaths(void){
+    robot_t robot = {500, 500, 0, 0, 0};
+    printf("Paths from (500, 500) heading +y:\n");
+
+    point_t straight[] = {{500, 900}};
+    run_t run = follow(robot, straight, 1);
+    checkRun("straight", &run);
+
+    // The goal behind the robot needs a rotation in place first
+    point_t behind[] = {{500, 300}};
+    run = follow(robot, behind, 1);
+    checkRun("behind", &run);
+
+    point_t corner[] = {{500, 700}, {700, 700}};
+    run = follow(robot, corner, 2);
+    checkRun("right angle", &run);
+
+    point_t zigzag[] = {{500, 600}, {600, 700}, {600, 800}, {500, 900}, {500, 1000}};
+    run = follow(robot, zigzag, 5);
+    checkRun("zigzag", &run);
+
+    // Points closer than the lookahead, as the cells of the planner
+    point_t cells[] = {{500, 540}, {540, 580}, {540, 620}, {580, 660}, {620, 660}, {660, 660}};
+    run = follow(robot, cells, 6);
+    checkRun("grid cells", &run);
+
+    point_t close[] = {{503, 502}};
+    run = follow(robot, close, 1);
+    checkRun("already there", &run);
+}
+
+
+/**
+ * @brief Random paths with turns of the planner, on segments of 60 to 300 mm
+ */
+static void testRandomPaths(void){
+    double worstCrossTrack = 0;
+    double worstArrival = 0;
+    double meanCrossTrack = 0;
+    int finished = 0;
+    int tracked = 0;
+    int arrived = 0;
+
+    for(int i = 0; i < NUMBER_OF_PATHS; i++){
+        robot_t robot = {0, 0, 0, 0, 0};
+        point_t path[PURSUIT_MAX_POINTS];
+        int number = 2 + (int)(host_random()*8);
+        double x = 0, y = 0, heading = M_PI/2;
+        for(int j = 0; j < number; j++){
+            if(j > 0) heading += (2*host_random() - 1)*MAX_TURN;
+            double length = 60 + host_random()*240;
+            x += length*cos(heading);
+            y += length*sin(heading);
+            path[j] = (point_t) {lround(x), lround(y)};
+        }
+
+        run_t run = follow(robot, path, number);
+        finished += run.finished;
+        tracked += run.crossTrack < MAX_CROSS_TRACK;
+        arrived += run.arrival < MAX_ARRIVAL_ERROR;
+        meanCrossTrack += run.crossTrack/NUMBER_OF_PATHS;
+        if(run.crossTrack > worstCrossTrack) worstCrossTrack = run.crossTrack;
+        if(run.arrival > worstArrival) worstArrival = run.arrival;
+    }
+
+    printf("%d random paths: %d finished, distance to the path %.1f mm (mean) %.1f mm (max), "
+           "stopped at %.1f mm (max)\n", NUMBER_OF_PATHS, finished, meanCrossTrack, worstCrossTrack, worstArrival);
+    CHECK(finished == NUMBER_OF_PATHS, "%d paths not finished", NUMBER_OF_PATHS - finished);
+    CHECK(tracked == NUMBER_OF_PATHS, "%d paths left by more than %.0f mm", NUMBER_OF_PATHS - tracked, MAX_CROSS_TRACK);
+    CHECK(arrived == NUMBER_OF_PATHS, "%d paths stopped too far from the end", NUMBER_OF_PATHS - arrived);
+}
+
+
+int main(void){
+    testPaths();
+    testRandomPaths();
+    return host_result("test_pursuit");
+}
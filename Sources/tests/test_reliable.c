@@ -0,0 +1,241 @@
+/*
+ * File : test_reliable.c
+ * Project : e_puck_project
+ * Description : Host loopback of mod_reliable with a receiver as the python one, on a link that loses and
+ *               reorders the chunks and the acknowledgements
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "host.h"
+#include "mod_reliable.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#define COM_CHUNK_SIZE          1024    // As in mod_communication.h
+#define TRANSFER_SIZE           38400   // A raw picture, 160x120 pixels of 2 bytes
+#define NUMBER_OF_CHUNKS        ((TRANSFER_SIZE + COM_CHUNK_SIZE - 1)/COM_CHUNK_SIZE)
+#define CHUNK_TIME              92      // Datagram of a chunk at 115200 baud, the sending thread waits for it (in ms)
+#define ACK_DELAY               20      // From the end of a chunk to the arrival of its acknowledgement (in ms)
+#define MAX_DURATION            60000   // A transfer not finished after this time is lost (in ms)
+#define NUMBER_OF_TRANSFERS     200
+#define MAX_EVENTS              256
+
+#define MAX_SLOWDOWN            3.0     // Mean duration against a link without loss, at 10 % of loss
+#define FAILURE_DURATION        ((RELIABLE_MAX_TIMEOUTS + 1)*RELIABLE_ACK_TIMEOUT)
+
+typedef enum{
+    EVENT_CHUNK = 0,            // Chunk arriving at the receiver
+    EVENT_ACK,                  // Acknowledgement arriving at the sender
+    EVENT_NACK
+}eventType_t;
+
+typedef struct{
+    uint32_t time;              // (in ms)
+    eventType_t type;
+    uint16_t transfer;
+    uint16_t value;             // The chunk, or the number of chunks received in a row
+}event_t;
+
+typedef struct{
+    float loss;                 // Probability to lose a message, in both directions
+    float reorder;              // Probability to delay a message after the next ones
+    uint32_t maxDelay;          // Delay of a reordered message (in ms)
+}link_t;
+
+typedef struct{
+    uint32_t duration;          // (in ms)
+    uint32_t retransmitted;
+    bool finished;
+    bool failed;
+    bool correct;               // The receiver has the datas of the transfer
+}run_t;
+
+// The receiver of pythonReception.py: cumulative acknowledgement, a lost chunk is asked once
+typedef struct{
+    uint16_t transfer;
+    bool chunks[NUMBER_OF_CHUNKS];
+    bool asked[NUMBER_OF_CHUNKS];
+    uint16_t received;
+    uint8_t datas[TRANSFER_SIZE];
+}receiver_t;
+
+static event_t events[MAX_EVENTS];
+static int numberOfEvents = 0;
+static uint8_t datas[TRANSFER_SIZE];
+static receiver_t receiver;
+
+
+static bool isLost(const link_t * link){
+    return host_random() < link->loss;
+}
+
+
+/**
+ * @brief Put a message on the link, it arrives after the delay unless it is lost or reordered
+ */
+static void postEvent(const link_t * link, uint32_t time, eventType_t type, uint16_t transfer, uint16_t value){
+    if(isLost(link) || numberOfEvents >= MAX_EVENTS) return;
+    if(host_random() < link->reorder) time += 1 + host_random()*link->maxDelay;
+    events[numberOfEvents++] = (event_t) {time, type, transfer, value};
+}
+
+
+/**
+ * @brief Takes the first event arrived before a time
+ *
+ * @param[out]      False if no event is arrived
+ */
+static bool takeEvent(uint32_t now, event_t * event){
+    int first = -1;
+    for(int i = 0; i < numberOfEvents; i++){
+        if(events[i].time <= now && (first < 0 || events[i].time < events[first].time)) first = i;
+    }
+    if(first < 0) return false;
+    *event = events[first];
+    events[first] = events[--numberOfEvents];
+    return true;
+}
+
+
+static void receiveChunk(const link_t * link, uint32_t now, uint16_t transfer, uint16_t chunk){
+    if(transfer != receiver.transfer){
+        memset(&receiver, 0, sizeof(receiver));
+        receiver.transfer = transfer;
+    }
+    size_t offset = chunk*COM_CHUNK_SIZE;
+    size_t size = (TRANSFER_SIZE - offset > COM_CHUNK_SIZE) ? COM_CHUNK_SIZE : TRANSFER_SIZE - offset;
+    memcpy(receiver.datas + offset, datas + offset, size);
+    receiver.chunks[chunk] = true;
+
+    while(receiver.received < NUMBER_OF_CHUNKS && receiver.chunks[receiver.received]) receiver.received++;
+    for(int lost = receiver.received; lost < chunk; lost++){
+        if(!receiver.chunks[lost] && !receiver.asked[lost]){
+            postEvent(link, now + ACK_DELAY, EVENT_NACK, transfer, lost);
+            receiver.asked[lost] = true;
+        }
+    }
+    postEvent(link, now + ACK_DELAY, EVENT_ACK, transfer, receiver.received);
+}
+
+
+/**
+ * @brief Run a transfer as the sending thread of mod_communication does
+ *
+ * @param[in] stale     Acknowledgements of the previous transfer still on the link
+ */
+static run_t runTransfer(const link_t * link, uint16_t transfer, bool stale){
+    reliableSender_t sender;
+    uint32_t now = 0;
+    numberOfEvents = 0;
+    for(int i = 0; i < TRANSFER_SIZE; i++) datas[i] = host_random()*256;
+    mod_reliable_start(&sender, transfer, TRANSFER_SIZE, COM_CHUNK_SIZE, now);
+    if(stale){
+        for(int i = 1; i <= NUMBER_OF_CHUNKS; i++){
+            events[numberOfEvents++] = (event_t) {i*CHUNK_TIME/2, EVENT_ACK, transfer - 1, i};
+            events[numberOfEvents++] = (event_t) {i*CHUNK_TIME/2, EVENT_NACK, transfer - 1, i - 1};
+        }
+    }
+
+    while(!mod_reliable_isFinished(&sender) && now < MAX_DURATION){
+        event_t event;
+        while(takeEvent(now, &event)){
+            if(event.type == EVENT_CHUNK) receiveChunk(link, event.time, event.transfer, event.value);
+            else if(event.type == EVENT_ACK) mod_reliable_acknowledge(&sender, event.transfer, event.value, now);
+            else mod_reliable_lost(&sender, event.transfer, event.value);
+        }
+        int chunk = mod_reliable_nextChunk(&sender, now);
+        if(chunk < 0){
+            now++;
+            continue;
+        }
+        // The thread waits for the end of the datagram
+        now += CHUNK_TIME;
+        postEvent(link, now, EVENT_CHUNK, transfer, chunk);
+    }
+
+    run_t run;
+    run.duration = now;
+    run.retransmitted = sender.retransmitted;
+    run.finished = mod_reliable_isFinished(&sender);
+    run.failed = sender.failed;
+    run.correct = receiver.transfer == transfer && receiver.received == NUMBER_OF_CHUNKS &&
+                  memcmp(receiver.datas, datas, TRANSFER_SIZE) == 0;
+    return run;
+}
+
+
+/**
+ * @brief Transfers on a link, prints their mean duration against the one of a perfect link
+ *
+ * @param[out]      The mean duration (in ms)
+ */
+static double testLink(const char * name, const link_t * link){
+    static uint16_t transfer = 0;
+    double duration = 0;
+    uint32_t retransmitted = 0;
+    int failed = 0, unfinished = 0, wrong = 0;
+
+    for(int i = 0; i < NUMBER_OF_TRANSFERS; i++){
+        run_t run = runTransfer(link, ++transfer, false);
+        duration += (double) run.duration/NUMBER_OF_TRANSFERS;
+        retransmitted += run.retransmitted;
+        failed += run.failed;
+        unfinished += !run.finished;
+        wrong += run.finished && !run.failed && !run.correct;
+    }
+
+    printf("  %-26s: %6.0f ms (mean), %5.2f chunks sent again per transfer, %d failed\n",
+           name, duration, (double) retransmitted/NUMBER_OF_TRANSFERS, failed);
+    CHECK(unfinished == 0, "%s: %d transfers never finished", name, unfinished);
+    CHECK(wrong == 0, "%s: %d transfers finished without all the datas at the receiver", name, wrong);
+    CHECK(failed == 0, "%s: %d transfers failed", name, failed);
+    return duration;
+}
+
+
+/**
+ * @brief Nothing arrives, the transfer must fail after the timeouts instead of waiting forever
+ */
+static void testDeadLink(void){
+    link_t link = {1.0f, 0, 0};
+    run_t run = runTransfer(&link, 1, false);
+    printf("Dead link: failed after %u ms\n", run.duration);
+    CHECK(run.failed, "no failure on a dead link");
+    CHECK(run.duration <= FAILURE_DURATION + CHUNK_TIME, "failure after %u ms", run.duration);
+}
+
+
+/**
+ * @brief Acknowledgements of the previous transfer arrive during a new one, they must be ignored
+ */
+static void testStaleAcknowledgements(void){
+    link_t link = {0, 0, 0};
+    run_t run = runTransfer(&link, 2, true);
+    CHECK(run.finished && !run.failed && run.correct, "transfer broken by the acknowledgements of the previous one");
+    CHECK(run.retransmitted == 0, "%u chunks sent again for the requests of the previous transfer",
+          run.retransmitted);
+}
+
+
+int main(void){
+    printf("Transfers of %d chunks, %d ms per chunk:\n", NUMBER_OF_CHUNKS, CHUNK_TIME);
+    link_t perfect = {0, 0, 0};
+    double ideal = testLink("no loss", &perfect);
+
+    link_t lossy = {0.01f, 0, 0};
+    testLink("1 % loss", &lossy);
+    lossy.loss = 0.1f;
+    double lost = testLink("10 % loss", &lossy);
+    CHECK(lost < MAX_SLOWDOWN*ideal, "10 %% loss: %.1f times slower", lost/ideal);
+
+    link_t reordering = {0, 0.1f, 3*CHUNK_TIME};
+    testLink("10 % reordered", &reordering);
+    reordering.loss = 0.05f;
+    testLink("5 % loss, 10 % reordered", &reordering);
+
+    testDeadLink();
+    testStaleAcknowledgements();
+    return host_result("test_reliable");
+}
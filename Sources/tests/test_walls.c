@@ -0,0 +1,189 @@
+/*
+ * File : test_walls.c
+ * Project : e_puck_project
+ * Description : Host test of the one pass walls estimator on simulated discovery sweeps
+ *
+ * MICRO-315 | École Polytechnique Fédérale de Lausanne
+ */
+
+#include "host.h"
+#include "mod_walls.h"
+
+#define NUMBER_OF_SWEEPS    2000
+#define ARENA_ORIGIN        100     // Corner of the arena, the walls do not pass through the origin (in mm)
+#define MAX_OBJECTS         3
+#define OBJECT_RADIUS       20      // (in mm)
+#define NOISE               6       // Amplitude of the TOF noise (in mm)
+#define LINE_TOLERANCE      10      // Max distance between a found line and the middle of its wall (in mm)
+#define ANGLE_TOLERANCE     (3*M_PI/180)
+#define MIN_VISIBLE_POINTS  5       // Walls hit by less points are not expected to be found
+#define MIN_SUCCESS_RATE    0.95f
+
+typedef struct {
+    float width;
+    float height;
+    float robotX;
+    float robotY;
+    int numberOfObjects;
+    float objectX[MAX_OBJECTS];
+    float objectY[MAX_OBJECTS];
+} sweep_t;
+
+
+/**
+ * @brief Distance along a ray to the first wall or object it hits, wall is -1 for an object
+ */
+static float castRay(const sweep_t * sweep, float directionX, float directionY, int * wall){
+    float nearest = 1e9f;
+    *wall = -1;
+    float walls[4] = {ARENA_ORIGIN, ARENA_ORIGIN + sweep->width, ARENA_ORIGIN, ARENA_ORIGIN + sweep->height};
+    for(int i = 0; i < 4; i++){
+        float direction = (i < 2) ? directionX : directionY;
+        float start = (i < 2) ? sweep->robotX : sweep->robotY;
+        if(fabsf(direction) < 1e-6f) continue;
+        float distance = (walls[i] - start)/direction;
+        if(distance > 0 && distance < nearest){
+            nearest = distance;
+            *wall = i;
+        }
+    }
+    for(int i = 0; i < sweep->numberOfObjects; i++){
+        float toX = sweep->objectX[i] - sweep->robotX;
+        float toY = sweep->objectY[i] - sweep->robotY;
+        float along = toX*directionX + toY*directionY;
+        float across = toX*directionY - toY*directionX;
+        if(along > 0 && fabsf(across) < OBJECT_RADIUS){
+            float distance = along - sqrtf(OBJECT_RADIUS*OBJECT_RADIUS - across*across);
+            if(distance < nearest){
+                nearest = distance;
+                *wall = -1;
+            }
+        }
+    }
+    return nearest;
+}
+
+
+/**
+ * @brief Returns true if a line is a wall, given by its middle and the angle of its normal
+ */
+static bool isWall(const line_t * line, float x, float y, float normal){
+    float angle = fmodf(fabsf(line->angle - normal), M_PI);
+    if(angle > M_PI/2) angle = M_PI - angle;
+    return angle < ANGLE_TOLERANCE && fabsf(x*cosf(line->angle) + y*sinf(line->angle) - line->distance) < LINE_TOLERANCE;
+}
+
+
+/**
+ * @brief Returns true if the four lines are the four walls
+ */
+static bool checkLines(const sweep_t * sweep, const line_t * lines){
+    float x0 = ARENA_ORIGIN, x1 = ARENA_ORIGIN + sweep->width;
+    float y0 = ARENA_ORIGIN, y1 = ARENA_ORIGIN + sweep->height;
+    float walls[4][3] = {{x0, (y0+y1)/2, 0}, {x1, (y0+y1)/2, 0}, {(x0+x1)/2, y0, M_PI/2}, {(x0+x1)/2, y1, M_PI/2}};
+    bool found[4] = {false, false, false, false};
+    for(int i = 0; i < 4; i++){
+        for(int wall = 0; wall < 4; wall++){
+            if(isWall(&lines[i], walls[wall][0], walls[wall][1], walls[wall][2])) found[wall] = true;
+        }
+    }
+    return found[0] && found[1] && found[2] && found[3];
+}
+
+
+/**
+ * @brief Sweep as the discovery does it, points are given one by one
+ *
+ * @param[out]      True if each wall was hit by enough points to be found
+ */
+static bool runSweep(const sweep_t * sweep, float startAngle, line_t * lines, int * numberOfLines){
+    int hits[4] = {0, 0, 0, 0};
+    mod_walls_reset();
+    for(int i = 0; i < NUMBER_OF_STEPS; i++){
+        float angle = startAngle + i*ANGLE_ELEMENT;
+        int wall;
+        float distance = castRay(sweep, cosf(angle), sinf(angle), &wall) + (2*host_random() - 1)*NOISE;
+        if(wall >= 0) hits[wall]++;
+        mod_walls_addPoint((point_t) {lroundf(sweep->robotX + distance*cosf(angle)), lroundf(sweep->robotY + distance*sinf(angle))});
+    }
+    CHECK(mod_walls_getNumberOfPoints() == NUMBER_OF_STEPS, "all the points are counted");
+    *numberOfLines = mod_walls_findLines(lines, WALLS_MAX_LINES);
+    return hits[0] >= MIN_VISIBLE_POINTS && hits[1] >= MIN_VISIBLE_POINTS
+        && hits[2] >= MIN_VISIBLE_POINTS && hits[3] >= MIN_VISIBLE_POINTS;
+}
+
+
+static void testFitMerge(void){
+    lineFit_t all, first, second;
+    mod_walls_fitReset(&all);
+    mod_walls_fitReset(&first);
+    mod_walls_fitReset(&second);
+    for(int i = 0; i < 20; i++){
+        point_t point = {300 + 3*i, 150 + 40*i + (i%3)};
+        mod_walls_fitAdd(&all, point);
+        mod_walls_fitAdd((i < 8) ? &first : &second, point);
+    }
+    mod_walls_fitMerge(&first, &second);
+    line_t merged = mod_walls_fitLine(&first);
+    line_t direct = mod_walls_fitLine(&all);
+    CHECK(merged.inliers == direct.inliers, "merged sums have %d points", merged.inliers);
+    CHECK(fabsf(merged.angle - direct.angle) < 1e-3f && fabsf(merged.distance - direct.distance) < 0.1f,
+          "merged line (%f, %f) instead of (%f, %f)", merged.angle, merged.distance, direct.angle, direct.distance);
+}
+
+
+static void testSweeps(void){
+    int successes = 0;
+    int visible = 0;
+    int successesVisible = 0;
+    int withObjects = 0;
+    int successesWithObjects = 0;
+    double time = 0;
+
+    for(int i = 0; i < NUMBER_OF_SWEEPS; i++){
+        sweep_t sweep;
+        sweep.width = 500 + host_random()*300;
+        sweep.height = sweep.width + host_random()*300;
+        sweep.robotX = ARENA_ORIGIN + sweep.width*(0.3f + 0.4f*host_random());
+        sweep.robotY = ARENA_ORIGIN + sweep.height*(0.3f + 0.4f*host_random());
+        sweep.numberOfObjects = (int)(host_random()*(MAX_OBJECTS+1));
+        for(int j = 0; j < sweep.numberOfObjects; j++){
+            // Objects stand between the robot and the walls, far from both
+            do{
+                sweep.objectX[j] = ARENA_ORIGIN + 60 + host_random()*(sweep.width - 120);
+                sweep.objectY[j] = ARENA_ORIGIN + 60 + host_random()*(sweep.height - 120);
+            }while(hypotf(sweep.objectX[j] - sweep.robotX, sweep.objectY[j] - sweep.robotY) < 100);
+        }
+
+        line_t lines[WALLS_MAX_LINES];
+        int number;
+        double start = host_now();
+        bool isVisible = runSweep(&sweep, host_random()*2*M_PI, lines, &number);
+        time += host_now() - start;
+
+        bool success = number == WALLS_MAX_LINES && checkLines(&sweep, lines);
+        successes += success;
+        if(!isVisible) continue;
+        visible++;
+        successesVisible += success;
+        if(sweep.numberOfObjects){
+            withObjects++;
+            successesWithObjects += success;
+        }
+    }
+
+    float rate = (float) successesVisible/visible;
+    float rateWithObjects = (float) successesWithObjects/withObjects;
+    printf("%d sweeps: %.1f %% found, %d with %d points on each wall: %.1f %% found (%.1f %% with objects), %.2f us per point\n",
+           NUMBER_OF_SWEEPS, 100.0f*successes/NUMBER_OF_SWEEPS, visible, MIN_VISIBLE_POINTS, 100*rate, 100*rateWithObjects,
+           1e6*time/(NUMBER_OF_SWEEPS*NUMBER_OF_STEPS));
+    CHECK(rate >= MIN_SUCCESS_RATE, "walls found in %.1f %% of the sweeps", 100*rate);
+    CHECK(rateWithObjects >= MIN_SUCCESS_RATE, "walls found in %.1f %% of the sweeps with objects", 100*rateWithObjects);
+}
+
+
+int main(void){
+    testFitMerge();
+    testSweeps();
+    return host_result("test_walls");
+}
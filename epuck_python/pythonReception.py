@@ -18,6 +18,11 @@ from threading import Thread
 import re
 from PIL import Image
 import math
+import msgpack
+import os
+from zlib import crc32
+
+#this script needs Python 3, pyserial, msgpack, matplotlib and pillow to run
 
 global pointRobot, collectionRobot
 
@@ -35,196 +40,361 @@ def update_plot():
         fig.canvas.draw_idle()
         reader_thd.plot_updated()
 
-#function used to update the plot of the cam data
+#function used to update the plot with the messages of the robot
 def update_cam_plot(port):
 
-    cam_data = readUint8Serial(port)
-    
-    if(len(cam_data)>0):
-        cam_plot.set_ydata(cam_data)
-        
-        graph_cam.relim()
-        graph_cam.autoscale()
-
-        reader_thd.tell_to_update_plot()
-
-
-#reads the data in uint8 from the serial
-def readUint8Serial(port):
-
-    state = 0
-    
-    
-
-    while(state != 5):
-
-        #reads 1 byte
-        c1 = port.read(1)
-        #timeout condition
-        if(c1 == b''):
-            return [];
+    message = readDatagram(port)
+
+    if(message is not None):
+        handleMessage(message, port)
+
+#types of the messages, same order as comMessage_t in mod_communication.h
+MSG_LOG = 0
+MSG_COMMAND = 1
+MSG_POSE = 2
+MSG_WALLS = 3
+MSG_OBJECT = 4
+MSG_SCAN = 5
+MSG_IMAGE = 6
+MSG_DATA = 7
+MSG_LOG_RECORDS = 8
+MSG_ACK = 9
+MSG_NACK = 10
+
+#size of the chunks of pictures and datas, same as COM_CHUNK_SIZE in mod_communication.h
+COM_CHUNK_SIZE = 1024
+
+#codecs of the pictures, same order as imageCodec_t in mod_compression.h
+CODEC_RAW = 0
+CODEC_LOSSLESS = 1
+CODEC_LOSSY = 2
+IMAGE_WIDTH = 80
+IMAGE_HEIGHT = 120
+
+SEND_MAP = 0
+SCAN_CLOSEST = 0
+
+#formats of the log records, the identifier of a format is its position in mod_log_formats.h
+def loadLogFormats():
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                        '..', 'Sources', 'modules', 'headers', 'mod_log_formats.h')
+    with open(path) as formatsFile:
+        return [bytes(text, 'utf-8').decode('unicode_escape')
+                for name, text in re.findall(r'^LOG_FORMAT\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)',
+                                             formatsFile.read(), re.MULTILINE)]
+
+logFormats = loadLogFormats()
+
+#prints the log records of a batch : [format, time, arguments...]
+def printLogRecords(records):
+    for record in records:
+        if(not isinstance(record, list) or len(record) < 2):
+            continue
+        formatID, time = record[0], record[1]
+        if(formatID >= len(logFormats)):
+            print("[{:8.3f}] Unknown format {} {}".format(time/1000, formatID, record[2:]))
+            continue
+        try:
+            text = logFormats[formatID] % tuple(record[2:])
+        except (TypeError, ValueError):
+            text = logFormats[formatID] + " " + str(record[2:])
+        print("[{:8.3f}] {}".format(time/1000, text))
 
-        if(state == 0):
-            if(c1 == b'S'):
-                state = 1
-            else:
-                state = 0
-        elif(state == 1):
-            if(c1 == b'T'):
-                state = 2
-            elif(c1 == b'S'):
-                state = 1
-            else:
-                state = 0
-        elif(state == 2):
-            if(c1 == b'A'):
-                state = 3
-            elif(c1 == b'S'):
-                state = 1
-            else:
-                state = 0
-        elif(state == 3):
-            if(c1 == b'R'):
-                state = 4
-            elif (c1 == b'S'):
-                state = 1
-            else:
-                state = 0
-        elif(state == 4):
-            if(c1 == b'T'):
-                state = 5
-            elif (c1 == b'S'):
-                state = 1
-            else:
-                state = 0
+#framing of serial_datagram : SLIP and a CRC32 at the end
+END = b'\xC0'
+ESC = b'\xDB'
+ESC_END = b'\xDC'
+ESC_ESC = b'\xDD'
 
-    total = 0
-    
-    while(1):
-        c = port.read(1)
-        if(c.decode("utf-8")  == '|'):
-            break
-        else:
-            if(ord(c.decode("utf-8")) == 32):
-                continue
-            elif(ord(c.decode("utf-8"))< 48 | ord(c.decode("utf-8"))>57):
-                return[]
-            total = total*10 + int(c.decode("utf-8"))
-    
-    state = 0
-
-    
-    if(port.read(1).decode("utf-8") != '|'):
-        return[]
-    
-    content = ''
+#reads a datagram from the serial and returns its MessagePack content as a list
+def readDatagram(port):
 
+    frame = b''
     while(1):
         c = port.read(1)
-        if(c.decode("utf-8") == '|'):
+        #timeout condition
+        if(c == b''):
+            return None
+        if(c == END):
             break
+        frame += c
+
+    frame = frame.replace(ESC + ESC_END, END)
+    frame = frame.replace(ESC + ESC_ESC, ESC)
+
+    #corrupted frames are dropped, the next one starts after the END byte
+    if(len(frame) < 5):
+        return None
+    if(struct.unpack('>I', frame[-4:])[0] != (crc32(frame[:-4]) & 0xffffffff)):
+        print('CRC mismatch, frame dropped')
+        return None
+
+    try:
+        message = msgpack.unpackb(frame[:-4], raw=False)
+    except Exception:
+        return None
+    if(not isinstance(message, list) or len(message) == 0):
+        return None
+    return message
+
+#sends a message to the robot in a datagram
+def sendDatagram(port, message):
+    frame = msgpack.packb(message)
+    frame += struct.pack('>I', crc32(frame) & 0xffffffff)
+    frame = frame.replace(ESC, ESC + ESC_ESC)
+    frame = frame.replace(END, ESC + ESC_END)
+    port.write(frame + END)
+
+#reassembles the chunks of a transfer and acknowledges them, see mod_reliable.h
+class ChunkReceiver:
+
+    def __init__(self):
+        self.reset(None, None)
+
+    def reset(self, transfer, header):
+        self.transfer = transfer
+        self.header = header
+        self.chunks = {}
+        self.received = 0
+        self.asked = set()
+        self.complete = False
+
+    #the link keeps the order, so another identifier is a new transfer. After a reset of the robot
+    #the identifiers count again from 1 (backwards), and the same identifier can come with other
+    #datas: the header (the fields sent before the chunk number) tells them apart
+    def isNew(self, transfer, header):
+        return transfer != self.transfer or header != self.header
+
+    #adds a chunk, returns the datas the first time the transfer is complete
+    def add(self, port, transfer, header, number, total, chunk):
+        header = (header, total)
+        if(self.isNew(transfer, header)):
+            self.reset(transfer, header)
+        numberOfChunks = (total + COM_CHUNK_SIZE - 1) // COM_CHUNK_SIZE
+        if(number >= numberOfChunks):
+            return None
+        self.chunks[number] = bytes(chunk)
+
+        #the number of chunks received in a row, and the lost chunks before this one
+        while(self.received in self.chunks):
+            self.received += 1
+        for lost in range(self.received, number):
+            if(lost not in self.chunks and lost not in self.asked):
+                sendDatagram(port, [MSG_NACK, transfer, lost])
+                self.asked.add(lost)
+        sendDatagram(port, [MSG_ACK, transfer, self.received])
+
+        if(self.complete or self.received < numberOfChunks):
+            return None
+        self.complete = True
+        return b''.join(self.chunks[i] for i in range(numberOfChunks))
+
+#plots the robot and its heading
+def plotPose(x, y, theta):
+    global collectionRobot
+    global pointRobot
+    pointRobot.remove()
+    collectionRobot.remove()
+    pointRobot, = graph_cam.plot(x, y, marker='s', linestyle='-', color='k')
+    lines = [[(x, y), (x + 100*math.cos(theta+math.pi/2), y + 100*math.sin(theta+math.pi/2))]]
+    lc = mc.LineCollection(lines, colors='r', linewidths=2)
+    collectionRobot = graph_cam.add_collection(lc)
+    reader_thd.tell_to_update_plot()
+
+#returns the channels of RGB565 pixels on 8 bits
+def rgb565ToRGB(pixels):
+    pixels = np.asarray(pixels, dtype=np.uint16)
+    red = (pixels >> 11) * 255 // 31
+    green = ((pixels >> 5) & 0x3F) * 255 // 63
+    blue = (pixels & 0x1F) * 255 // 31
+    return np.stack((red, green, blue), axis=-1).astype(np.uint8)
+
+#decodes the lossless codec, see compressLossless in mod_compression.c
+def decodeLossless(data):
+    pixels = []
+    cache = [0] * 64
+    previous = 0
+    i = 0
+    while(i < len(data) and len(pixels) < IMAGE_WIDTH * IMAGE_HEIGHT):
+        tag = data[i]
+        i += 1
+        red, green, blue = previous >> 11, (previous >> 5) & 0x3F, previous & 0x1F
+        if(tag == 0xFE):
+            pixel = data[i] << 8 | data[i + 1]
+            i += 2
+        elif(tag >= 0xC0):
+            pixels.extend([previous] * ((tag & 0x3F) + 1))
+            continue
+        elif(tag < 0x40):
+            pixel = cache[tag]
+        elif(tag < 0x80):
+            red = (red + ((tag >> 4) & 3) - 2) & 0x1F
+            green = (green + ((tag >> 2) & 3) - 2) & 0x3F
+            blue = (blue + (tag & 3) - 2) & 0x1F
+            pixel = red << 11 | green << 5 | blue
         else:
-           content = content + c.decode("utf-8")
-
-    if(port.read(1).decode("utf-8") != '|'):
-        return[]
+            dGreen = (tag & 0x3F) - 32
+            red = (red + dGreen + (data[i] >> 4) - 8) & 0x1F
+            green = (green + dGreen) & 0x3F
+            blue = (blue + dGreen + (data[i] & 0x0F) - 8) & 0x1F
+            i += 1
+            pixel = red << 11 | green << 5 | blue
+        cache[(3 * (pixel >> 11) + 5 * ((pixel >> 5) & 0x3F) + 7 * (pixel & 0x1F)) % 64] = pixel
+        pixels.append(pixel)
+        previous = pixel
+    if(len(pixels) != IMAGE_WIDTH * IMAGE_HEIGHT):
+        return None
+    return rgb565ToRGB(pixels).reshape(IMAGE_HEIGHT, IMAGE_WIDTH, 3)
+
+#tables of the lossy codec, same as mod_compression.c
+LUMA_BASE = [16, 11, 10, 16, 24, 40, 51, 61, 12, 12, 14, 19, 26, 58, 60, 55,
+             14, 13, 16, 24, 40, 57, 69, 56, 14, 17, 22, 29, 51, 87, 80, 62,
+             18, 22, 37, 56, 68, 109, 103, 77, 24, 35, 55, 64, 81, 104, 113, 92,
+             49, 64, 78, 87, 103, 121, 120, 101, 72, 92, 95, 98, 112, 100, 103, 99]
+CHROMA_BASE = [17, 18, 24, 47, 99, 99, 99, 99, 18, 21, 26, 66, 99, 99, 99, 99,
+               24, 26, 56, 99, 99, 99, 99, 99, 47, 66, 99, 99, 99, 99, 99, 99] + [99] * 32
+ZIGZAG = [0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+          12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+          35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+          58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63]
+DCT_TABLE = np.array([[(math.sqrt(1/8) if u == 0 else math.sqrt(2/8)) * math.cos((2*x + 1) * u * math.pi / 16)
+                       for x in range(8)] for u in range(8)])
+
+#reads Exp-Golomb codes, most significant bit first
+class BitReader:
+    def __init__(self, data):
+        self.bits = ''.join(format(byte, '08b') for byte in data)
+        self.position = 0
+
+    def readUnsigned(self):
+        zeros = 0
+        while(self.bits[self.position] == '0'):
+            zeros += 1
+            self.position += 1
+        code = int(self.bits[self.position:self.position + zeros + 1], 2)
+        self.position += zeros + 1
+        return code - 1
+
+    def readSigned(self):
+        value = self.readUnsigned()
+        return (value + 1) // 2 if value % 2 else -(value // 2)
+
+#decodes a plane of the lossy codec
+def decodePlane(reader, width, height, quant):
+    blocksX, blocksY = (width + 7) // 8, (height + 7) // 8
+    plane = np.zeros((blocksY * 8, blocksX * 8))
+    previousDC = 0
+    for blockY in range(blocksY):
+        for blockX in range(blocksX):
+            coefficients = np.zeros(64)
+            previousDC += reader.readSigned()
+            coefficients[0] = previousDC
+            i = 1
+            while(True):
+                zeros = reader.readUnsigned()
+                value = reader.readSigned()
+                if(value == 0):
+                    break
+                i += zeros
+                coefficients[ZIGZAG[i]] = value
+                i += 1
+            block = (coefficients * quant).reshape(8, 8)
+            plane[blockY*8:blockY*8 + 8, blockX*8:blockX*8 + 8] = DCT_TABLE.T @ block @ DCT_TABLE
+    return plane[:height, :width]
+
+#decodes the lossy codec, see compressLossy in mod_compression.c
+def decodeLossy(data):
+    quality = data[0]
+    scale = 5000 // quality if quality < 50 else 200 - 2 * quality
+    lumaQuant = np.clip([(base * scale + 50) // 100 for base in LUMA_BASE], 1, 255)
+    chromaQuant = np.clip([(base * scale + 50) // 100 for base in CHROMA_BASE], 1, 255)
+
+    reader = BitReader(data[1:])
+    try:
+        luma = decodePlane(reader, IMAGE_WIDTH, IMAGE_HEIGHT, lumaQuant) + 128
+        cb = decodePlane(reader, IMAGE_WIDTH // 2, IMAGE_HEIGHT // 2, chromaQuant)
+        cr = decodePlane(reader, IMAGE_WIDTH // 2, IMAGE_HEIGHT // 2, chromaQuant)
+    except (IndexError, ValueError):
+        return None
+    cb = cb.repeat(2, axis=0).repeat(2, axis=1)
+    cr = cr.repeat(2, axis=0).repeat(2, axis=1)
+    rgb = np.stack((luma + 1.402 * cr,
+                    luma - 0.344136 * cb - 0.714136 * cr,
+                    luma + 1.772 * cb), axis=-1)
+    return np.clip(np.round(rgb), 0, 255).astype(np.uint8)
+
+#decodes a complete picture, returns None if it is corrupted
+def decodeImage(codec, data):
+    if(codec == CODEC_RAW and len(data) == 2 * IMAGE_WIDTH * IMAGE_HEIGHT):
+        pixels = np.frombuffer(bytes(data), dtype='>u2')
+        return rgb565ToRGB(pixels).reshape(IMAGE_HEIGHT, IMAGE_WIDTH, 3)
+    elif(codec == CODEC_LOSSLESS):
+        return decodeLossless(data)
+    elif(codec == CODEC_LOSSY and len(data) > 0):
+        return decodeLossy(data)
+    return None
+
+#adds a chunk of a picture, the picture is shown when it is complete
+def addImageChunk(port, transfer, x, y, codec, number, total, chunk):
+    global imageID
+
+    if(bulkReceiver.isNew(transfer, ((x, y, codec), total))):
+        print("New object : x :", x, "y :", y)
+        graph_cam.plot(x, y, marker='s', linestyle='-', color='r')
+        graph_cam.annotate("Img " + str(imageID), xy=(x, y))
+        reader_thd.tell_to_update_plot()
 
-    toRead = total
-    rcv_buffer = b''
-    #reads the data
-    while(toRead > 0):
-        if(toRead > 4000):
-            rcv_buffer += port.read(4000)
-        else:
-            rcv_buffer += port.read(toRead)
-        toRead = total - len(rcv_buffer)
-
-    data = []
-
-
-    if("Message" in content):
-        if( "New point computed :" in rcv_buffer.decode("utf-8")):
-            pointsText = rcv_buffer.decode("utf-8").split(':')
-            #if(len(pointsText) == 4):
-                #print("Will plot: ", [int(pointsText[1])]," and: ", [int(pointsText[2])])
-                #graph_cam.plot(int(pointsText[1]), int(pointsText[2]), marker='s', linestyle='-', color='k')
-                #reader_thd.tell_to_update_plot()
-        elif( "PointInEnvironment:" in rcv_buffer.decode("utf-8")):
-            pointsText = rcv_buffer.decode("utf-8").split(':')
-            #if(len(pointsText) == 4):
-                #print("Will plot env: ", [int(pointsText[1])]," and: ", [int(pointsText[2])])
-                #graph_cam.plot(int(pointsText[1]), int(pointsText[2]), marker='s', linestyle='-', color='b')
-                #reader_thd.tell_to_update_plot()
-        elif( "PointClosest:" in rcv_buffer.decode("utf-8")):
-            pointsText = rcv_buffer.decode("utf-8").split(':')
-            # if(len(pointsText) == 4):
-                #print("Will plot close: ", [int(pointsText[1])]," and: ", [int(pointsText[2])])
-                #graph_cam.plot(int(pointsText[1]), int(pointsText[2]), marker='s', linestyle='-', color='g')
-                #reader_thd.tell_to_update_plot()
-        elif( "Walls" in rcv_buffer.decode("utf-8")):
-            pointsText = rcv_buffer.decode("utf-8").split(':')
-            if(len(pointsText) == 4):
-                print("Will plot: ", [int(pointsText[1])]," and: ", [int(pointsText[2])])
-                lines = [[(0, 0), (int(pointsText[1]), 0)],
-                          [(0, 0), (0, int(pointsText[2]))],
-                          [(int(pointsText[1]), 0), (int(pointsText[1]), int(pointsText[2]))],
-                          [(0, int(pointsText[2])), (int(pointsText[1]), int(pointsText[2]))]]
-                lc = mc.LineCollection(lines, colors='r', linewidths=2)
-                graph_cam.add_collection(lc)
-                reader_thd.tell_to_update_plot()
-        elif("New position:" in rcv_buffer.decode("utf-8")):
-            pointsText = rcv_buffer.decode("utf-8").split(':')
-            if(len(pointsText) == 5):
-                print("Will plot position: ", [int(pointsText[1])]," and: ", [int(pointsText[2])])
-                global collectionRobot
-                global pointRobot
-                pointRobot.remove()
-                collectionRobot.remove()
-                pointRobot, = graph_cam.plot(int(pointsText[1]), int(pointsText[2]), marker='s', linestyle='-', color='k')
-                lines = [[(int(pointsText[1]), int(pointsText[2])),
-                       (int(pointsText[1]) + 100*math.cos(float(pointsText[3])+math.pi/2), int(pointsText[2]) + 100*math.sin(float(pointsText[3])+math.pi/2))]]
-                lc = mc.LineCollection(lines, colors='r', linewidths=2)
-                collectionRobot = graph_cam.add_collection(lc)
-                reader_thd.tell_to_update_plot()
-        elif("send the map" in rcv_buffer.decode("utf-8")):
+    imageData = bulkReceiver.add(port, transfer, (x, y, codec), number, total, chunk)
+    if(imageData is None):
+        return
+    pixels = decodeImage(codec, imageData)
+    if(pixels is None):
+        print('Corrupted image dropped')
+        return
+    print('received !', total, 'bytes instead of', 2 * IMAGE_WIDTH * IMAGE_HEIGHT)
+    im = Image.fromarray(pixels, "RGB")
+    nameimg ="Image" + str(imageID) + "_x_" + str(x) + "_y_" + str(y)
+    im.show(title=nameimg)
+    im.save("/Users/nicolas/epuck/" + nameimg + ".png", "PNG")
+    imageID += 1
+
+#handles a message of the robot, the first element is its type
+def handleMessage(message, port):
+    kind = message[0]
+    fields = message[1:]
+
+    if(kind == MSG_LOG and len(fields) == 2):
+        print(fields[1])
+    elif(kind == MSG_COMMAND and len(fields) == 1):
+        if(fields[0] == SEND_MAP):
             print("Will save the map")
             graph_cam.savefig("/Users/nicolas/epuck/finalMap.png")
-        else:
-            print(rcv_buffer.decode("utf-8"))
-        return []
-    elif("Image" in content):
-        global imageID
-        x= 0
-        y= 0
-        sizeText = content.split(':')
-        if (len(sizeText) == 4):
-            x = int(sizeText[1])
-            y = int(sizeText[2])
-            print("New object : x :", x, "y :", y)
-            graph_cam.plot(x, y, marker='s', linestyle='-', color='r')
-            graph_cam.annotate("Img " + str(imageID), xy=(x, y))
-            reader_thd.tell_to_update_plot()
-        else:
-            print(content)
-            print("False lenght "+ str(len(sizeText)))
-            return []
-        #if we receive the good amount of data, we convert them in float32
-        if(len(rcv_buffer) == total):
-            new_buffer = bytearray(len(rcv_buffer))
-            new_buffer[0::2] = rcv_buffer[1::2]
-            new_buffer[1::2] = rcv_buffer[0::2]
-            im = Image.frombytes("RGB", (80, 120), bytes(new_buffer), "raw", "BGR;16")
-            nameimg ="Image" + str(imageID) + "_x_" + str(x) + "_y_" + str(y)
-            im.show(title=nameimg)
-            im.save("/Users/nicolas/epuck/Image" + str(imageID) + "_x_" + str(x) + "_y_" + str(y) + ".png", "PNG")
-            imageID += 1
-            
-            print('received !')
-            return []
-        else:
-            print('Timout...')
-            return []
-    return []
+    elif(kind == MSG_POSE and len(fields) == 3):
+        plotPose(fields[0], fields[1], fields[2])
+    elif(kind == MSG_WALLS and len(fields) >= 6 and len(fields) % 2 == 0):
+        #corners of the area in order, the walls can have any orientation
+        corners = list(zip(fields[0::2], fields[1::2]))
+        print("Will plot walls: ", corners)
+        lines = [[corners[i], corners[(i + 1) % len(corners)]] for i in range(len(corners))]
+        lc = mc.LineCollection(lines, colors='r', linewidths=2)
+        graph_cam.add_collection(lc)
+        reader_thd.tell_to_update_plot()
+    elif(kind == MSG_OBJECT and len(fields) == 2):
+        print("New object found: ", fields[0], ", ", fields[1])
+    elif(kind == MSG_SCAN and len(fields) == 3):
+        #scan points are not plotted, there are too many of them
+        pass
+    elif(kind == MSG_IMAGE and len(fields) == 7):
+        addImageChunk(port, *fields)
+    elif(kind == MSG_LOG_RECORDS):
+        printLogRecords(fields)
+    elif(kind == MSG_DATA and len(fields) == 5):
+        transfer, name, number, total, chunk = fields
+        datas = bulkReceiver.add(port, transfer, name, number, total, chunk)
+        if(datas is not None):
+            print("Received", len(datas), "bytes of", name)
+    else:
+        print("Unknown message", message)
 
 #thread used to control the communication part
 class serial_thread(Thread):
@@ -311,6 +481,7 @@ axes.set_ylim([-20,800])
 plt.ylabel("y")
 plt.xlabel("x")
 imageID = 0
+bulkReceiver = ChunkReceiver()
 pointRobot, = graph_cam.plot(0, 0, marker='s', linestyle='-', color='k')
 lines3 = [[(0,0),(0 ,0)]]
 lc3 = mc.LineCollection(lines3, colors='r', linewidths=2)